@@ -4,6 +4,8 @@
 #include "layers/SoftMax.h"
 #include <Ritsu.h>
 #include <benchmark/benchmark.h>
+#include <memory>
+#include <thread>
 
 static void BM_MathProduct(benchmark::State &state) {
 	// Perform setup here
@@ -15,14 +17,75 @@ static void BM_MathProduct(benchmark::State &state) {
 	assert(sum == 4096);
 }
 
+/*	Set the number of threads of the benchmark argument, returning the previous number. Without
+ *	OpenMP, or built with RITSU_THREAD_POOL, the kernels run on a pool of that many threads.	*/
+static int setBenchmarkThreads(benchmark::State &state) {
+	if (Ritsu::CpuDispatch::getThreadPool() != nullptr) {
+		Ritsu::CpuDispatch::setThreadPool(std::make_shared<Ritsu::ThreadPool>(static_cast<unsigned int>(state.range(1))));
+		return 0;
+	}
+#ifdef _OPENMP
+	const int nrThreads = omp_get_max_threads();
+	omp_set_num_threads(static_cast<int>(state.range(1)));
+	return nrThreads;
+#else
+	return 1;
+#endif
+}
+
+static void restoreBenchmarkThreads(const int nrThreads) {
+	if (Ritsu::CpuDispatch::getThreadPool() != nullptr) {
+		Ritsu::CpuDispatch::setThreadPool(nullptr);
+		return;
+	}
+#ifdef _OPENMP
+	omp_set_num_threads(nrThreads);
+#endif
+}
+
+/*	Number of elements from 4K to 64M, times 1, 2, 4... up to the number of processors threads.	*/
+static void ReductionArguments(benchmark::internal::Benchmark *benchmark) {
+	const int nrProcessors = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+	for (const int64_t nrElements : {1 << 12, 1 << 16, 1 << 20, 1 << 24, 1 << 26}) {
+		for (int threads = 1; threads <= nrProcessors; threads *= 2) {
+			benchmark->Args({nrElements, threads});
+		}
+	}
+	benchmark->ArgNames({"elements", "threads"});
+}
+
 static void BM_MathSum(benchmark::State &state) {
-	// Perform setup here
-	std::vector<float> x(4096, 1);
-	volatile auto sum = 0.0f;
+	std::vector<float> x(static_cast<size_t>(state.range(0)), 1);
+	const int nrThreads = setBenchmarkThreads(state);
+
+	float sum = 0;
 	for (auto _ : state) {
 		sum = Ritsu::Math::sum(x);
+		benchmark::DoNotOptimize(sum);
 	}
-	assert(sum == 1);
+	/*	Exact, the partial sums of the blocks are small integers and their sums multiples of the block size.	*/
+	assert(sum == static_cast<float>(x.size()));
+
+	restoreBenchmarkThreads(nrThreads);
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0) * sizeof(float));
+}
+
+static void BM_MathMeanVariance(benchmark::State &state) {
+	std::vector<float> x(static_cast<size_t>(state.range(0)));
+	for (size_t i = 0; i < x.size(); i++) {
+		x[i] = static_cast<float>(i % 17);
+	}
+	const int nrThreads = setBenchmarkThreads(state);
+
+	for (auto _ : state) {
+		float mean, variance;
+		Ritsu::Math::meanVariance<float>(x, mean, variance);
+		benchmark::DoNotOptimize(mean);
+		benchmark::DoNotOptimize(variance);
+	}
+
+	restoreBenchmarkThreads(nrThreads);
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0) * sizeof(float));
 }
 
 static void BM_MathRelu(benchmark::State &state) {
@@ -43,11 +106,7 @@ static void BM_MathSigmoid(benchmark::State &state) {
 	std::vector<float> x(512 * 512, 1);
 	volatile auto sum = 0.0f;
 	for (auto _ : state) {
-		unsigned int index;
-#pragma omp simd
-		for (index = 0; index < x.size(); index++) {
-			x[index] = Ritsu::computeSigmoid(x[index]);
-		}
+		Ritsu::computeSigmoid<float>(x.data(), x.size());
 	}
 }
 
@@ -62,6 +121,18 @@ static void BM_TensorSum(benchmark::State &state) {
 	assert(sum == 64 * 64);
 }
 
+/*	Batch of 256 rows of 1024, along the batch axis (0) and along the rows (1).	*/
+static void BM_TensorSumAxis(benchmark::State &state) {
+	const int axis = static_cast<int>(state.range(0));
+	Ritsu::Tensor<float> tensor(Ritsu::Shape<uint32_t>({256, 1024}));
+	tensor.assignInitValue(1);
+
+	for (auto _ : state) {
+		Ritsu::Tensor<float> result = Ritsu::Tensor<float>::sum(tensor, axis);
+		benchmark::DoNotOptimize(result.getRawData());
+	}
+}
+
 static void BM_TensorDot(benchmark::State &state) {
 	// Perform setup here
 	Ritsu::Tensor<float> tensor({64, 64}, sizeof(float));
@@ -94,17 +165,87 @@ static void BM_TensorAddition(benchmark::State &state) {
 	}
 }
 
+static void BM_TensorTemporary(benchmark::State &state) {
+	/*	0: recycling pool, 1: direct aligned allocation.	*/
+	Ritsu::AlignedAllocator direct;
+	if (state.range(0) == 1) {
+		Ritsu::MemoryAllocator::setDefault(&direct);
+	}
+
+	Ritsu::Tensor<float> tensorA(Ritsu::Shape<uint32_t>({64, 64}));
+	Ritsu::Tensor<float> tensorB(Ritsu::Shape<uint32_t>({64, 64}));
+	tensorA.assignInitValue(1);
+	tensorB.assignInitValue(1);
+
+	for (auto _ : state) {
+		Ritsu::Tensor<float> result = tensorA + tensorB;
+		benchmark::DoNotOptimize(result.getRawData());
+	}
+
+	Ritsu::MemoryAllocator::setDefault(nullptr);
+}
+
 static void BM_TensorMulti(benchmark::State &state) {
 	// Perform setup here
-	Ritsu::Tensor<float> tensorA(Ritsu::Shape<uint32_t>({128, 128}));
-	Ritsu::Tensor<float> tensorB(Ritsu::Shape<uint32_t>({128, 128}));
-	Ritsu::Tensor<float> result;
+	const uint32_t size = static_cast<uint32_t>(state.range(0));
+	Ritsu::Tensor<float> tensorA(Ritsu::Shape<uint32_t>({size, size}));
+	Ritsu::Tensor<float> tensorB(Ritsu::Shape<uint32_t>({size, size}));
+	Ritsu::Tensor<float> result(Ritsu::Shape<uint32_t>({size, size}));
+
+	tensorA.assignInitValue(1.0f);
+	tensorB.assignInitValue(0.5f);
 
 	/*  */
 	for (auto _ : state) {
-		result = Ritsu::Tensor<float>::matrixMultiply(tensorA, tensorB);
+		Ritsu::Tensor<float>::matrixMultiply(tensorA, tensorB, result);
+		benchmark::DoNotOptimize(result.getRawData<float>());
+	}
+
+	/*	Two floating point operations per multiply-add.	*/
+	const double flops = 2.0 * static_cast<double>(size) * size * size;
+	state.counters["FLOPS"] =
+		benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate, benchmark::Counter::OneK::kIs1000);
+}
+
+static void BM_TensorBatchMulti(benchmark::State &state) {
+	// Perform setup here
+	const uint32_t batch = static_cast<uint32_t>(state.range(0));
+	Ritsu::Tensor<float> tensorA(Ritsu::Shape<uint32_t>({batch, 64, 256}));
+	Ritsu::Tensor<float> tensorB(Ritsu::Shape<uint32_t>({256, 128}));
+	Ritsu::Tensor<float> result(Ritsu::Shape<uint32_t>({batch, 64, 128}));
+
+	tensorA.assignInitValue(1.0f);
+	tensorB.assignInitValue(0.5f);
+
+	/*	Weight broadcast over the batch.	*/
+	for (auto _ : state) {
+		Ritsu::Tensor<float>::matrixMultiply(tensorA, tensorB, result);
+		benchmark::DoNotOptimize(result.getRawData<float>());
+	}
+
+	const double flops = 2.0 * batch * 64.0 * 128.0 * 256.0;
+	state.counters["FLOPS"] =
+		benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate, benchmark::Counter::OneK::kIs1000);
+}
+
+static void BM_TensorViewTransposeMulti(benchmark::State &state) {
+	/*	0: strided view passed to the GEMM, 1: transpose materialized first.	*/
+	Ritsu::Tensor<float> tensorA(Ritsu::Shape<uint32_t>({256, 256}));
+	Ritsu::Tensor<float> tensorB(Ritsu::Shape<uint32_t>({256, 256}));
+	Ritsu::Tensor<float> result(Ritsu::Shape<uint32_t>({256, 256}));
+
+	tensorA.assignInitValue(1.0f);
+	tensorB.assignInitValue(0.5f);
+
+	for (auto _ : state) {
+		const Ritsu::TensorView<float> transposed = Ritsu::TensorView<float>(tensorA).transpose();
+		if (state.range(0) == 0) {
+			Ritsu::TensorView<float>::matrixMultiply(transposed, tensorB, result);
+		} else {
+			Ritsu::TensorView<float>::matrixMultiply(transposed.contiguous(), tensorB, result);
+		}
+		benchmark::DoNotOptimize(result.getRawData<float>());
 	}
-	result.flatten();
 }
 
 static void BM_TensorAXPY(benchmark::State &state) {
@@ -121,6 +262,157 @@ static void BM_TensorAXPY(benchmark::State &state) {
 	result.flatten();
 }
 
+static void BM_TensorAXPYLazy(benchmark::State &state) {
+	Ritsu::Tensor<float> tensorA(Ritsu::Shape<uint32_t>({128, 128, 1}));
+	Ritsu::Tensor<float> tensorB(Ritsu::Shape<uint32_t>({128, 128, 1}));
+	const float value = static_cast<float>(rand() % 100);
+	Ritsu::Tensor<float> result(Ritsu::Shape<uint32_t>({128, 128, 1}));
+
+	tensorA.assignInitValue(1.0f);
+	tensorB.assignInitValue(1.0f);
+
+	/*	Single fused pass, no temporary.	*/
+	for (auto _ : state) {
+		result = Ritsu::lazy(tensorA) * value + tensorB;
+		benchmark::DoNotOptimize(result.getRawData());
+	}
+}
+
+static void BM_TensorBroadcastRow(benchmark::State &state) {
+	Ritsu::Tensor<float> tensorA(Ritsu::Shape<uint32_t>({256, 256}));
+	Ritsu::Tensor<float> row(Ritsu::Shape<uint32_t>({256}));
+
+	tensorA.assignInitValue(1.0f);
+	row.assignInitValue(0.5f);
+
+	/*	Row added to each of the rows, without materializing the row.	*/
+	for (auto _ : state) {
+		tensorA += row;
+		benchmark::DoNotOptimize(tensorA.getRawData());
+	}
+}
+
+/*	Bias sized tensors, dominated by the dispatch rather than the arithmetic.	*/
+static void BM_TensorSmallAddition(benchmark::State &state) {
+	const uint32_t nrElements = static_cast<uint32_t>(state.range(0));
+	Ritsu::Tensor<float> tensorA(Ritsu::Shape<uint32_t>({nrElements}));
+	Ritsu::Tensor<float> bias(Ritsu::Shape<uint32_t>({nrElements}));
+
+	tensorA.assignInitValue(1.0f);
+	bias.assignInitValue(0.5f);
+
+	for (auto _ : state) {
+		tensorA += bias;
+		benchmark::DoNotOptimize(tensorA.getRawData());
+	}
+}
+
+static void BM_TensorAccessScale(benchmark::State &state) {
+	/*	0: per element getValue, 1: typed span.	*/
+	Ritsu::Tensor<float> tensor(Ritsu::Shape<uint32_t>({512, 512}));
+	tensor.assignInitValue(1.0f);
+	const float value = 1.0001f;
+
+	for (auto _ : state) {
+		if (state.range(0) == 0) {
+			for (size_t i = 0; i < tensor.getNrElements(); i++) {
+				tensor.getValue(i) = tensor.getValue(i) * value;
+			}
+		} else {
+			const Ritsu::TensorSpan<float> data = tensor.span();
+			for (size_t i = 0; i < data.size(); i++) {
+				data[i] = data[i] * value;
+			}
+		}
+		benchmark::DoNotOptimize(tensor.getRawData());
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * tensor.getDatSize());
+}
+
+static void BM_TensorAccessCast(benchmark::State &state) {
+	/*	0: per element getValue, 1: typed spans, as Tensor::cast.	*/
+	Ritsu::Tensor<float> tensor(Ritsu::Shape<uint32_t>({512, 512}));
+	Ritsu::Tensor<double> result(Ritsu::Shape<uint32_t>({512, 512}));
+	tensor.assignInitValue(1.0f);
+
+	for (auto _ : state) {
+		if (state.range(0) == 0) {
+			for (size_t i = 0; i < tensor.getNrElements(); i++) {
+				result.getValue(i) = static_cast<double>(tensor.getValue(i));
+			}
+		} else {
+			const Ritsu::TensorSpan<const float> source = static_cast<const Ritsu::Tensor<float> &>(tensor).span();
+			const Ritsu::TensorSpan<double, 32> dest = result.alignedSpan();
+			for (size_t i = 0; i < source.size(); i++) {
+				dest[i] = static_cast<double>(source[i]);
+			}
+		}
+		benchmark::DoNotOptimize(result.getRawData());
+	}
+}
+
+/*	Force the CPU tier of the benchmark argument, false if the processor does not support it.	*/
+static bool setBenchmarkTier(benchmark::State &state) {
+	const Ritsu::CpuTier tier = static_cast<Ritsu::CpuTier>(state.range(0));
+	if (!Ritsu::CpuDispatch::isSupported(tier)) {
+		state.SkipWithError("CPU tier not supported");
+		return false;
+	}
+	Ritsu::CpuDispatch::setTier(tier);
+	state.SetLabel(Ritsu::CpuDispatch::getTierName(tier));
+	return true;
+}
+
+static void BM_CpuTierSum(benchmark::State &state) {
+	if (!setBenchmarkTier(state)) {
+		return;
+	}
+	std::vector<float> x(1 << 16, 1);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Ritsu::Math::sum<float>(x.data(), x.size()));
+	}
+	Ritsu::CpuDispatch::resetTier();
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * x.size() * sizeof(float));
+}
+
+static void BM_CpuTierAXPY(benchmark::State &state) {
+	if (!setBenchmarkTier(state)) {
+		return;
+	}
+	Ritsu::Tensor<float> tensorX(Ritsu::Shape<uint32_t>({512, 512}));
+	Ritsu::Tensor<float> tensorY(Ritsu::Shape<uint32_t>({512, 512}));
+	tensorX.assignInitValue(1.0f);
+	tensorY.assignInitValue(2.0f);
+
+	for (auto _ : state) {
+		tensorY = Ritsu::lazy(tensorX) * 0.5f + tensorY;
+		benchmark::DoNotOptimize(tensorY.getRawData());
+	}
+	Ritsu::CpuDispatch::resetTier();
+}
+
+static void BM_CpuTierMulti(benchmark::State &state) {
+	if (!setBenchmarkTier(state)) {
+		return;
+	}
+	const uint32_t size = 512;
+	Ritsu::Tensor<float> tensorA(Ritsu::Shape<uint32_t>({size, size}));
+	Ritsu::Tensor<float> tensorB(Ritsu::Shape<uint32_t>({size, size}));
+	Ritsu::Tensor<float> result(Ritsu::Shape<uint32_t>({size, size}));
+	tensorA.assignInitValue(1.0f);
+	tensorB.assignInitValue(0.5f);
+
+	for (auto _ : state) {
+		Ritsu::Tensor<float>::matrixMultiply(tensorA, tensorB, result);
+		benchmark::DoNotOptimize(result.getRawData<float>());
+	}
+	Ritsu::CpuDispatch::resetTier();
+
+	const double flops = 2.0 * static_cast<double>(size) * size * size;
+	state.counters["FLOPS"] =
+		benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate, benchmark::Counter::OneK::kIs1000);
+}
+
 static void BM_LayerRelu(benchmark::State &state) {
 	// Perform setup here
 	Ritsu::Tensor<float> tensorA(Ritsu::Shape<uint32_t>({512, 512, 1}));
@@ -159,6 +451,98 @@ static void BM_LayerSoftMax(benchmark::State &state) {
 	result.flatten();
 }
 
+/*	Argument is the product, forward, backward or the gradients, and if the weights change every iteration,
+ *	as when training, which packs them again each time.	*/
+static void BM_LayerDense(benchmark::State &state) {
+	const int64_t product = state.range(0);
+	const bool updated = state.range(1) != 0;
+	const uint32_t batchSize = 64;
+
+	Ritsu::Input input({784});
+	Ritsu::Dense dense(128);
+	dense(input).build(input.getShape());
+
+	Ritsu::RandomUniformInitializer<float> random(-1, 1, 10052);
+	const Ritsu::Tensor<float> batch = random(Ritsu::Shape<uint32_t>({batchSize, 784}));
+	const Ritsu::Tensor<float> error = random(Ritsu::Shape<uint32_t>({128, batchSize}));
+	const Ritsu::Tensor<float> inputTransposed = random(Ritsu::Shape<uint32_t>({784, batchSize}));
+	Ritsu::Tensor<float> result;
+
+	for (auto _ : state) {
+		if (updated) {
+			dense.weights_updated();
+		}
+		if (product == 2) {
+			benchmark::DoNotOptimize(dense.accumulate_gradients(error, inputTransposed, 1.0f / batchSize, false));
+			continue;
+		}
+		if (product == 1) {
+			result = dense.compute_derivative(error);
+		} else {
+			dense.callBatch(batch, result, false);
+		}
+		benchmark::DoNotOptimize(result.getRawData());
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * batchSize);
+}
+
+/*	Threads pinned streaming over weights placed by each NUMA policy. Compare on a host with two
+ *	nodes, or one emulated by booting with numa=fake=2, e.g.
+ *	numactl --cpunodebind=0,1 --preferred=0 ritsu-benchmark-test --benchmark_filter=BM_NumaWeights
+ *	where --preferred=0 has the default policy place the weights on a single node.	*/
+static void BM_NumaWeights(benchmark::State &state) {
+	const Ritsu::RuntimeConfig previous = Ritsu::RuntimeConfig::getCurrent();
+	Ritsu::RuntimeConfig config = previous;
+	config.pinThreads = true;
+	config.weightPolicy = static_cast<Ritsu::NumaPolicy>(state.range(0));
+	Ritsu::RuntimeConfig::apply(config);
+
+	/*	Larger than the pooled blocks, thus new pages on each run.	*/
+	Ritsu::Tensor<float> weights(Ritsu::Shape<uint32_t>({4096, 4096}));
+	Ritsu::ZeroInitializer<float> initializer;
+	initializer(weights);
+	const float *data = weights.getRawData<float>();
+
+	for (auto _ : state) {
+		float sum = Ritsu::Math::sum<float>(data, weights.getNrElements());
+		benchmark::DoNotOptimize(sum);
+	}
+
+	Ritsu::RuntimeConfig::apply(previous);
+	state.SetLabel(Ritsu::RuntimeConfig::getNumaPolicyName(config.weightPolicy));
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * weights.getDatSize());
+}
+
+/*	Inference of the dense layers of the MNIST example, Dense -> Relu chains, with and without the
+ *	activations fused into the products.	*/
+static void BM_ModelMnistFusion(benchmark::State &state) {
+	const unsigned int batchSize = static_cast<unsigned int>(state.range(1));
+
+	Ritsu::Input input({28 * 28}, "input");
+	Ritsu::Dense fw0(32);
+	Ritsu::Relu relu0;
+	Ritsu::Dense fw1(16);
+	Ritsu::Relu relu1;
+	Ritsu::Dense fw2(10);
+	Ritsu::Sigmoid sigmoid;
+
+	Ritsu::Layer<float> &output = sigmoid(fw2(relu1(fw1(relu0(fw0(input))))));
+	Ritsu::Model<float> model({&input}, {&output});
+	model.setLayerFusion(state.range(0) != 0);
+
+	Ritsu::RandomUniformInitializer<float> random(0, 1, 10052);
+	const Ritsu::Tensor<float> batch = random(Ritsu::Shape<uint32_t>({batchSize, 28 * 28}));
+	model.plan(batchSize, false);
+
+	for (auto _ : state) {
+		const Ritsu::Tensor<float> &result = model.predictOnBatch(batch);
+		benchmark::DoNotOptimize(result.getRawData());
+	}
+
+	state.SetLabel(state.range(0) != 0 ? "fused" : "unfused");
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * batchSize);
+}
+
 static void BM_ModelAddition(benchmark::State &state) {
 	for (auto _ : state) {
 		//	result = relu(tensorA);
@@ -167,24 +551,42 @@ static void BM_ModelAddition(benchmark::State &state) {
 
 /*  Register the function as a benchmark    */
 BENCHMARK(BM_MathProduct);
-BENCHMARK(BM_MathSum);
+BENCHMARK(BM_MathSum)->Apply(ReductionArguments)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MathMeanVariance)->Apply(ReductionArguments)->Unit(benchmark::kMicrosecond);
 BENCHMARK(BM_MathRelu);
 BENCHMARK(BM_MathSigmoid);
+BENCHMARK(BM_NumaWeights)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMicrosecond);
 
 /*	*/
 BENCHMARK(BM_TensorSum);
+BENCHMARK(BM_TensorSumAxis)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
 BENCHMARK(BM_TensorDot);
-BENCHMARK(BM_TensorMulti);
+BENCHMARK(BM_TensorMulti)->RangeMultiplier(2)->Range(64, 1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TensorBatchMulti)->RangeMultiplier(4)->Range(1, 64)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TensorViewTransposeMulti)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
 BENCHMARK(BM_TensorAXPY);
+BENCHMARK(BM_TensorAXPYLazy);
+BENCHMARK(BM_TensorBroadcastRow);
+BENCHMARK(BM_TensorSmallAddition)->Arg(10)->Arg(256)->Arg(4096);
 BENCHMARK(BM_TensorAddition);
+BENCHMARK(BM_TensorTemporary)->Arg(0)->Arg(1);
+BENCHMARK(BM_TensorAccessScale)->Arg(0)->Arg(1);
+BENCHMARK(BM_TensorAccessCast)->Arg(0)->Arg(1);
+
+/*	Argument is the CpuTier, unsupported tiers are skipped.	*/
+BENCHMARK(BM_CpuTierSum)->DenseRange(0, 4);
+BENCHMARK(BM_CpuTierAXPY)->DenseRange(0, 4)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CpuTierMulti)->DenseRange(0, 4)->Unit(benchmark::kMicrosecond);
 
 /*	*/
 BENCHMARK(BM_LayerRelu);
 BENCHMARK(BM_LayerSigmoid);
 BENCHMARK(BM_LayerSoftMax);
+BENCHMARK(BM_LayerDense)->ArgsProduct({{0, 1, 2}, {0, 1}})->Unit(benchmark::kMicrosecond);
 
 /*	*/
 BENCHMARK(BM_ModelAddition);
+BENCHMARK(BM_ModelMnistFusion)->ArgsProduct({{0, 1}, {1, 64, 256}})->Unit(benchmark::kMicrosecond);
 
 /* Run the benchmark    */
 BENCHMARK_MAIN();
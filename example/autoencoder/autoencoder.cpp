@@ -49,11 +49,12 @@ int main(int argc, const char **argv) {
 		const float useRegulation = result["regulation"].as<float>();
 		const int threads = result["threads"].as<int>();
 
-		if (threads == -1) {
-			omp_set_num_threads(omp_get_num_procs());
-		} else {
-			omp_set_num_threads(threads);
+		/*	Threads, pinning and NUMA placement of the environment, unless given on the command line.	*/
+		RuntimeConfig config = RuntimeConfig::fromEnvironment();
+		if (threads > 0) {
+			config.nrThreads = static_cast<unsigned int>(threads);
 		}
+		RuntimeConfig::apply(config);
 
 		if (debug) {
 			/*	*/
@@ -25,6 +25,7 @@ int main(int argc, const char **argv) {
 	cxxopts::OptionAdder &addr = options.add_options("Addition")("h,help", "helper information.")(
 		"d,debug", "Enable Debugging", cxxopts::value<bool>()->default_value("false"))(
 		"B,batch", "Set the Batch Size", cxxopts::value<int>()->default_value("1"))(
+		"A,accumulation-steps", "Set number of batches per optimizer step", cxxopts::value<int>()->default_value("1"))(
 		"N,use-noise", "Enable the use of noise", cxxopts::value<bool>()->default_value("false"))(
 		"E,epoch", "Set the number of epochs", cxxopts::value<int>()->default_value("8"))(
 		"b,use-bias", "Use Dense Bias", cxxopts::value<bool>()->default_value("true"))(
@@ -38,6 +39,7 @@ int main(int argc, const char **argv) {
 		"s,use-sigmoid", " ", cxxopts::value<bool>()->default_value("false"))(
 		"L,loss-funciton", " ", cxxopts::value<std::string>()->default_value("mse"))(
 		"r,regulation", " ", cxxopts::value<float>()->default_value("0.00000"))(
+		"F,no-fusion", "Compute every layer on its own", cxxopts::value<bool>()->default_value("false"))(
 		"t,threads", "Set number of threads (Core) to use", cxxopts::value<int>()->default_value("-1"));
 
 	/*	Parse the command line input.	*/
@@ -46,6 +48,7 @@ int main(int argc, const char **argv) {
 	/*	*/
 	const bool debug = result["debug"].as<bool>();
 	const unsigned int batchSize = result["batch"].as<int>();
+	const unsigned int accumulationSteps = result["accumulation-steps"].as<int>();
 	const unsigned int epochs = result["epoch"].as<int>();
 	const float learningRate = result["learning-rate"].as<float>();
 	const bool useBatchNorm = false;
@@ -57,15 +60,17 @@ int main(int argc, const char **argv) {
 	const float momentum = result["optimizer-momentum"].as<float>();
 	const float useRegulation = result["regulation"].as<float>();
 	const int threads = result["threads"].as<int>();
+	const bool layerFusion = !result["no-fusion"].as<bool>();
 
 	const std::string use_optimizer = result["optimizer"].as<std::string>();
 	const std::string use_loss_function = result["loss-funciton"].as<std::string>();
 
-	if (threads == -1) {
-		omp_set_num_threads(omp_get_num_procs());
-	} else {
-		omp_set_num_threads(threads);
+	/*	Threads, pinning and NUMA placement of the environment, unless given on the command line.	*/
+	RuntimeConfig config = RuntimeConfig::fromEnvironment();
+	if (threads > 0) {
+		config.nrThreads = static_cast<unsigned int>(threads);
 	}
+	RuntimeConfig::apply(config);
 
 	if (debug) {
 		/*	*/
@@ -178,6 +183,7 @@ int main(int argc, const char **argv) {
 			Layer<float> &output = *lay;
 
 			Model<float> forwardModel({&input0node}, {&output});
+			forwardModel.setLayerFusion(layerFusion);
 
 			SGD<float> optimizer(learningRate, momentum);
 			Adam<float> Adamoptimizer(learningRate);
@@ -202,7 +208,8 @@ int main(int argc, const char **argv) {
 
 			/*	*/
 			Model<float>::History &history =
-				forwardModel.fit(epochs, inputDataXF, inputResYF, batchSize, validationSplit);
+				forwardModel.fit(epochs, inputDataXF, inputResYF, batchSize, validationSplit, false, true, {},
+								 accumulationSteps);
 
 			/*	*/
 			forwardModel.saveWeight("mnist_forward_network_model.weight");
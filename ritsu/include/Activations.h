@@ -15,10 +15,10 @@
  */
 #pragma once
 #include "Tensor.h"
+#include "core/VectorMath.h"
 #include <cmath>
 #include <limits>
-
-//#define RITSU_FAST_SIGMOID
+#include <type_traits>
 
 namespace Ritsu {
 
@@ -27,23 +27,19 @@ namespace Ritsu {
 		static_assert(std::is_floating_point_v<T> || std::is_integral_v<T>,
 					  "Must be a decimal type(float/double/half) or integer.");
 
-#ifdef RITSU_FAST_SIGMOID
-		const T sigmoid = value / (1 + std::abs(value));
-#else
-		const T sigmoid = static_cast<T>(1) / (std::exp(-value) + static_cast<T>(1));
-#endif
+		const T sigmoid = VectorMath::sigmoid<T>(value);
 		return Math::clamp<T>(sigmoid, static_cast<T>(0), static_cast<T>(1));
 	}
 
 	template <typename T> inline static void computeSigmoid(T *list, const size_t nrElements) noexcept {
 		static_assert(std::is_floating_point_v<T> || std::is_integral_v<T>,
 					  "Must be a decimal type(float/double/half) or integer.");
-		size_t index = 0;
-
+		CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
 #pragma omp simd
-		for (index = 0; index < nrElements; index++) {
-			list[index] = Ritsu::computeSigmoid<T>(list[index]);
-		}
+			for (size_t index = begin; index < end; index++) {
+				list[index] = Ritsu::computeSigmoid<T>(list[index]);
+			}
+		});
 	}
 
 #pragma omp declare simd uniform(value) notinbranch simdlen(8)
@@ -57,11 +53,12 @@ namespace Ritsu {
 	template <typename T> inline static void computeSigmoidDerivative(T *list, const size_t nrElements) noexcept {
 		static_assert(std::is_floating_point_v<T> || std::is_integral_v<T>,
 					  "Must be a decimal type(float/double/half) or integer.");
-		size_t index = 0;
+		CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
 #pragma omp simd
-		for (index = 0; index < nrElements; index++) {
-			list[index] = Ritsu::computeSigmoidDerivative<T>(list[index]);
-		}
+			for (size_t index = begin; index < end; index++) {
+				list[index] = Ritsu::computeSigmoidDerivative<T>(list[index]);
+			}
+		});
 	}
 
 #pragma omp declare simd uniform(value) simdlen(8) notinbranch
@@ -74,12 +71,12 @@ namespace Ritsu {
 	template <typename T> static void relu(T *list, const size_t nrElements) noexcept {
 		static_assert(std::is_floating_point_v<T> || std::is_integral_v<T>,
 					  "Must be a decimal type(float/double/half) or integer.");
-		size_t index = 0;
-
+		CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
 #pragma omp simd
-		for (index = 0; index < nrElements; index++) {
-			list[index] = Ritsu::relu<T>(list[index]);
-		}
+			for (size_t index = begin; index < end; index++) {
+				list[index] = Ritsu::relu<T>(list[index]);
+			}
+		});
 	}
 
 #pragma omp declare simd uniform(value) simdlen(8)
@@ -95,12 +92,12 @@ namespace Ritsu {
 	template <typename T> static void reluDerivative(T *list, const size_t nrElements) noexcept {
 		static_assert(std::is_floating_point_v<T> || std::is_integral_v<T>,
 					  "Must be a decimal type(float/double/half) or integer.");
-		size_t index = 0;
-
+		CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
 #pragma omp simd
-		for (index = 0; index < nrElements; index++) {
-			list[index] = Ritsu::reluDerivative<T>(list[index]);
-		}
+			for (size_t index = begin; index < end; index++) {
+				list[index] = Ritsu::reluDerivative<T>(list[index]);
+			}
+		});
 	}
 
 #pragma omp declare simd uniform(value, alpha)
@@ -127,14 +124,26 @@ namespace Ritsu {
 	template <typename T> static constexpr T computeTanh(const T value) noexcept {
 		static_assert(std::is_floating_point_v<T> || std::is_integral_v<T>,
 					  "Must be a decimal type(float/double/half) or integer.");
-		return std::tanh(value);
+		return VectorMath::tanh<T>(value);
+	}
+
+	template <typename T> static void computeTanh(T *list, const size_t nrElements) noexcept {
+		static_assert(std::is_floating_point_v<T> || std::is_integral_v<T>,
+					  "Must be a decimal type(float/double/half) or integer.");
+		CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+			for (size_t index = begin; index < end; index++) {
+				list[index] = Ritsu::computeTanh<T>(list[index]);
+			}
+		});
 	}
 
 #pragma omp declare simd uniform(value)
 	template <typename T> static constexpr T computeTanhDerivative(const T value) noexcept {
 		static_assert(std::is_floating_point_v<T> || std::is_integral_v<T>,
 					  "Must be a decimal type(float/double/half) or integer.");
-		return 1.0 - (computeTanh<T>(value) * computeTanh<T>(value));
+		const T tanh = computeTanh<T>(value);
+		return static_cast<T>(1) - tanh * tanh;
 	}
 
 #pragma omp declare simd uniform(coeff, value)
@@ -158,7 +167,7 @@ namespace Ritsu {
 		if (value >= 0) {
 			return value;
 		}
-		return coeff * (std::exp(value) - 1);
+		return coeff * (VectorMath::exp<T>(value) - 1);
 	}
 
 #pragma omp declare simd uniform(coeff, value)
@@ -168,7 +177,7 @@ namespace Ritsu {
 		if (value >= 0) {
 			return 1;
 		}
-		return coeff * std::exp(value);
+		return coeff * VectorMath::exp<T>(value);
 	}
 
 #pragma omp declare simd uniform(value, beta)
@@ -188,31 +197,34 @@ namespace Ritsu {
 	}
 
 #pragma omp declare simd
-	template <typename T> Tensor<T> &softMax(Tensor<T> &tensor, const int axis = -1) noexcept {
-		const size_t nrElements = tensor.getNrElements();
-
-		unsigned int index = 0;
+	template <typename T> static void softMax(T *list, const size_t nrElements) noexcept {
 
 		/*	Compute exponential for each element.	*/
-#pragma omp simd simdlen(8)
-		for (index = 0; index < nrElements; index++) {
-			tensor.template getRawData<T>()[index] = static_cast<T>(std::exp(tensor.template getRawData<T>()[index]));
-		}
+		CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+			for (size_t index = begin; index < end; index++) {
+				list[index] = VectorMath::exp<T>(list[index]);
+			}
+		});
 
 		/*	Compute inverse sum.	*/
 		T Inversesum = 0;
-		Inversesum = Math::sum(tensor.getRawData(), nrElements);
+		Inversesum = Math::sum(list, nrElements);
 		Inversesum = static_cast<T>(1) / Inversesum;
 
-		/*	Apply inverse sum.	*/
-#pragma omp simd simdlen(8)
-		for (index = 0; index < nrElements; index++) {
-			tensor.template getRawData<T>()[index] *= Inversesum;
-		}
+		/*	Apply inverse sum and clip.	*/
+		CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+			for (size_t index = begin; index < end; index++) {
+				list[index] = Math::clamp<T>(list[index] * Inversesum, static_cast<T>(std::numeric_limits<T>::epsilon()),
+											 static_cast<T>(1 - std::numeric_limits<T>::epsilon()));
+			}
+		});
+	}
 
-		/*	*/
-		return tensor.clip(static_cast<T>(std::numeric_limits<T>::epsilon()),
-						   static_cast<T>(1 - std::numeric_limits<T>::epsilon()));
+	template <typename T> Tensor<T> &softMax(Tensor<T> &tensor, const int axis = -1) noexcept {
+		Ritsu::softMax<T>(tensor.template getRawData<T>(), tensor.getNrElements());
+		return tensor;
 	}
 
 	template <typename T> Tensor<T> softMax(const Tensor<T> &tensor, const int axis = -1) noexcept {
@@ -223,19 +235,96 @@ namespace Ritsu {
 	template <typename T> Tensor<float> softMaxDerivative(const Tensor<float> &tensor) {
 		Tensor<T> diag = Tensor<T>::diag(tensor);
 
-#pragma omp for simd collapse(2)
-		for (unsigned int i = 0; i < diag.getShape().getAxisDimensions(0); i++) {
-			for (unsigned int j = 0; j < diag.getShape().getAxisDimensions(1); j++) {
+		const size_t rows = diag.getShape().getAxisDimensions(0);
+		const size_t columns = diag.getShape().getAxisDimensions(1);
+		const float *values = tensor.getRawData();
+		T *data = diag.getRawData();
+
+		CpuDispatch::parallelFor(rows * columns, [&](const size_t begin, const size_t end) {
+			for (size_t index = begin; index < end; index++) {
+				const size_t i = index / columns;
+				const size_t j = index % columns;
 
 				if (i == j) {
-					diag.getValue({i, j}) = tensor.getValue(i) * (1 - tensor.getValue(i));
+					data[index] = values[i] * (1 - values[i]);
 				} else {
-					diag.getValue({i, j}) = -tensor.getValue(i) * (1 - tensor.getValue(j));
+					data[index] = -values[i] * (1 - values[j]);
 				}
 			}
-		}
+		});
 
 		return diag;
 	}
 
+	/**
+	 * @brief Elementwise activation functions, that the layer producing the input of the activation can
+	 *	apply to its own output, see Model::setLayerFusion.
+	 */
+	enum class ActivationFunction { None, Relu, Sigmoid, Tanh, Swish };
+
+	/**
+	 * @brief Activation of a single value, beta is only used by swish.
+	 */
+	template <ActivationFunction Function, typename T>
+	static constexpr T computeActivation(const T value, [[maybe_unused]] const T beta) noexcept {
+		if constexpr (Function == ActivationFunction::Relu) {
+			return Ritsu::relu<T>(value);
+		} else if constexpr (Function == ActivationFunction::Sigmoid) {
+			return Ritsu::computeSigmoid<T>(value);
+		} else if constexpr (Function == ActivationFunction::Tanh) {
+			return Ritsu::computeTanh<T>(value);
+		} else if constexpr (Function == ActivationFunction::Swish) {
+			return Ritsu::computeSwish<T>(value, beta);
+		} else {
+			return value;
+		}
+	}
+
+	/**
+	 * @brief Derivative of the activation expressed by its output, thus the input of the activation does
+	 *	not have to be kept. Swish can not be expressed by its output, see hasOutputDerivative.
+	 */
+	template <ActivationFunction Function, typename T>
+	static constexpr T computeActivationDerivative(const T output) noexcept {
+		static_assert(Function != ActivationFunction::Swish, "Swish derivative requires the input.");
+		if constexpr (Function == ActivationFunction::Relu) {
+			return output > static_cast<T>(0) ? static_cast<T>(1) : static_cast<T>(0);
+		} else if constexpr (Function == ActivationFunction::Sigmoid) {
+			return output * (static_cast<T>(1) - output);
+		} else if constexpr (Function == ActivationFunction::Tanh) {
+			return static_cast<T>(1) - output * output;
+		} else {
+			return static_cast<T>(1);
+		}
+	}
+
+	static constexpr bool hasOutputDerivative(const ActivationFunction function) noexcept {
+		return function != ActivationFunction::Swish;
+	}
+
+	/**
+	 * @brief Call callback with the activation function as a compile time constant, such that the
+	 *	activation is inlined into the loop of the callback.
+	 */
+	template <typename Callback>
+	static void dispatchActivation(const ActivationFunction function, const Callback &callback) {
+		switch (function) {
+		case ActivationFunction::Relu:
+			callback(std::integral_constant<ActivationFunction, ActivationFunction::Relu>());
+			break;
+		case ActivationFunction::Sigmoid:
+			callback(std::integral_constant<ActivationFunction, ActivationFunction::Sigmoid>());
+			break;
+		case ActivationFunction::Tanh:
+			callback(std::integral_constant<ActivationFunction, ActivationFunction::Tanh>());
+			break;
+		case ActivationFunction::Swish:
+			callback(std::integral_constant<ActivationFunction, ActivationFunction::Swish>());
+			break;
+		default:
+			callback(std::integral_constant<ActivationFunction, ActivationFunction::None>());
+			break;
+		}
+	}
+
 } // namespace Ritsu
\ No newline at end of file
@@ -132,7 +132,7 @@ namespace Ritsu {
 #pragma omp declare simd
 		Tensor<DType> derivative(const Tensor<DType> &inputX0_true, const Tensor<DType> &inputX1_pred) const override {
 			/*	-2(D - P)	*/
-			Tensor<float> output_result = (inputX0_true - inputX1_pred) * static_cast<DType>(-2);
+			Tensor<float> output_result = (lazy(inputX0_true) - lazy(inputX1_pred)) * static_cast<DType>(-2);
 			/*	Mean for each batch index.	*/
 			const int batchIndex = 0;
 			output_result = output_result.mean(batchIndex);
@@ -147,8 +147,8 @@ namespace Ritsu {
 							 Tensor<float> &output_result) {
 
 			/*	(A - B)^2	*/
-			output_result = evaluated_pre_true - expected_pred;
-			output_result = output_result * output_result;
+			const auto difference = lazy(evaluated_pre_true) - lazy(expected_pred);
+			output_result = difference * difference;
 
 			/*	Mean for each batch index.	*/
 			const int batchIndex = 0;
@@ -198,7 +198,8 @@ namespace Ritsu {
 #pragma omp declare simd
 		Tensor<DType> derivative(const Tensor<DType> &inputX0_true, const Tensor<DType> &inputX1_pred) const override {
 
-			Tensor<DType> output_result = -(inputX0_true / inputX1_pred) + (1 - inputX0_true) / (1 - inputX1_pred);
+			Tensor<DType> output_result =
+				-(lazy(inputX0_true) / lazy(inputX1_pred)) + (1 - lazy(inputX0_true)) / (1 - lazy(inputX1_pred));
 
 			/*	Mean for each batch index.	*/
 			const int batchIndex = 0;
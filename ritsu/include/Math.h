@@ -14,6 +14,7 @@
  * all copies or substantial portions of the Software.
  */
 #pragma once
+#include "core/CpuDispatch.h"
 #include <cassert>
 #include <cfloat>
 #include <cmath>
@@ -89,19 +90,18 @@ namespace Ritsu {
 			return Math::sum<T>(list.data(), list.size());
 		}
 
-#pragma omp declare simd
+		/**
+		 * @brief Sum of the elements, accumulated in SumLanes partial sums per block of
+		 *	CpuDispatch::parallelReduce. The order of the additions is the same on every CPU tier
+		 *	and for any number of threads, only the vector width differs.
+		 */
 		template <typename T> static T sum(const T *list, const size_t nrElements) noexcept {
 			static_assert(std::is_floating_point_v<T> || std::is_integral_v<T> || std::is_enum_v<T>,
 						  "Type Must Support addition operation.");
-			T sum = 0;
-			size_t index = 0;
-			
-#pragma omp simd reduction(+ : sum)
-			for (index = 0; index < nrElements; index++) {
-				sum += list[index];
-			}
 
-			return sum;
+			return CpuDispatch::parallelReduce<T>(
+				nrElements, [list](const size_t begin, const size_t end) { return Math::sumRange<T>(list, begin, end); },
+				[](const T a, const T b) { return a + b; });
 		}
 
 		template <typename T> static T sum_abs(const std::vector<T> &list) noexcept {
@@ -144,31 +144,45 @@ namespace Ritsu {
 			return product_combined;
 		}
 
-#pragma omp declare simd uniform(nrElements)
 		template <typename T> static T dot(const T *listA, const T *listB, const size_t nrElements) noexcept {
 			static_assert(std::is_floating_point_v<T> || std::is_integral_v<T>,
 						  "Type Must Support addition operation.");
-			T sum = 0;
-			size_t index = 0;
 
-#pragma omp simd reduction(+ : sum)
-			for (index = 0; index < nrElements; index++) {
-				sum += listA[index] * listB[index];
-			}
-			return sum;
+			return CpuDispatch::parallelReduce<T>(
+				nrElements,
+				[listA, listB](const size_t begin, const size_t end) {
+					constexpr size_t Lanes = Math::SumLanes<T>;
+					T lanes[Lanes] = {};
+					T sum = 0;
+
+					size_t index = begin;
+					for (; index + Lanes <= end; index += Lanes) {
+#pragma omp simd
+						for (size_t lane = 0; lane < Lanes; lane++) {
+							lanes[lane] += listA[index + lane] * listB[index + lane];
+						}
+					}
+					for (; index < end; index++) {
+						sum += listA[index] * listB[index];
+					}
+					for (size_t lane = 0; lane < Lanes; lane++) {
+						sum += lanes[lane];
+					}
+					return sum;
+				},
+				[](const T a, const T b) { return a + b; });
 		}
 
 #pragma omp declare simd uniform(exponent, nrElements)
 		template <typename T> static inline void pow(const T exponent, T *list, const size_t nrElements) noexcept {
 			static_assert(std::is_floating_point_v<T> || std::is_integral_v<T>,
 						  "Type Must Support addition operation.");
-			/*	*/
-			size_t index = 0;
-
-#pragma omp for simd
-			for (index = 0; index < nrElements; index++) {
-				list[index] = static_cast<T>(std::pow(list[index], exponent));
-			}
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t index = begin; index < end; index++) {
+					list[index] = static_cast<T>(std::pow(list[index], exponent));
+				}
+			});
 		}
 
 #pragma omp declare simd
@@ -189,16 +203,16 @@ namespace Ritsu {
 			return static_cast<T>(averageInverse * sum);
 		}
 
-#pragma omp declare simd uniform(mean)
 		template <typename T> static T variance(const T *list, const size_t nrElements, const T mean) noexcept {
 			static_assert(std::is_floating_point_v<T> || std::is_integral_v<T>,
 						  "Type Must Support addition operation.");
-			T sum = 0;
-			size_t index = 0;
-#pragma omp simd reduction(+ : sum)
-			for (index = 0; index < nrElements; index++) {
-				sum += (list[index] - mean) * (list[index] - mean);
-			}
+
+			const T sum = CpuDispatch::parallelReduce<T>(
+				nrElements,
+				[list, mean](const size_t begin, const size_t end) {
+					return Math::sumSquaredDeviation<T>(list, begin, end, mean);
+				},
+				[](const T a, const T b) { return a + b; });
 
 			return (static_cast<T>(1) / static_cast<T>((nrElements - 1))) * sum;
 		}
@@ -209,6 +223,66 @@ namespace Ritsu {
 			return Math::variance<T>(list.data(), list.size(), mean);
 		}
 
+		/**
+		 * @brief Number of values, their mean and the sum of the squared deviations from the mean.
+		 */
+		template <typename T> struct Moments {
+			size_t count = 0;
+			T mean = 0;
+			T m2 = 0;
+		};
+
+		/**
+		 * @brief Combine the moments of two disjoint sets of values, Chan et al.
+		 */
+		template <typename T> static Moments<T> combine(const Moments<T> &a, const Moments<T> &b) noexcept {
+			if (a.count == 0) {
+				return b;
+			}
+			if (b.count == 0) {
+				return a;
+			}
+			const size_t count = a.count + b.count;
+			const T delta = b.mean - a.mean;
+			const T weight = static_cast<T>(b.count) / static_cast<T>(count);
+
+			Moments<T> moments;
+			moments.count = count;
+			moments.mean = a.mean + delta * weight;
+			moments.m2 = a.m2 + b.m2 + delta * delta * static_cast<T>(a.count) * weight;
+			return moments;
+		}
+
+		/**
+		 * @brief Mean and sample variance in a single pass over the memory. Each block of
+		 *	CpuDispatch::parallelReduce is reduced to its moments while it is in cache, and the
+		 *	blocks are combined pairwise, which is stable without a separate mean pass.
+		 */
+		template <typename T>
+		static void meanVariance(const T *list, const size_t nrElements, T &mean, T &variance) noexcept {
+			static_assert(std::is_floating_point_v<T>, "Must be a decimal type(float/double/half).");
+
+			const Moments<T> moments = CpuDispatch::parallelReduce<Moments<T>>(
+				nrElements,
+				[list](const size_t begin, const size_t end) {
+					Moments<T> block;
+					block.count = end - begin;
+					if (block.count > 0) {
+						block.mean = Math::sumRange<T>(list, begin, end) / static_cast<T>(block.count);
+						block.m2 = Math::sumSquaredDeviation<T>(list, begin, end, block.mean);
+					}
+					return block;
+				},
+				[](const Moments<T> &a, const Moments<T> &b) { return Math::combine<T>(a, b); });
+
+			mean = moments.mean;
+			variance = moments.m2 / static_cast<T>(nrElements - 1);
+		}
+
+		template <typename T> static void meanVariance(const std::vector<T> &list, T &mean, T &variance) noexcept {
+			Math::meanVariance<T>(list.data(), list.size(), mean, variance);
+		}
+
 		template <typename T> constexpr static T standardDeviation(const std::vector<T> &list, const T mean) {
 			static_assert(std::is_floating_point_v<T> || std::is_integral_v<T>,
 						  "Type Must Support addition operation.");
@@ -435,8 +509,59 @@ namespace Ritsu {
 #pragma omp declare simd uniform(size, alignment) notinbranch
 		template <typename T> static constexpr T align(const T size, const T alignment) noexcept {
 			static_assert(std::is_integral_v<T>, "Must be an integral type.");
-			return size + (alignment - (size % alignment));
+			return ((size + alignment - 1) / alignment) * alignment;
+		}
+
+		/*	Sum of list over [begin, end), in SumLanes partial sums.	*/
+		template <typename T> static inline T sumRange(const T *list, const size_t begin, const size_t end) noexcept {
+			constexpr size_t Lanes = Math::SumLanes<T>;
+			T lanes[Lanes] = {};
+			T sum = 0;
+
+			size_t index = begin;
+			for (; index + Lanes <= end; index += Lanes) {
+#pragma omp simd
+				for (size_t lane = 0; lane < Lanes; lane++) {
+					lanes[lane] += list[index + lane];
+				}
+			}
+			for (; index < end; index++) {
+				sum += list[index];
+			}
+			for (size_t lane = 0; lane < Lanes; lane++) {
+				sum += lanes[lane];
+			}
+			return sum;
 		}
+
+		/*	Sum of (list[i] - mean)^2 over [begin, end), in SumLanes partial sums.	*/
+		template <typename T>
+		static inline T sumSquaredDeviation(const T *list, const size_t begin, const size_t end, const T mean) noexcept {
+			constexpr size_t Lanes = Math::SumLanes<T>;
+			T lanes[Lanes] = {};
+			T sum = 0;
+
+			size_t index = begin;
+			for (; index + Lanes <= end; index += Lanes) {
+#pragma omp simd
+				for (size_t lane = 0; lane < Lanes; lane++) {
+					const T deviation = list[index + lane] - mean;
+					lanes[lane] += deviation * deviation;
+				}
+			}
+			for (; index < end; index++) {
+				const T deviation = list[index] - mean;
+				sum += deviation * deviation;
+			}
+			for (size_t lane = 0; lane < Lanes; lane++) {
+				sum += lanes[lane];
+			}
+			return sum;
+		}
+
+		/*	Number of partial sums of the reductions, two 512-bit registers worth of elements such
+		 *	that even the widest tier has independent additions in flight.	*/
+		template <typename T> static constexpr size_t SumLanes = sizeof(T) < 128 ? 128 / sizeof(T) : 1;
 	};
 
 } // namespace Ritsu
\ No newline at end of file
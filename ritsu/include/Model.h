@@ -22,14 +22,19 @@
 #include "RitsuDef.h"
 #include "Tensor.h"
 #include "Util.h"
+#include "core/MemoryPlanner.h"
 #include "core/Shape.h"
 #include "core/Time.h"
+#include "layers/Activation.h"
+#include "layers/Dense.h"
 #include "layers/Layer.h"
+#include "layers/Regularization.h"
 #include "layers/Reshape.h"
 #include "optimizer/Optimizer.h"
 #include <cassert>
 #include <chrono>
 #include <cstddef>
+#include <cstring>
 #include <initializer_list>
 #include <iostream>
 #include <list>
@@ -38,7 +43,9 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <typeinfo>
 #include <utility>
+#include <vector>
 
 namespace Ritsu {
 
@@ -69,10 +76,15 @@ namespace Ritsu {
 		}
 		virtual ~Model() = default;
 
+		/**
+		 * @brief Train the model. Each batch_size is a micro-batch, the gradients of accumulation_steps micro-batches
+		 * are summed before a single optimizer step, for an effective batch of batch_size * accumulation_steps.
+		 */
 		template <typename U, typename Y>
 		History &fit(const size_t epochs, const Tensor<U> &inputData, const Tensor<Y> &expectedData,
 					 const size_t batch_size = 1, const float validation_split = 0.0f, const bool shuffle = false,
-					 const bool verbose = true, std::initializer_list<CallBack> callback = {}) {
+					 const bool verbose = true, std::initializer_list<CallBack> callback = {},
+					 const size_t accumulation_steps = 1) {
 
 			const size_t batch_shape_index = 0;
 
@@ -82,14 +94,17 @@ namespace Ritsu {
 				throw RuntimeException("Model not built and compiled");
 			}
 
+			if (accumulation_steps == 0) {
+				throw InvalidArgumentException("Accumulation steps must be at least 1");
+			}
+
 			/*	Number of batches in dataset.	*/
 			const size_t batchXIndex = inputData.getShape()[batch_shape_index];
 			const size_t batchYIndex = expectedData.getShape()[batch_shape_index];
 
 			/*	*/
-			size_t nrTrainBatches = std::floor(static_cast<float>(batchXIndex) / static_cast<float>(batch_size));
-			const size_t nrTrainExpectedBatches =
-				std::floor(static_cast<float>(batchYIndex) / static_cast<float>(batch_size));
+			size_t nrTrainBatches = batchXIndex / batch_size;
+			const size_t nrTrainExpectedBatches = batchYIndex / batch_size;
 
 			nrTrainBatches = Math::min<size_t>(nrTrainBatches, nrTrainExpectedBatches);
 
@@ -121,10 +136,15 @@ namespace Ritsu {
 			const size_t batchDataElementSize = batchDataShape.getNrElements();
 			const size_t batchExpectedElementSize = batchExpectedShape.getNrElements();
 
-			// TODO: add array support.
-			Tensor<float> batchPredictedResult;
-			/*	TODO: setup cache.	*/
-			std::map<std::string, Tensor<float>> cachedResult;
+			/*	Preallocate all the activation buffers for the batch size.	*/
+			this->plan(batch_size);
+
+			/*	Resolve the history entries once, rather than per batch.	*/
+			std::vector<Tensor<float> *> metricHistory(this->metrics.size());
+			for (size_t m_index = 0; m_index < this->metrics.size(); m_index++) {
+				metricHistory[m_index] = &this->history[this->metrics[m_index]->getName()];
+			}
+			Tensor<float> &lossHistory = this->history[this->lossmetric.getName()];
 
 			/*	Preallocate.	*/ // TODO:
 			Tensor<float> loss_error = Tensor<float>(this->outputs[0]->getShape());
@@ -157,18 +177,17 @@ namespace Ritsu {
 				/*	Train pass.	*/
 				for (size_t ibatch = 0; ibatch < nrTrainBatches; ibatch++) {
 
+					/*	Temporaries of the batch are released at once, at the end of the batch.	*/
+					ScopedArena batchScope;
+
 					/*	Extract subset of the data.	*/
-					const Tensor<float> subsetBatchX =
-						data_train.getSubset({{static_cast<unsigned int>(ibatch * batch_size),
-											   static_cast<unsigned int>((ibatch + 1) * batch_size) - 1}});
+					const Tensor<float> subsetBatchX = Model::getBatch(data_train, ibatch, batch_size);
 
 					/*	*/
-					const Tensor<float> subsetExpectedBatch =
-						expected_train.getSubset({{static_cast<unsigned int>(ibatch * batch_size),
-												   static_cast<unsigned int>((ibatch + 1) * batch_size) - 1}});
+					const Tensor<float> subsetExpectedBatch = Model::getBatch(expected_train, ibatch, batch_size);
 
 					/*	Compute network forward.	*/
-					this->forwardPropgation(subsetBatchX, batchPredictedResult, batch_size, &cachedResult);
+					const Tensor<float> &batchPredictedResult = this->forwardPropgation(subsetBatchX, true);
 
 					/*	*/
 					loss_error = this->lossFunction->computeLoss(subsetExpectedBatch, batchPredictedResult);
@@ -192,14 +211,21 @@ namespace Ritsu {
 						/*	Update history, using all metrics.	*/
 						for (size_t m_index = 0; m_index < this->metrics.size(); m_index++) {
 							/*	*/
-							this->history[this->metrics[m_index]->getName()].concatenate(
+							metricHistory[m_index]->concatenate(
 								this->metrics[m_index]->result().template getValue<float>(0));
 						}
-						this->history[this->lossmetric.getName()].concatenate(this->lossmetric.result().getValue(0));
+						lossHistory.concatenate(this->lossmetric.result().getValue(0));
 					}
 
-					/*	*/
-					this->backPropagation(loss_deriv, cachedResult, batch_size);
+					/*	Micro-batches of a group add onto the gradients, the last one of the group applies them.	*/
+					const size_t groupBegin = ibatch - ibatch % accumulation_steps;
+					const size_t groupSize = Math::min<size_t>(accumulation_steps, nrTrainBatches - groupBegin);
+					const float gradientScale = 1.0f / static_cast<float>(batch_size * groupSize);
+
+					this->backPropagation(loss_deriv, batch_size, gradientScale, ibatch != groupBegin);
+					if (ibatch + 1 == groupBegin + groupSize) {
+						this->applyGradients();
+					}
 
 					/*	*/
 					if (verbose) {
@@ -251,21 +277,20 @@ namespace Ritsu {
 					for (size_t batch_index = 0; batch_index < nrValidationBatches && validation_split > 0;
 						 batch_index++) {
 
+						ScopedArena batchScope;
+
 						/*	Extract subset of the data.	*/
 						const size_t baseBatch = batch_index;
 
 						/*	Extract subset of the data.	*/
-						const Tensor<float> subsetBatchX =
-							input_validation.getSubset({{static_cast<unsigned int>(baseBatch * batch_size),
-														 static_cast<unsigned int>((baseBatch + 1) * batch_size) - 1}});
+						const Tensor<float> subsetBatchX = Model::getBatch(input_validation, baseBatch, batch_size);
 
 						/*	*/
-						const Tensor<float> subsetExpectedBatch = expected_validation.getSubset(
-							{{static_cast<unsigned int>(baseBatch * batch_size),
-							  static_cast<unsigned int>((baseBatch + 1) * batch_size) - 1}});
+						const Tensor<float> subsetExpectedBatch =
+							Model::getBatch(expected_validation, baseBatch, batch_size);
 
 						/*	Compute network forward.	*/
-						this->forwardPropgation(subsetBatchX, batchPredictedResult, batch_size, nullptr);
+						const Tensor<float> &batchPredictedResult = this->forwardPropgation(subsetBatchX, false);
 
 						loss_error =
 							std::move(this->lossFunction->computeLoss(subsetExpectedBatch, batchPredictedResult));
@@ -331,18 +356,100 @@ namespace Ritsu {
 				throw std::runtime_error("Must be built before it can run through the network");
 			}
 
-			Tensor<float> result;
-
 			Time time;
 			time.start();
 
-			this->forwardPropgation(inputTensor, result, inputTensor.getShape()[0], nullptr);
+			Tensor<float> result = this->forwardPropgation(inputTensor, false);
 
 			time.getElapsed<float>();
 
 			return result;
 		}
 
+		/**
+		 * @brief Compute the network on a single batch. The returned tensor is owned by the
+		 * execution plan and is only valid until the next forward pass.
+		 */
+		template <typename U> const Tensor<float> &predictOnBatch(const Tensor<U> &batch) {
+
+			if (!this->is_built()) {
+				throw std::runtime_error("Must be built before it can run through the network");
+			}
+
+			return this->forwardPropgation(batch, false);
+		}
+
+		/**
+		 * @brief Build the execution plan for the batch size. All activations are placed in a
+		 * single arena, allocated up front, where activations never alive at the same time share
+		 * memory and elementwise layers run in-place. When training, every activation read by
+		 * backpropagation is kept alive until the backward pass.
+		 */
+		void plan(const size_t batchSize, const bool training = true) {
+
+			if (!this->is_built()) {
+				throw RuntimeException("Model must be built before it can be planned");
+			}
+
+			/*	The plan outlives any arena scope.	*/
+			ScopedAllocator persistent(nullptr);
+
+			std::vector<Shape<IndexType>> shapes;
+			std::vector<size_t> slotBuffer;
+			MemoryPlanner planner;
+			this->planMemory(batchSize, training, this->executionPlan, shapes, slotBuffer, planner);
+
+			/*	Single allocation for all the activations.	*/
+			this->activations.clear();
+			this->activationsTransposedShape.clear();
+			this->activationArena = Tensor<float>({static_cast<IndexType>(planner.getArenaSize() / sizeof(float))});
+
+			this->activations.reserve(shapes.size());
+			this->activationsTransposedShape.reserve(shapes.size());
+			for (size_t slot = 0; slot < shapes.size(); slot++) {
+				const size_t offset = planner.getOffset(slotBuffer[slot]) / sizeof(float);
+				this->activations.push_back(
+					this->activationArena.getSubset(offset, offset + shapes[slot].getNrElements(), shapes[slot]));
+				this->activationsTransposedShape.push_back(shapes[slot].transpose());
+			}
+
+			/*	Backpropagation buffers, sized for the output error of the batch.	*/
+			const IndexType nrErrorElements = static_cast<IndexType>(shapes.back().getNrElements());
+			this->differentialError = Tensor<float>({nrErrorElements});
+			this->previousDerivative = Tensor<float>({nrErrorElements});
+
+			this->planBatchSize = batchSize;
+			this->planTraining = training;
+		}
+
+		/**
+		 * @brief Peak size in bytes of the activations for the batch size, with memory reuse.
+		 */
+		size_t peakActivationBytes(const size_t batchSize, const bool training = true) const {
+			std::vector<ExecutionStep> steps;
+			std::vector<Shape<IndexType>> shapes;
+			std::vector<size_t> slotBuffer;
+			MemoryPlanner planner;
+			this->planMemory(batchSize, training, steps, shapes, slotBuffer, planner);
+			return planner.getArenaSize();
+		}
+
+		/**
+		 * @brief Compute each Dense followed by an elementwise activation as a single step, the bias and the
+		 *	activation applied by the product, see fuseLayers. Enabled by default, disable to run and inspect
+		 *	every layer on its own.
+		 */
+		void setLayerFusion(const bool enabled) noexcept {
+			if (this->layerFusion != enabled) {
+				this->layerFusion = enabled;
+				/*	Rebuild the plan on the next pass.	*/
+				this->activations.clear();
+				this->executionPlan.clear();
+			}
+		}
+
+		bool isLayerFusionEnabled() const noexcept { return this->layerFusion; }
+
 		void compile(Optimizer<T> *optimizer, const Loss<T> &loss, const std::vector<Metric *> &compile_metrics = {}) {
 
 			if (optimizer == nullptr) {
@@ -417,6 +524,9 @@ namespace Ritsu {
 			_summary << "number of weights: " << std::to_string(this->nr_weights) << std::endl;
 			_summary << "Trainable in Bytes: " << std::to_string(train_in_bytes) << " KB" << std::endl;
 			_summary << "None-Trainable in Bytes: " << std::to_string(none_train_in_bytes) << " KB" << std::endl;
+			_summary << "Activations in Bytes (per sample): "
+					 << std::to_string(this->peakActivationBytes(1, false) / 1024) << " KB inference, "
+					 << std::to_string(this->peakActivationBytes(1, true) / 1024) << " KB training" << std::endl;
 			_summary << "Loss Function: " << this->lossFunction->getName() << std::endl;
 			_summary << "Optimizer: " << this->optimizer->getName() << std::endl;
 			return _summary.str();
@@ -443,118 +553,74 @@ namespace Ritsu {
 		}
 
 	  protected:
-		template <typename U, typename Y>
-		void forwardPropgation(const Tensor<U> &inputData, Tensor<Y> &result, const size_t batchSize,
-							   std::map<std::string, Tensor<float>> *cacheResult = nullptr) {
-
-			const size_t batchIndex = inputData.getShape()[0];
-
-			/*	*/
-			Tensor<float> layerResult = inputData;
-			const bool is_training = cacheResult != nullptr;
+		template <typename U> const Tensor<float> &forwardPropgation(const Tensor<U> &inputData, const bool is_training) {
 
-			if (cacheResult) {
-				(*cacheResult)["inputData"] = inputData;
+			/*	Plan is only rebuilt when the batch size changes.	*/
+			const size_t batchSize = inputData.getShape()[0];
+			if (this->activations.empty() || this->planBatchSize != batchSize || (is_training && !this->planTraining)) {
+				this->plan(batchSize, is_training);
 			}
 
-			for (auto it = this->forwardSequence.begin(); it != this->forwardSequence.end(); it++) {
-				Layer<T> *current = (*it);
-
-				const bool junctionLayer = is_junction_layer(current);
-
-				Tensor<float> batchTmp =
-					Shape<unsigned int>({static_cast<unsigned int>(batchIndex)}).insert(1, current->getShape());
-
-				/*	Compute each batch element.	*/
-				for (size_t batch_index = 0; batch_index < batchSize; batch_index++) {
-					/*	*/
-					Tensor<float> prevBatch = layerResult.getSubset({{static_cast<IndexType>(batch_index)}});
-					prevBatch.reduce();
+			/*	Copy the batch into the input slot.	*/
+			Tensor<float> &inputSlot = this->activations[0];
+			if (inputData.getDatSize() > inputSlot.getDatSize()) {
+				throw InvalidArgumentException("Input data does not match the input layer shape");
+			}
+			std::memcpy(inputSlot.getRawData(), inputData.getRawData(), inputData.getDatSize());
 
-					// std::cerr << prevBatch << std::endl << std::endl;
-					Tensor<float> resultSubset = batchTmp.getSubset({static_cast<IndexType>(batch_index)});
+			for (size_t i = 0; i < this->executionPlan.size(); i++) {
+				const ExecutionStep &step = this->executionPlan[i];
+				Tensor<float> &layerResult = this->activations[step.output];
 
-					/*	Perform layer on data.	*/
-					Tensor<float> result = current->call(const_cast<const Tensor<float> &>(prevBatch), is_training);
-					resultSubset.assign(result);
+				/*	Compute the whole batch at once.	*/
+				if (step.activation != ActivationFunction::None) {
+					static_cast<Dense *>(step.layer)->callBatchFused(this->activations[step.input], layerResult,
+																	 step.activation, step.activationParameter);
+				} else {
+					step.layer->callBatch(this->activations[step.input], layerResult, is_training);
 				}
 
-				/*	Override the layer result with the batch.	*/
-				layerResult = std::move(batchTmp);
-
 				/*	*/
-				debug_print_tensor_layer<T>(std::cout, *current, reinterpret_cast<Tensor<T> &>(layerResult));
-
-				/*	validate result shape. */
-				const auto shape =
-					layerResult.getShape().getSubShape(layerResult.getShape().getNrDimensions() > 1 ? 1 : 0);
-				if (shape != current->getShape()) {
-					/*	*/
-					std::cerr << "Invalid Shape: " << shape << " " << current->getShape() << " " << current->getName()
-							  << std::endl;
-				}
-
-				/*	Assign result if memory provided.	*/
-				if (cacheResult != nullptr) {
-					(*cacheResult)[(*current).getName()] = layerResult;
-					(*cacheResult)[(*current).getName()].transpose();
-				}
+				debug_print_tensor_layer<T>(std::cout, *step.layer, reinterpret_cast<Tensor<T> &>(layerResult));
 			}
 
 			/*	*/
-			result = std::move(layerResult);
+			return this->activations.back();
 		}
 
-		void backPropagation(const Tensor<float> &error, std::map<std::string, Tensor<float>> &cacheResult,
-							 const size_t batchSize) {
-
-			/*	*/
-			Tensor<float> &current_layer_q = cacheResult[(*this->forwardSequence.rbegin())->getName()];
-			Tensor<float> &previous_layer_q = cacheResult[(*this->forwardSequence.rbegin()++)->getName()];
-
-			const float batch_inverse = 1.0f / static_cast<float>(batchSize);
-
-			Tensor<float> differental_z_error = error.transpose();
-
-			/*	Duplicate the loss to match the batch size.	*/
-			for (unsigned int i = 0; i < batchSize - 1; i++) {
-				differental_z_error.concatenate(error.transpose());
-			}
+		/**
+		 * @brief Propagate the error through the network and compute the gradients of every trainable layer, scaled by
+		 * gradientScale. The gradients are added onto the previous ones when accumulate is set, and are applied by
+		 * applyGradients.
+		 */
+		void backPropagation(const Tensor<float> &error, const size_t batchSize, const float gradientScale,
+							 const bool accumulate) {
 
 			// TODO:
 			Shape<IndexType> diffShape;
 			diffShape.insert(0, {(IndexType)batchSize});
 			diffShape.insert(1, error.getShape().getSubShape(1));
 
-			differental_z_error.reshape(diffShape);
+			/*	Broadcast the loss over the batch.	*/
+			Tensor<float> &differental_z_error = this->differentialError;
+			if (differental_z_error.getShape() != diffShape) {
+				differental_z_error.resizeBuffer(diffShape, sizeof(float));
+			}
+			Tensor<float>::broadcastTo(error, differental_z_error);
 			differental_z_error.transpose();
 
-			Tensor<float> prev_layer_deriv = differental_z_error;
+			Tensor<float> &prev_layer_deriv = this->previousDerivative;
+			prev_layer_deriv = differental_z_error;
 
 			/*	*/
-			Layer<T> *current = nullptr;
-			Layer<T> *prev = nullptr;
-			for (auto it = this->forwardSequence.rbegin(); it != this->forwardSequence.rend(); it++) {
-
-				/*	*/
-				current = (*it);
-				prev = *(std::next(it));
-
-				/*	Finished.	*/
-				if (is_input_layer(current)) {
-					return;
-				}
+			for (size_t step_index = this->executionPlan.size(); step_index > 0; step_index--) {
+				const ExecutionStep &step = this->executionPlan[step_index - 1];
+				Layer<T> *current = step.layer;
 
-				/*	*/
-				if (cacheResult.find(current->getName()) != cacheResult.end()) {
-					current_layer_q = cacheResult[current->getName()];
-				} else {
-					current_layer_q = cacheResult["inputData"];
-				}
-				if (std::next(it) != this->forwardSequence.rend() &&
-					cacheResult.find(prev->getName()) != cacheResult.end()) {
-					previous_layer_q = cacheResult[prev->getName()];
-				}
+				/*	Layer input, transposed, as a view of the activation buffer.	*/
+				const Tensor<float> &input = this->activations[step.input];
+				Tensor<float> previous_layer_q =
+					input.getSubset(0, input.getNrElements(), this->activationsTransposedShape[step.input]);
 
 				/*	Extract if any trainable.	 */
 				std::optional<std::vector<Tensor<DType> *>> optional_train_variables = current->getTrainableWeights();
@@ -564,6 +630,12 @@ namespace Ritsu {
 
 				debug_print_tensor(std::cout, differental_z_error, "dZ");
 
+				/*	Error of the fused activation onto the error of the product.	*/
+				if (step.activation != ActivationFunction::None) {
+					Model::applyActivationDerivative(step.activation, this->activations[step.output],
+													 differental_z_error);
+				}
+
 				/*	*/
 				if (optional_train_variables.has_value() && !optional_train_variables.value().empty()) {
 					std::vector<Tensor<DType> *> train_variables = optional_train_variables.value();
@@ -577,21 +649,38 @@ namespace Ritsu {
 
 					debug_print_tensor(std::cout, differental_q_error, "DQ");
 
-					/*	*/
-					for (size_t i_var = 0; i_var < train_variables.size(); i_var++) {
-						Tensor<DType> *variable = train_variables[i_var];
-
-						Tensor<float> gradient =
-							current->compute_gradient(i_var, differental_z_error, previous_layer_q);
-
-						debug_print_tensor(std::cout, gradient, "Gradient");
+					/*	Gradients in the buffers of the layer when it has them, otherwise in the ones of the model.	*/
+					std::optional<std::vector<Tensor<DType> *>> gradients =
+						current->accumulate_gradients(differental_z_error, previous_layer_q, gradientScale, accumulate);
+					if (!gradients.has_value()) {
+						std::vector<Tensor<DType>> &buffers = this->gradientBuffers[current];
+						buffers.resize(train_variables.size());
+						gradients = std::vector<Tensor<DType> *>(train_variables.size());
+
+						for (size_t i_var = 0; i_var < train_variables.size(); i_var++) {
+							const Tensor<float> gradient =
+								current->compute_gradient(i_var, differental_z_error, previous_layer_q);
+							Tensor<DType> &buffer = buffers[i_var];
+
+							if (buffer.getShape() != gradient.getShape()) {
+								/*	Outlives the arena scope of the batch.	*/
+								ScopedAllocator persistent(nullptr);
+								buffer = Tensor<DType>::zero(gradient.getShape());
+							}
 
-						/*	*/
-						gradient *= batch_inverse;
+							if (accumulate) {
+								buffer = lazy(buffer) + lazy(gradient) * gradientScale;
+							} else {
+								buffer = lazy(gradient) * gradientScale;
+							}
+							gradients.value()[i_var] = &buffer;
+						}
+					}
 
-						this->optimizer->update_step(reinterpret_cast<Tensor<T> &>(gradient),
-													 reinterpret_cast<Tensor<T> &>(*variable));
+					for (size_t i_var = 0; i_var < train_variables.size(); i_var++) {
+						debug_print_tensor(std::cout, *gradients.value()[i_var], "Gradient");
 					}
+					this->layerGradients[current] = std::move(gradients.value());
 
 					/*	*/
 					differental_z_error = prev_layer_deriv;
@@ -603,7 +692,7 @@ namespace Ritsu {
 						differental_z_error.reshape(current->getInputs().at(0)->getShape());
 					} else {
 						Tensor<float> z_derv =
-							current->compute_derivative(static_cast<const Tensor<float> &>(current_layer_q));
+							current->compute_derivative(static_cast<const Tensor<float> &>(previous_layer_q));
 						differental_z_error = z_derv.dot(prev_layer_deriv);
 					}
 					prev_layer_deriv = differental_z_error;
@@ -614,6 +703,28 @@ namespace Ritsu {
 			}
 		}
 
+		/**
+		 * @brief Apply one optimizer step with the gradients computed by backPropagation.
+		 */
+		void applyGradients() {
+			/*	Same order as the backward pass.	*/
+			for (size_t step_index = this->executionPlan.size(); step_index > 0; step_index--) {
+				Layer<T> *current = this->executionPlan[step_index - 1].layer;
+
+				const auto found = this->layerGradients.find(current);
+				if (found == this->layerGradients.end()) {
+					continue;
+				}
+
+				const std::vector<Tensor<DType> *> train_variables = current->getTrainableWeights().value();
+				for (size_t i_var = 0; i_var < train_variables.size(); i_var++) {
+					this->optimizer->update_step(reinterpret_cast<Tensor<T> &>(*found->second[i_var]),
+												 reinterpret_cast<Tensor<T> &>(*train_variables[i_var]));
+				}
+				current->weights_updated();
+			}
+		}
+
 		virtual void build(std::vector<Layer<T> *> inputs, std::vector<Layer<T> *> outputs) { /*	*/
 
 			/*	*/
@@ -622,6 +733,38 @@ namespace Ritsu {
 			// Iterate through each and extract number of trainable variables.
 			this->build_sequence(inputs, outputs);
 			this->init_unique_name();
+			this->fuseLayers();
+		}
+
+		/**
+		 * @brief Find each Dense followed, possibly through regularizations that do nothing, by an activation
+		 *	that can be applied elementwise. The plan computes such a chain as a single step, see planMemory.
+		 */
+		void fuseLayers() {
+			this->fusedChains.clear();
+
+			for (Layer<T> *current : this->forwardSequence) {
+				if (typeid(*current) != typeid(Dense) || this->is_output_layer(current)) {
+					continue;
+				}
+
+				/*	Skip the layers that leave the output of the dense as is.	*/
+				Layer<T> *next = current->getOutputs().size() == 1 ? current->getOutputs()[0] : nullptr;
+				while (next != nullptr && typeid(*next) == typeid(Regularization) && !this->is_output_layer(next) &&
+					   next->getOutputs().size() == 1) {
+					const Regularization *regularization = static_cast<const Regularization *>(next);
+					if (regularization->getL1() != 0 || regularization->getL2() != 0) {
+						break;
+					}
+					next = next->getOutputs()[0];
+				}
+
+				const Activation *activation = dynamic_cast<const Activation *>(next);
+				if (activation != nullptr && activation->getFusedFunction() != ActivationFunction::None) {
+					this->fusedChains[current] = {next, activation->getFusedFunction(),
+												  activation->getFusedParameter()};
+				}
+			}
 		}
 
 		void build_sequence(const std::vector<Layer<T> *> inputs, const std::vector<Layer<T> *> outputs) {
@@ -732,6 +875,43 @@ namespace Ritsu {
 			return false;
 		}
 
+		/**
+		 * @brief View of the samples of batch batchIndex. Samples are indexed along the first axis,
+		 *	thus fit in IndexType, while the memory offset of the batch is computed in SizeType.
+		 */
+		static Tensor<float> getBatch(const Tensor<float> &data, const size_t batchIndex, const size_t batchSize) {
+			const size_t start = batchIndex * batchSize;
+			const size_t end = start + batchSize - 1;
+
+			if (end >= data.getShape()[0]) {
+				throw InvalidArgumentException("Batch out of range of the dataset.");
+			}
+
+			return data.getSubset({{static_cast<IndexType>(start), static_cast<IndexType>(end)}});
+		}
+
+		/**
+		 * @brief error *= activation'(output), the derivative of the fused activation from its output.
+		 */
+		static void applyActivationDerivative(const ActivationFunction function, const Tensor<float> &output,
+											  Tensor<float> &error) {
+			const TensorSpan<const float> values = output.span();
+			const TensorSpan<float> data = error.span();
+			assert(values.size() == data.size());
+
+			dispatchActivation(function, [&](auto activation) {
+				constexpr ActivationFunction Function = decltype(activation)::value;
+				if constexpr (Function != ActivationFunction::Swish) {
+					CpuDispatch::parallelFor(data.size(), [&](const size_t begin, const size_t end) {
+#pragma omp simd
+						for (size_t i = begin; i < end; i++) {
+							data[i] *= computeActivationDerivative<Function, float>(values[i]);
+						}
+					});
+				}
+			});
+		}
+
 	  protected:
 		/*	*/
 		std::vector<Layer<T> *> inputs;
@@ -754,6 +934,134 @@ namespace Ritsu {
 		std::map<std::string, Object *> batchCache;
 		std::map<std::string, Object *> backPropagationCache;
 
+		/**
+		 * @brief Single layer invocation of the execution plan.
+		 */
+		struct ExecutionStep {
+			Layer<T> *layer;   /*	*/
+			size_t input = 0;  /*	Activation slot read by the layer.	*/
+			size_t output = 0; /*	Activation slot written by the layer.	*/
+			ActivationFunction activation = ActivationFunction::None; /*	Fused activation of a dense layer.	*/
+			T activationParameter = 0;
+		};
+
+		/**
+		 * @brief Dense layer followed by an activation, computed as a single step.
+		 */
+		struct FusedChain {
+			Layer<T> *last; /*	Activation ending the chain.	*/
+			ActivationFunction activation;
+			T activationParameter;
+		};
+
+		/*	Chains found by fuseLayers, by the dense layer beginning the chain.	*/
+		std::map<const Layer<T> *, FusedChain> fusedChains;
+		bool layerFusion = true;
+
+		/*	Execution plan, built for a fixed batch size.	*/
+		std::vector<ExecutionStep> executionPlan;
+		Tensor<float> activationArena;
+		std::vector<Tensor<float>> activations; /*	Views of the arena, one per layer.	*/
+		std::vector<Shape<IndexType>> activationsTransposedShape;
+		size_t planBatchSize = 0;
+		bool planTraining = false;
+
+		/*	Backpropagation buffers, reused between batches.	*/
+		Tensor<float> differentialError;
+		Tensor<float> previousDerivative;
+
+		/*	Gradients of every trainable layer, and the buffers of the layers without their own.	*/
+		std::map<const Layer<T> *, std::vector<Tensor<DType> *>> layerGradients;
+		std::map<const Layer<T> *, std::vector<Tensor<DType>>> gradientBuffers;
+
+		/**
+		 * @brief Compute the steps, the activation shapes and the lifetime of each activation, and
+		 * assign the activations to arena buffers.
+		 */
+		void planMemory(const size_t batchSize, const bool training, std::vector<ExecutionStep> &steps,
+						std::vector<Shape<IndexType>> &shapes, std::vector<size_t> &slotBuffer,
+						MemoryPlanner &planner) const {
+
+			steps.clear();
+			shapes.clear();
+
+			/*	Layer to slot lookup, only required while building the plan.	*/
+			std::map<const Layer<T> *, size_t> slots;
+
+			for (auto it = this->forwardSequence.begin(); it != this->forwardSequence.end(); it++) {
+				Layer<T> *current = (*it);
+
+				const size_t slot = shapes.size();
+				shapes.push_back(current->getBatchShape(static_cast<IndexType>(batchSize)));
+
+				/*	The whole chain writes a single slot, the output of the activation. Backpropagation computes
+				 *	the derivative of the activation from its output, unless it requires the input.	*/
+				const auto chain = this->layerFusion ? this->fusedChains.find(current) : this->fusedChains.end();
+				if (chain != this->fusedChains.end() && (!training || hasOutputDerivative(chain->second.activation))) {
+					steps.push_back({current, slots.at(current->getInputs()[0]), slot, chain->second.activation,
+									 chain->second.activationParameter});
+					slots[current] = slot;
+
+					while ((*it) != chain->second.last) {
+						it++;
+						slots[*it] = slot;
+					}
+					continue;
+				}
+
+				/*	Input layers only hold the batch.	*/
+				if (!this->is_input_layer(current)) {
+					steps.push_back({current, slots.at(current->getInputs()[0]), slot});
+				}
+				slots[current] = slot;
+			}
+
+			/*	Step each slot is written and last read. The batch is written at step 0.	*/
+			const size_t endOfPlan = steps.size() + 1;
+			std::vector<size_t> first(shapes.size(), 0);
+			std::vector<size_t> last(shapes.size(), 0);
+			std::vector<const ExecutionStep *> producer(shapes.size(), nullptr);
+
+			for (size_t i = 0; i < steps.size(); i++) {
+				const ExecutionStep &step = steps[i];
+				first[step.output] = i + 1;
+				last[step.output] = Math::max<size_t>(last[step.output], i + 1);
+				last[step.input] = Math::max<size_t>(last[step.input], i + 1);
+				producer[step.output] = &step;
+
+				/*	Backpropagation reads the input of every layer, except reshape.	*/
+				if (training && typeid(*step.layer) != typeid(Reshape)) {
+					last[step.input] = endOfPlan;
+				}
+				/*	And the output of a fused activation.	*/
+				if (training && step.activation != ActivationFunction::None) {
+					last[step.output] = endOfPlan;
+				}
+			}
+			/*	The result is read after the plan.	*/
+			last.back() = endOfPlan;
+
+			/*	Assign buffers, reusing the input buffer when the layer can run in-place.	*/
+			slotBuffer.assign(shapes.size(), 0);
+			for (size_t slot = 0; slot < shapes.size(); slot++) {
+				const size_t nrBytes = shapes[slot].getNrElements() * sizeof(float);
+				const ExecutionStep *step = producer[slot];
+
+				if (step != nullptr && step->layer->supports_inplace()) {
+					const size_t inputBuffer = slotBuffer[step->input];
+					if (planner.getLast(inputBuffer) == first[slot] && planner.getSize(inputBuffer) >= nrBytes) {
+						slotBuffer[slot] = inputBuffer;
+						planner.extend(inputBuffer, last[slot]);
+						continue;
+					}
+				}
+
+				slotBuffer[slot] = planner.addBuffer(nrBytes, first[slot], last[slot]);
+			}
+
+			planner.plan();
+		}
+
 	  private: /*	Internal data.	*/
 		std::list<Layer<DType> *> forwardSequence;
 		size_t nr_weights = 0;
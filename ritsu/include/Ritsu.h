@@ -17,7 +17,12 @@
 #include "RitsuDef.h"
 
 #include "Tensor.h"
+#include "TensorView.h"
+#include "core/CpuDispatch.h"
+#include "core/RuntimeConfig.h"
 #include "core/Shape.h"
+#include "core/ThreadPool.h"
+#include "core/VectorMath.h"
 
 #include "layers/Add.h"
 #include "layers/BatchNormalization.h"
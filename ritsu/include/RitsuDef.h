@@ -16,6 +16,7 @@
  */
 #pragma once
 #include <cstddef>
+#include <cstdint>
 #include <stdexcept>
 #include <system_error>
 
@@ -32,4 +33,12 @@ namespace Ritsu {
 	using InvalidPointerException = InvalidIndexException;
 	using SystemException = std::system_error;
 
+	/*	Number of elements and memory offsets of a tensor. 64-bit unless built with RITSU_32BIT_INDEX,
+	 *	the dimension of each axis of a shape is 32-bit regardless.	*/
+#ifdef RITSU_32BIT_INDEX
+	using SizeType = uint32_t;
+#else
+	using SizeType = size_t;
+#endif
+
 } // namespace Ritsu
\ No newline at end of file
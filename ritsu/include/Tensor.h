@@ -15,7 +15,15 @@
  */
 #pragma once
 #include "RitsuDef.h"
+#include "TensorPool.h"
+#include "core/AxisReduce.h"
+#include "core/Broadcast.h"
+#include "core/CpuDispatch.h"
+#include "core/Gemm.h"
 #include "core/Shape.h"
+#include "core/TensorExpression.h"
+#include "core/TensorSpan.h"
+#include "core/VectorMath.h"
 #include <algorithm>
 #include <atomic>
 #include <cassert>
@@ -25,6 +33,7 @@
 #include <initializer_list>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <omp.h>
 #include <ostream>
 #include <type_traits>
@@ -34,6 +43,102 @@
 
 namespace Ritsu {
 
+	/**
+	 * @brief Process wide tally of tensor buffer allocations, used to verify that hot paths,
+	 * such as a planned training step, do not allocate.
+	 */
+	class TensorAllocationCounter {
+	  public:
+		static size_t getCount() noexcept { return count.load(std::memory_order_relaxed); }
+		static size_t getBytes() noexcept { return bytes.load(std::memory_order_relaxed); }
+
+		static void reset() noexcept {
+			count.store(0, std::memory_order_relaxed);
+			bytes.store(0, std::memory_order_relaxed);
+		}
+
+		static void increment(const size_t nrBytes) noexcept {
+			count.fetch_add(1, std::memory_order_relaxed);
+			bytes.fetch_add(nrBytes, std::memory_order_relaxed);
+		}
+
+	  private:
+		static inline std::atomic<size_t> count{0};
+		static inline std::atomic<size_t> bytes{0};
+	};
+
+	/**
+	 * @brief Header in front of the memory of every tensor allocation, with an intrusive reference
+	 *	count shared by all tensors referencing the memory.
+	 *
+	 *	Tensors holding the memory by value (owners) share it until one of them is modified, which
+	 *	then copies the memory first (copy-on-write). Views, such as subsets, write through to the
+	 *	memory and only keep it alive.
+	 */
+	class TensorSharedBuffer {
+	  public:
+		static constexpr size_t HeaderSize = 64;
+
+		std::atomic_int32_t nrReferences{1}; /*	Owners and views referencing the memory.	*/
+		std::atomic_int32_t nrOwners{1};	 /*	Tensors holding the memory by value.	*/
+		MemoryAllocator *allocator = nullptr;
+		size_t allocationSize = 0; /*	Size in bytes of the allocation, header included.	*/
+
+		inline uint8_t *getData() noexcept { return reinterpret_cast<uint8_t *>(this) + HeaderSize; }
+
+		inline bool isShared() const noexcept { return this->nrOwners.load(std::memory_order_acquire) > 1; }
+		inline bool hasViews() const noexcept {
+			return this->nrReferences.load(std::memory_order_acquire) > this->nrOwners.load(std::memory_order_acquire);
+		}
+
+		inline void addOwner() noexcept {
+			this->nrReferences.fetch_add(1, std::memory_order_relaxed);
+			this->nrOwners.fetch_add(1, std::memory_order_relaxed);
+		}
+		inline void addView() noexcept { this->nrReferences.fetch_add(1, std::memory_order_relaxed); }
+
+		/**
+		 * @brief Allocate the header and size bytes of data, with a single owner.
+		 */
+		static TensorSharedBuffer *create(MemoryAllocator &allocator, const size_t size, const size_t alignment) {
+			const size_t allocationSize = HeaderSize + size;
+			void *memory = allocator.allocate(allocationSize, alignment);
+			if (memory == nullptr) {
+				throw RuntimeException("Failed to allocate tensor memory");
+			}
+
+			TensorSharedBuffer *buffer = new (memory) TensorSharedBuffer();
+			buffer->allocator = &allocator;
+			buffer->allocationSize = allocationSize;
+			return buffer;
+		}
+
+		/**
+		 * @brief Drop a reference, the memory is deallocated with the last one.
+		 */
+		static void release(TensorSharedBuffer *buffer, const bool owner, const size_t alignment) noexcept {
+			if (owner) {
+				buffer->nrOwners.fetch_sub(1, std::memory_order_acq_rel);
+			}
+			if (buffer->nrReferences.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				MemoryAllocator *allocator = buffer->allocator;
+				const size_t allocationSize = buffer->allocationSize;
+				buffer->~TensorSharedBuffer();
+				allocator->deallocate(buffer, allocationSize, alignment);
+			}
+		}
+
+		/**
+		 * @brief Lock serializing copy-on-write of the tensor, such that concurrent writes to the
+		 *	same tensor, as in a parallel loop, copy the memory once.
+		 */
+		static std::mutex &getLock(const void *tensor) noexcept {
+			static std::mutex locks[64];
+			return locks[(reinterpret_cast<uintptr_t>(tensor) >> 4) % 64];
+		}
+	};
+	static_assert(sizeof(TensorSharedBuffer) <= TensorSharedBuffer::HeaderSize, "Header must fit in front of data");
+
 	/**
 	 * @brief Multi dimensional array
 	 *
@@ -45,13 +150,16 @@ namespace Ritsu {
 		static constexpr unsigned int DTypeSize = sizeof(T);
 
 		/*	*/
-		using IndexType = unsigned int;
+		using IndexType = unsigned int; /*	Dimension of an axis.	*/
+		using SizeType = Ritsu::SizeType; /*	Number of elements and memory offsets.	*/
 		static constexpr const unsigned int IndexTypeSize = sizeof(IndexType);
 		static constexpr const unsigned int alignmentByte = alignment;
 		static constexpr const unsigned int alignmentWidth = alignment / DTypeSize;
 
 		static_assert(std::is_floating_point<DType>::value || std::is_integral<DType>::value,
 					  "Must be a decimal type(float/double/half) or integer.");
+		static_assert(TensorSharedBuffer::HeaderSize % alignment == 0,
+					  "Alignment must divide the header of the memory, for the data to be aligned.");
 
 	  public:
 		Tensor() = default;
@@ -97,12 +205,16 @@ namespace Ritsu {
 
 		Tensor(const Shape<IndexType> &newShape, const Shape<IndexType> &offsetShape, const Tensor &parent) {
 
+			/*	A view writes through, thus the parent memory must not be shared by value.	*/
+			const_cast<Tensor &>(parent).detach();
+
 			/*	*/
 			const size_t offsetMemory = offsetShape.getNrElements() * parent.getElementSize();
 			this->memoryBuffer.buffer.data = &parent.memoryBuffer.buffer.data[offsetMemory];
 
 			this->memoryBuffer.ownerUid = reinterpret_cast<size_t>(&parent.memoryBuffer);
 			this->memoryBuffer.uid = reinterpret_cast<size_t>(this);
+			this->attachView(parent);
 			/*	*/
 			this->memoryBuffer.allocationSize = newShape.getNrElements() * parent.getElementSize();
 			this->memoryBuffer.memoryShape = parent.memoryBuffer.memoryShape;
@@ -115,7 +227,10 @@ namespace Ritsu {
 		}
 
 		Tensor(const Tensor &other) {
-			if (other.getShape().getNrElements() > 0) {
+			if (other.isShareable()) {
+				/*	Copy-on-write, share until either is modified.	*/
+				this->share(other);
+			} else if (other.getShape().getNrElements() > 0) {
 				this->resizeBuffer(other.getShape(), other.memoryBuffer.element_size);
 
 				/*	Transfer data.	*/
@@ -136,7 +251,7 @@ namespace Ritsu {
 			/*	Copy attributes.	*/
 			this->NrElements = other.NrElements;
 			this->memoryBuffer.allocationSize = other.memoryBuffer.allocationSize;
-			this->memoryBuffer.nrReferences.store(other.memoryBuffer.nrReferences.load());
+			this->memoryBuffer.shared.store(other.memoryBuffer.shared.exchange(nullptr));
 			this->memoryBuffer.ownerUid = other.memoryBuffer.ownerUid;
 			this->memoryBuffer.uid = other.memoryBuffer.uid;
 			this->memoryBuffer.element_size = other.memoryBuffer.element_size;
@@ -144,6 +259,11 @@ namespace Ritsu {
 			this->typeinfo = other.typeinfo;
 		}
 
+		/**
+		 * @brief Construct a tensor by evaluating a lazy expression in a single pass.
+		 */
+		template <typename E> Tensor(const TensorExpression<E> &expression) { *this = expression; }
+
 		~Tensor() noexcept {
 			/*	*/
 			this->release();
@@ -151,31 +271,40 @@ namespace Ritsu {
 
 		void release() noexcept {
 
-			/*	*/
-			this->memoryBuffer.nrReferences.fetch_sub(1);
-
-			/*	Determine if the memory can be released.	*/
-			if (this->memoryBuffer.nrReferences.load() == 0 && this->ownAllocation() &&
-				this->memoryBuffer.buffer.data != nullptr) {
-
-				free(this->memoryBuffer.buffer.data);
-				this->memoryBuffer.buffer.data = nullptr;
+			/*	Drop the reference, the last one releases the memory.	*/
+			TensorSharedBuffer *buffer = this->memoryBuffer.shared.exchange(nullptr);
+			if (buffer != nullptr) {
+				TensorSharedBuffer::release(buffer, this->ownAllocation(), alignmentByte);
 			}
+			this->memoryBuffer.buffer.data = nullptr;
 		}
 
 		auto &operator=(const Tensor &other) {
-			/*	*/
-			if (*this == other) {
+			/*	Self assignment, or same memory with the same shape.	*/
+			if (this == &other || (this->memoryBuffer.buffer.data == other.memoryBuffer.buffer.data &&
+								   this->getShape() == other.getShape())) {
 				return *this;
 			}
 
 			if (other.getShape().getNrElements() > 0) {
+
+				/*	Share unless this already has memory of its own for the data, such as preallocated.	*/
+				TensorSharedBuffer *buffer = this->memoryBuffer.shared.load(std::memory_order_acquire);
+				const bool ownMemory = buffer != nullptr && this->ownAllocation() && !buffer->isShared() &&
+									   this->memoryBuffer.allocationSize == Math::align<size_t>(other.getDatSize(), alignmentByte);
+
+				if (!ownMemory && other.isShareable() && (this->memoryBuffer.buffer.data == nullptr || this->ownAllocation())) {
+					this->release();
+					this->share(other);
+					return *this;
+				}
+
 				/*	*/
 				this->resizeBuffer(other.getShape(), other.memoryBuffer.element_size);
 
 				/*	*/
 				const size_t dataSizeInBytes = other.getDatSize();
-				std::memcpy(this->memoryBuffer.buffer.data, other.memoryBuffer.buffer.data, dataSizeInBytes);
+				std::memcpy(this->getRawData<uint8_t>(), other.memoryBuffer.buffer.data, dataSizeInBytes);
 				this->typeinfo = other.typeinfo;
 			}
 
@@ -183,6 +312,12 @@ namespace Ritsu {
 		}
 
 		auto &operator=(Tensor &&other) noexcept {
+			/*	Keep persistent memory persistent, copy out of transient memory such as an arena.	*/
+			if (other.isTransient() && this->memoryBuffer.buffer.data != nullptr && this->ownAllocation() &&
+				!this->isTransient()) {
+				return *this = static_cast<const Tensor &>(other);
+			}
+
 			this->release();
 
 			/*	*/
@@ -192,7 +327,7 @@ namespace Ritsu {
 			/*	*/
 			this->NrElements = other.NrElements;
 			this->memoryBuffer.allocationSize = other.memoryBuffer.allocationSize;
-			this->memoryBuffer.nrReferences.store(other.memoryBuffer.nrReferences.load());
+			this->memoryBuffer.shared.store(other.memoryBuffer.shared.exchange(nullptr));
 			this->memoryBuffer.element_size = other.memoryBuffer.element_size;
 			this->memoryBuffer.memoryShape = std::move(other.memoryBuffer.memoryShape);
 
@@ -206,6 +341,44 @@ namespace Ritsu {
 
 		Tensor copy() const noexcept { return *this; }
 
+		/**
+		 * @brief Evaluate a lazy expression into the tensor, one fused loop over all elements
+		 *	without any intermediate tensor. The buffer is reused when the shape already match.
+		 */
+		template <typename E> Tensor &operator=(const TensorExpression<E> &expression) {
+			const E &expr = expression.derived();
+
+			if (this->memoryBuffer.buffer.data == nullptr || this->getShape() != expr.getShape()) {
+				this->resizeBuffer(expr.getShape(), DTypeSize);
+				this->typeinfo = &typeid(DType);
+			}
+
+			const TensorSpan<DType> output = this->span();
+			const size_t nrElements = expr.getNrElements();
+
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t index = begin; index < end; index++) {
+					output[index] = static_cast<DType>(expr.eval(index));
+				}
+			});
+			return *this;
+		}
+
+		template <typename E> Tensor &operator+=(const TensorExpression<E> &expression) {
+			return *this = lazy(*this) + expression;
+		}
+		template <typename E> Tensor &operator-=(const TensorExpression<E> &expression) {
+			return *this = lazy(*this) - expression;
+		}
+		template <typename E> Tensor &operator*=(const TensorExpression<E> &expression) {
+			return *this = lazy(*this) * expression;
+		}
+		template <typename E> Tensor &operator/=(const TensorExpression<E> &expression) {
+			return *this = lazy(*this) / expression;
+		}
+
+
 		bool operator==(const Tensor &tensor) const noexcept {
 
 			/*	Same address => equal.	*/
@@ -253,63 +426,32 @@ namespace Ritsu {
 		const std::type_info &getDType() const noexcept { return *this->typeinfo; }
 
 		Tensor &operator-=(const Tensor &tensor) {
-			const IndexType nrElements = this->getNrElements();
-
-			assert(nrElements == tensor.getNrElements());
-
-#pragma omp parallel for simd shared(tensor) simdlen(alignmentWidth)
-			for (IndexType index = 0; index < nrElements; index++) {
-				this->getValue<DType>(index) -= tensor.getValue<DType>(index);
-			}
-			return *this;
+			return this->broadcastInplace(tensor, [](const DType a, const DType b) { return a - b; });
 		}
 
 		Tensor &operator+=(const Tensor &tensor) {
-			const IndexType nrElements = this->getNrElements();
-
-			assert(nrElements == tensor.getNrElements());
-
-			IndexType index = 0;
-
-#pragma omp for simd simdlen(alignmentWidth)
-			for (index = 0; index < nrElements; index++) {
-				this->getRawData()[index] += tensor.getRawData()[index];
-			}
-			return *this;
+			return this->broadcastInplace(tensor, [](const DType a, const DType b) { return a + b; });
 		}
 
 		Tensor &operator*=(const Tensor &tensor) {
-			const IndexType nrElements = this->getNrElements();
-
-			assert(nrElements == tensor.getNrElements());
-
-#pragma omp parallel for simd shared(tensor) simdlen(alignmentWidth)
-			for (IndexType index = 0; index < nrElements; index++) {
-				this->getValue<DType>(index) *= tensor.getValue<DType>(index);
-			}
-			return *this;
+			return this->broadcastInplace(tensor, [](const DType a, const DType b) { return a * b; });
 		}
 
 		Tensor &operator*=(const DType &value) {
-			const IndexType nrElements = this->getNrElements();
+			const SizeType nrElements = this->getNrElements();
+			const TensorSpan<DType> data = this->span();
 
-#pragma omp parallel for simd simdlen(alignmentWidth)
-			for (IndexType index = 0; index < nrElements; index++) {
-				this->getValue<DType>(index) *= value;
-			}
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t index = begin; index < end; index++) {
+					data[index] *= value;
+				}
+			});
 			return *this;
 		}
 
 		Tensor &operator/=(const Tensor &tensor) {
-			const IndexType nrElements = this->getNrElements();
-
-			assert(nrElements == tensor.getNrElements());
-
-#pragma omp parallel for shared(tensor)
-			for (IndexType index = 0; index < nrElements; index++) {
-				this->getValue<DType>(index) /= tensor.getValue<DType>(index);
-			}
-			return *this;
+			return this->broadcastInplace(tensor, [](const DType a, const DType b) { return a / b; });
 		}
 
 		template <class... Arg> inline auto &operator()(const Arg &...location) const {
@@ -328,9 +470,9 @@ namespace Ritsu {
 						  "Must be a decimal type(float/double/half) or integer.");
 			static_assert(!std::is_pointer<U>::value, "Can not be pointer");
 
-			const IndexType index = this->computeShape2Index(location);
+			const SizeType index = this->computeShape2Index(location);
 
-			return Tensor::getValue<U>(static_cast<IndexType>(index));
+			return Tensor::getValue<U>(index);
 		}
 
 		/**
@@ -341,27 +483,30 @@ namespace Ritsu {
 			static_assert(std::is_floating_point<U>::value || std::is_integral<U>::value,
 						  "Must be a decimal type(float/double/half) or integer.");
 			static_assert(!std::is_pointer<U>::value, "Can not be pointer");
-			const IndexType index = this->computeShape2Index(location);
-			return Tensor::getValue<U>(static_cast<IndexType>(index));
+			const SizeType index = this->computeShape2Index(location);
+			return Tensor::getValue<U>(index);
 		}
 
 		/**
 		 * @brief Get the Value object
 		 */
 #pragma omp declare simd simdlen(alignmentWidth)
-		template <typename U = DType> inline U &getValue(const IndexType index) noexcept {
+		template <typename U = DType> inline U &getValue(const SizeType index) noexcept {
 			static_assert(std::is_floating_point<U>::value || std::is_integral<U>::value,
 						  "Must be a decimal type(float/double/half) or integer.");
 			static_assert(!std::is_pointer<U>::value, "Can not be pointer");
 
+			/*	Copy-on-write.	*/
+			this->detach();
+
 			/*	*/
-			const IndexType acuIndex = Shape<IndexType>::getIndexMemoryOffset(this->getShape(), index);
+			const SizeType acuIndex = Shape<IndexType>::getIndexMemoryOffset(this->getShape(), index);
 
 			/*	*/
 			assert(acuIndex < this->getNrElements());
 
 			/*	*/
-			const IndexType Offset = acuIndex * this->memoryBuffer.element_size;
+			const SizeType Offset = acuIndex * this->memoryBuffer.element_size;
 			U *addr = reinterpret_cast<U *>(&this->memoryBuffer.buffer.data[Offset]);
 			return *addr;
 		}
@@ -370,15 +515,15 @@ namespace Ritsu {
 		 * @brief Get the Value object
 		 */
 #pragma omp declare simd simdlen(alignmentWidth)
-		template <typename U = DType> inline U getValue(const IndexType index) const noexcept {
+		template <typename U = DType> inline U getValue(const SizeType index) const noexcept {
 			static_assert(std::is_floating_point<U>::value || std::is_integral<U>::value,
 						  "Must be a decimal type(float/double/half) or integer.");
 			static_assert(!std::is_pointer<U>::value, "Can not be pointer");
 
-			const IndexType acuIndex = Shape<IndexType>::getIndexMemoryOffset(this->getShape(), index);
+			const SizeType acuIndex = Shape<IndexType>::getIndexMemoryOffset(this->getShape(), index);
 
 			assert(acuIndex < this->getNrElements());
-			const IndexType Offset = acuIndex * this->memoryBuffer.element_size;
+			const SizeType Offset = acuIndex * this->memoryBuffer.element_size;
 			const U *addr = reinterpret_cast<const U *>(&this->memoryBuffer.buffer.data[Offset]);
 			return *addr;
 		}
@@ -387,12 +532,12 @@ namespace Ritsu {
 		 * @brief Get the Value object
 		 */
 #pragma omp declare simd simdlen(alignmentWidth)
-		template <typename U = DType> inline U *getValuePtr(const IndexType index) const noexcept {
+		template <typename U = DType> inline U *getValuePtr(const SizeType index) const noexcept {
 			static_assert(std::is_floating_point<U>::value || std::is_integral<U>::value,
 						  "Must be a decimal type(float/double/half) or integer.");
 			static_assert(!std::is_pointer<U>::value, "Can not be pointer");
 
-			const IndexType acuIndex = Shape<IndexType>::getIndexMemoryOffset(this->getShape(), index);
+			const SizeType acuIndex = Shape<IndexType>::getIndexMemoryOffset(this->getShape(), index);
 
 			assert(acuIndex < this->getNrElements());
 			U *addr =
@@ -401,129 +546,103 @@ namespace Ritsu {
 		}
 
 		template <typename U> Tensor &operator+(const U &tensor) {
-			const IndexType nrElements = this->getNrElements();
+			const SizeType nrElements = this->getNrElements();
 
 			//TODO: if memory axis align
 			/*	Primitive Type Addition.	*/
 			if constexpr (std::is_fundamental<U>::value) {
 
-				IndexType index = 0;
-#pragma omp for simd simdlen(alignmentWidth)
-				for (index = 0; index < nrElements; index++) {
-					this->getRawData()[index] = tensor + this->getRawData()[index];
-				}
+				const TensorSpan<DType> data = this->span();
 
-			} else if constexpr (std::is_base_of_v<U, Tensor<DType>>) {
+				CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+					for (size_t index = begin; index < end; index++) {
+						data[index] = tensor + data[index];
+					}
+				});
 
-				IndexType index = 0;
-#pragma omp for simd simdlen(alignmentWidth)
-				for (index = 0; index < nrElements; index++) {
-					this->getRawData()[index] =
-						this->getRawData()[index] + tensor.getRawData()[index];
-				}
+			} else if constexpr (std::is_base_of_v<U, Tensor<DType>>) {
+				this->broadcastInplace(tensor, [](const DType a, const DType b) { return a + b; });
 			}
 
 			return *this;
 		}
 
 		Tensor &operator-() noexcept {
-			const IndexType nrElements = this->getNrElements();
+			const SizeType nrElements = this->getNrElements();
+			const TensorSpan<DType> data = this->span();
 
-#pragma omp parallel for simd
-			for (IndexType index = 0; index < nrElements; index++) {
-				this->getValue<DType>(index) = -this->getRawData()[index];
-			}
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t index = begin; index < end; index++) {
+					data[index] = -data[index];
+				}
+			});
 
 			return *this;
 		}
 
 		Tensor operator-() const noexcept {
 			Tensor output(getShape());
-			const IndexType nrElements = this->getNrElements();
+			const SizeType nrElements = this->getNrElements();
+			const TensorSpan<DType, alignment> outputData = output.alignedSpan();
+			const TensorSpan<const DType> data = this->span();
 
-#pragma omp parallel for shared(output)
-			for (IndexType index = 0; index < nrElements; index++) {
-				output.getRawData()[index] = -this->getRawData()[index];
-			}
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t index = begin; index < end; index++) {
+					outputData[index] = -data[index];
+				}
+			});
 
 			return output;
 		}
 
-		Tensor &operator-(const Tensor &tensor) noexcept {
-			const IndexType nrElements = this->getNrElements();
-
-			assert(nrElements == tensor.getNrElements());
-
-#pragma omp parallel for shared(tensor)
-			for (IndexType index = 0; index < nrElements; index++) {
-				this->getValue<DType>(index) = this->getValue<DType>(index) - tensor.getValue<DType>(index);
-			}
-
-			return *this;
+		Tensor &operator-(const Tensor &tensor) {
+			return this->broadcastInplace(tensor, [](const DType a, const DType b) { return a - b; });
 		}
 
-		Tensor operator-(const Tensor &tensor) const noexcept {
-			Tensor tmp = Tensor(tensor.getShape());
-			IndexType nrElements = this->getNrElements();
-
-			assert(nrElements == tensor.getNrElements());
-
-#pragma omp parallel for shared(tensor)
-			for (IndexType index = 0; index < nrElements; index++) {
-				tmp.getValue<DType>(index) = this->getValue<DType>(index) - tensor.getValue<DType>(index);
-			}
-
+		Tensor operator-(const Tensor &tensor) const {
+			Tensor tmp;
+			Tensor::broadcastOperation(*this, tensor, tmp, [](const DType a, const DType b) { return a - b; });
 			return tmp;
 		}
 
 		friend Tensor &operator-(const DType value, Tensor &tensor) noexcept {
-			const IndexType nrElements = tensor.getNrElements();
+			const SizeType nrElements = tensor.getNrElements();
+			const TensorSpan<DType> data = tensor.span();
 
-#pragma omp parallel for shared(tensor)
-			for (IndexType index = 0; index < nrElements; index++) {
-				tensor.getValue<DType>(index) = value - tensor.getValue<DType>(index);
-			}
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t index = begin; index < end; index++) {
+					data[index] = value - data[index];
+				}
+			});
 			return tensor;
 		}
 
 		friend Tensor operator-(const DType value, const Tensor &tensor) noexcept {
-			const IndexType nrElements = tensor.getNrElements();
-			Tensor tmp = tensor;
+			const SizeType nrElements = tensor.getNrElements();
+			Tensor tmp(tensor.getShape());
+			const TensorSpan<DType, alignment> output = tmp.alignedSpan();
+			const TensorSpan<const DType> data = tensor.span();
 
-#pragma omp parallel for shared(tensor)
-			for (IndexType index = 0; index < nrElements; index++) {
-				tmp.getValue<DType>(index) = value - tensor.getValue<DType>(index);
-			}
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t index = begin; index < end; index++) {
+					output[index] = value - data[index];
+				}
+			});
 			return tmp;
 		}
 
-		Tensor &operator*(const Tensor &tensor) noexcept {
-			const IndexType nrElements = this->getNrElements();
-
-			assert(nrElements == tensor.getNrElements());
-
-			IndexType index = 0;
-#pragma omp for simd simdlen(alignmentWidth)
-			for (index = 0; index < nrElements; index++) {
-				this->getValue<DType>(index) = this->getValue<DType>(index) * tensor.getValue<DType>(index);
-			}
-
-			return *this;
+		Tensor &operator*(const Tensor &tensor) {
+			return this->broadcastInplace(tensor, [](const DType a, const DType b) { return a * b; });
 		}
 
 		friend Tensor operator*(const Tensor &tensorA, const Tensor &tensorB) {
-
-			Tensor output(tensorA.getShape());
-			const IndexType nrElements = tensorA.getNrElements();
-
-			assert(nrElements == tensorB.getNrElements());
-
-			IndexType index = 0;
-#pragma omp for simd simdlen(alignmentWidth)
-			for (index = 0; index < nrElements; index++) {
-				output.getValue<DType>(index) = tensorA.getValue<DType>(index) * tensorB.getValue<DType>(index);
-			}
-
+			Tensor output;
+			Tensor::broadcastOperation(tensorA, tensorB, output, [](const DType a, const DType b) { return a * b; });
 			return output;
 		}
 
@@ -531,15 +650,15 @@ namespace Ritsu {
 			static_assert(std::is_floating_point<U>::value || std::is_integral<U>::value,
 						  "Type Must Support addition operation.");
 
-			const IndexType nrElements = this->getNrElements();
+			const SizeType nrElements = this->getNrElements();
+			const TensorSpan<DType> data = this->span();
 
-			IndexType index = 0;
-#pragma omp for simd simdlen(alignmentWidth)
-			for (index = 0; index < nrElements; index++) {
-				const DType value = this->getValue<DType>(index);
-				const DType result = value * vec;
-				this->getValue<DType>(index) = result;
-			}
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t index = begin; index < end; index++) {
+					data[index] = data[index] * vec;
+				}
+			});
 
 			return *this;
 		}
@@ -547,16 +666,18 @@ namespace Ritsu {
 		template <typename U> Tensor operator*(const U vec) const noexcept {
 			static_assert(std::is_floating_point<U>::value || std::is_integral<U>::value,
 						  "Type Must Support addition operation.");
-			Tensor tmp = *this;
+			Tensor tmp(this->getShape());
 
-			const IndexType nrElements = this->getNrElements();
+			const SizeType nrElements = this->getNrElements();
+			const TensorSpan<DType, alignment> output = tmp.alignedSpan();
+			const TensorSpan<const DType> data = this->span();
 
-#pragma omp for simd simdlen(alignmentWidth)
-			for (IndexType index = 0; index < nrElements; index++) {
-				const DType value = this->getValue<DType>(index);
-				const DType result = value * vec;
-				tmp.getValue<DType>(index) = result;
-			}
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t index = begin; index < end; index++) {
+					output[index] = data[index] * vec;
+				}
+			});
 
 			return tmp;
 		}
@@ -571,29 +692,25 @@ namespace Ritsu {
 		}
 
 		Tensor &operator/(const Tensor &tensor) {
-			const size_t nrElements = this->getNrElements();
-
-			assert(nrElements == tensor.getNrElements());
-
-#pragma omp parallel for shared(tensor)
-			for (size_t index = 0; index < nrElements; index++) {
-				this->getValue<DType>(index) = this->getValue<DType>(index) / tensor.template getValue<DType>(index);
-			}
-			return *this;
+			return this->broadcastInplace(tensor, [](const DType a, const DType b) { return a / b; });
 		}
 
-		Tensor &operator/(const Tensor &tensor) const {
-			Tensor copy = *this;
-			return copy / tensor;
+		Tensor operator/(const Tensor &tensor) const {
+			Tensor output;
+			Tensor::broadcastOperation(*this, tensor, output, [](const DType a, const DType b) { return a / b; });
+			return output;
 		}
 
 		Tensor &operator/(const DType value) {
-			const IndexType nrElements = this->getNrElements();
+			const SizeType nrElements = this->getNrElements();
+			const TensorSpan<DType> data = this->span();
 
-#pragma omp parallel for
-			for (IndexType index = 0; index < nrElements; index++) {
-				this->getValue<DType>(index) = this->getValue<DType>(index) / value;
-			}
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t index = begin; index < end; index++) {
+					data[index] = data[index] / value;
+				}
+			});
 
 			return *this;
 		}
@@ -602,19 +719,27 @@ namespace Ritsu {
 			/*	Transfer data.	*/
 			assert(other.getShape().getNrElements() >= this->getShape().getNrElements());
 
+			/*	Same memory, nothing to transfer.	*/
+			if (this->memoryBuffer.buffer.data == other.memoryBuffer.buffer.data) {
+				return *this;
+			}
+
 			const size_t dataSizeInBytes = other.getDatSize();
-			std::memcpy(this->memoryBuffer.buffer.data, other.memoryBuffer.buffer.data, dataSizeInBytes);
+			std::memcpy(this->getRawData<uint8_t>(), other.memoryBuffer.buffer.data, dataSizeInBytes);
 
 			return *this;
 		}
 
 		template <typename U = DType> Tensor<DType> &assignInitValue(const U initValue) noexcept {
-			const IndexType nrElements = this->getNrElements();
+			const SizeType nrElements = this->getNrElements();
+			const TensorSpan<DType> data = this->span();
 
-#pragma omp for simd
-			for (IndexType i = 0; i < nrElements; i++) {
-				this->getValue<DType>(i) = static_cast<DType>(initValue);
-			}
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					data[i] = static_cast<DType>(initValue);
+				}
+			});
 			return *this;
 		}
 
@@ -633,9 +758,12 @@ namespace Ritsu {
 				throw InvalidArgumentException("Invalid Start/End and Shape");
 			}
 
-			//	this->memoryBuffer.nrReferences.fetch_add(1);
+			const_cast<Tensor *>(this)->detach();
 			Tensor subset = Tensor(static_cast<uint8_t *>(&this->memoryBuffer.buffer.data[start_index * DTypeSize]),
-								   end_index - start_index, newShape, this->memoryBuffer.element_size);
+								   (end_index - start_index) * this->memoryBuffer.element_size, newShape,
+								   this->memoryBuffer.element_size);
+			/*	The subset keeps the memory alive.	*/
+			subset.attachView(*this);
 
 			return subset;
 		}
@@ -664,6 +792,13 @@ namespace Ritsu {
 			return *this;
 		}
 
+		/**
+		 * @brief Non-owning one dimensional view of the same memory, zero-copy.
+		 */
+		Tensor flatten() const {
+			return this->reshape(Shape<IndexType>({static_cast<IndexType>(this->getNrElements())}));
+		}
+
 		Tensor &reduce() noexcept {
 			this->shape.reduce();
 			return *this;
@@ -694,14 +829,16 @@ namespace Ritsu {
 		}
 
 		Tensor &round() noexcept {
-			const IndexType nrElements = this->getNrElements();
+			const SizeType nrElements = this->getNrElements();
+			const TensorSpan<DType> data = this->span();
 
-#pragma omp parallel for default(shared)
-			for (IndexType index = 0; index < nrElements; index++) {
-				if constexpr (std::is_floating_point<DType>()) { //|| std::is_integral<DType>()) {
-					const DType value = std::round(this->getValue<DType>(index));
-					this->getValue<DType>(index) = value;
-				}
+			if constexpr (std::is_floating_point<DType>()) { //|| std::is_integral<DType>()) {
+				CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+					for (size_t index = begin; index < end; index++) {
+						data[index] = std::round(data[index]);
+					}
+				});
 			}
 			return *this;
 		}
@@ -719,13 +856,15 @@ namespace Ritsu {
 		inline Tensor less(const Tensor &tensor) const noexcept { return Tensor::less(*this, tensor); }
 
 		Tensor &sqrt() noexcept {
-			const IndexType nrElements = this->getNrElements();
+			const SizeType nrElements = this->getNrElements();
+			const TensorSpan<DType> data = this->span();
 
-			size_t index = 0;
-#pragma omp parallel for simd default(shared)
-			for (index = 0; index < nrElements; index++) {
-				this->getRawData()[index] = static_cast<DType>(std::sqrt(this->getRawData()[index]));
-			}
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t index = begin; index < end; index++) {
+					data[index] = static_cast<DType>(std::sqrt(data[index]));
+				}
+			});
 			return *this;
 		}
 
@@ -759,12 +898,15 @@ namespace Ritsu {
 		 * @brief
 		 */
 		Tensor &clip(const DType min, const DType max) noexcept {
-			const IndexType elements = this->getNrElements();
+			const SizeType elements = this->getNrElements();
+			const TensorSpan<DType> data = this->span();
 
-#pragma omp simd simdlen(alignmentWidth)
-			for (IndexType i = 0; i < elements; i++) {
-				this->getRawData()[i] = Math::clamp<DType>(this->getRawData()[i], min, max);
-			}
+			CpuDispatch::parallelFor(elements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					data[i] = Math::clamp<DType>(data[i], min, max);
+				}
+			});
 			return *this;
 		}
 
@@ -772,15 +914,18 @@ namespace Ritsu {
 		 * @brief
 		 */
 		DType min() const noexcept {
-			DType minValue = std::numeric_limits<DType>::max();
-			const IndexType elements = this->getNrElements();
-
-#pragma omp simd reduction(min : minValue) simdlen(alignmentWidth)
-			for (IndexType i = 0; i < elements; i++) {
-				minValue = Math::min<DType>(this->getRawData()[i], minValue);
-			}
-
-			return minValue;
+			const DType *data = this->getRawData();
+
+			return CpuDispatch::parallelReduce<DType>(
+				this->getNrElements(),
+				[data](const size_t begin, const size_t end) {
+					DType minValue = std::numeric_limits<DType>::max();
+					for (size_t i = begin; i < end; i++) {
+						minValue = Math::min<DType>(data[i], minValue);
+					}
+					return minValue;
+				},
+				[](const DType a, const DType b) { return Math::min<DType>(a, b); });
 		}
 
 		/**
@@ -790,16 +935,18 @@ namespace Ritsu {
 		 */
 		DType max() const noexcept {
 
-			DType maxValue = std::numeric_limits<DType>::min();
-
-			const IndexType elements = this->getNrElements();
-
-#pragma omp parallel for simd default(shared) reduction(max : maxValue) simdlen(alignmentWidth)
-			for (IndexType i = 0; i < elements; i++) {
-				maxValue = Math::max<DType>(this->getRawData()[i], maxValue);
-			}
+			const DType *data = this->getRawData();
 
-			return maxValue;
+			return CpuDispatch::parallelReduce<DType>(
+				this->getNrElements(),
+				[data](const size_t begin, const size_t end) {
+					DType maxValue = std::numeric_limits<DType>::min();
+					for (size_t i = begin; i < end; i++) {
+						maxValue = Math::max<DType>(data[i], maxValue);
+					}
+					return maxValue;
+				},
+				[](const DType a, const DType b) { return Math::max<DType>(a, b); });
 		}
 
 		Tensor &concatenate(const Tensor &tensor, const int axis = -1) {
@@ -868,23 +1015,33 @@ namespace Ritsu {
 
 				Tensor<U> tmp = Tensor<U>(this->getShape());
 
-				// #pragma omp parallel for simd
-				for (size_t i = 0; i < this->getNrElements(); i++) {
-					const DType dvalue = this->getValue<DType>(i);
-					tmp.template getValue<U>(i) = static_cast<U>(dvalue);
-				}
+				const SizeType nrElements = this->getNrElements();
+				const TensorSpan<const DType> source = static_cast<const Tensor &>(*this).span();
+				const auto dest = tmp.template alignedSpan<U>();
+
+				CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+					for (size_t i = begin; i < end; i++) {
+						dest[i] = static_cast<U>(source[i]);
+					}
+				});
 
 				Tensor<U> &ref = reinterpret_cast<Tensor<U> &>(*this);
 				ref = std::move(tmp);
 				return ref;
 			}
 
-			/*	*/
+			/*	Same element size, convert in place.	*/
+			const SizeType nrElements = this->getNrElements();
+			const TensorSpan<DType> data = this->span();
+			U *dest = reinterpret_cast<U *>(data.data());
 			this->memoryBuffer.element_size = cast_element_size;
-#pragma omp parallel for simd
-			for (size_t i = 0; i < this->getNrElements(); i++) {
-				this->getValue<U>(i) = static_cast<U>(this->getValue<DType>(i));
-			}
+
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					dest[i] = static_cast<U>(data[i]);
+				}
+			});
 
 			Tensor<U> &ref = reinterpret_cast<Tensor<U> &>(*this);
 			// Convert value.
@@ -952,16 +1109,33 @@ namespace Ritsu {
 				}
 			}
 
-			/*	*/
-			this->memoryBuffer.buffer.data =
-				static_cast<uint8_t *>(realloc(this->memoryBuffer.buffer.data, nrBytesAllocateAligned));
+			/*	Reuse the current allocation if not shared and the allocator reserved enough for the new size.	*/
+			uint8_t *previous = this->memoryBuffer.buffer.data;
+			TensorSharedBuffer *previousBuffer = this->memoryBuffer.shared.load(std::memory_order_acquire);
+			MemoryAllocator *allocator =
+				previousBuffer != nullptr ? previousBuffer->allocator : &MemoryAllocator::getDefault();
+			const size_t allocationSize = TensorSharedBuffer::HeaderSize + nrBytesAllocateAligned;
 
-			this->memoryBuffer.allocationSize = nrBytesAllocateAligned;
+			if (previousBuffer == nullptr || previousBuffer->isShared() ||
+				allocator->getUsableSize(previousBuffer->allocationSize, alignmentByte) !=
+					allocator->getUsableSize(allocationSize, alignmentByte)) {
+
+				TensorSharedBuffer *buffer = TensorSharedBuffer::create(*allocator, nrBytesAllocateAligned, alignmentByte);
+
+				/*	Preserve the content, as realloc. Views of the previous memory keep it alive.	*/
+				if (previousBuffer != nullptr) {
+					std::memcpy(buffer->getData(), previous,
+								Math::min(this->memoryBuffer.allocationSize, nrBytesAllocateAligned));
+					TensorSharedBuffer::release(previousBuffer, true, alignmentByte);
+				}
 
-			if (this->memoryBuffer.buffer.data == nullptr) {
-				throw RuntimeException("Error");
+				this->memoryBuffer.buffer.data = buffer->getData();
+				this->memoryBuffer.shared.store(buffer, std::memory_order_release);
+				TensorAllocationCounter::increment(nrBytesAllocateAligned);
 			}
 
+			this->memoryBuffer.allocationSize = nrBytesAllocateAligned;
+
 			this->shape = shape;
 			this->NrElements = total_nr_elements;
 			this->memoryBuffer.element_size = elementSize;
@@ -970,10 +1144,10 @@ namespace Ritsu {
 
 		friend std::ostream &operator<<(std::ostream &stream, const Tensor &tensor) noexcept {
 
-			const IndexType number_elements = tensor.getNrElements();
+			const SizeType number_elements = tensor.getNrElements();
 
 			/*	*/
-			for (IndexType index = 0; index < number_elements; index++) {
+			for (SizeType index = 0; index < number_elements; index++) {
 
 				DType value = tensor.getValue<DType>(index);
 
@@ -983,7 +1157,11 @@ namespace Ritsu {
 			return stream;
 		}
 
-		inline constexpr IndexType computeShape2Index(const std::vector<IndexType> &dim) const noexcept {
+		inline constexpr SizeType computeShape2Index(const std::vector<IndexType> &dim) const noexcept {
+			return Shape<IndexType>::computeIndex(dim, this->shape);
+		}
+
+		inline SizeType computeShape2Index(const std::initializer_list<IndexType> &dim) const noexcept {
 			return Shape<IndexType>::computeIndex(dim, this->shape);
 		}
 
@@ -1000,16 +1178,47 @@ namespace Ritsu {
 		 *
 		 */
 #pragma omp declare simd
-		template <typename U = DType> inline constexpr U *getRawData() noexcept {
+		template <typename U = DType> inline U *getRawData() noexcept {
 			static_assert(!std::is_pointer<U>::value, "Can not be pointer");
+
+			/*	Copy-on-write.	*/
+			this->detach();
 			return reinterpret_cast<U *>(this->memoryBuffer.buffer.data);
 		}
 
+		/**
+		 * @brief Typed span of the elements, for loops that vectorize. Writable spans detach
+		 *	shared memory, as getRawData.
+		 */
+		template <typename U = DType> inline TensorSpan<U> span() noexcept {
+			assert(this->getNrElements() == 0 || sizeof(U) == this->memoryBuffer.element_size);
+			return TensorSpan<U>(this->getRawData<U>(), this->getNrElements());
+		}
+
+		template <typename U = DType> inline TensorSpan<const U> span() const noexcept {
+			assert(this->getNrElements() == 0 || sizeof(U) == this->memoryBuffer.element_size);
+			return TensorSpan<const U>(this->getRawData<U>(), this->getNrElements());
+		}
+
+		/**
+		 * @brief Span aligned to the alignment of the tensor. Only valid for memory allocated by
+		 *	the tensor, subsets and external memory are not necessarily aligned.
+		 */
+		template <typename U = DType> inline TensorSpan<U, alignment> alignedSpan() noexcept {
+			assert(this->ownAllocation());
+			return TensorSpan<U, alignment>(this->getRawData<U>(), this->getNrElements());
+		}
+
+		template <typename U = DType> inline TensorSpan<const U, alignment> alignedSpan() const noexcept {
+			assert(this->ownAllocation());
+			return TensorSpan<const U, alignment>(this->getRawData<U>(), this->getNrElements());
+		}
+
 		inline const Shape<IndexType> &getShape() const noexcept { return this->shape; }
 
-		inline IndexType getNrElements() const noexcept { return this->NrElements; }
+		inline SizeType getNrElements() const noexcept { return this->NrElements; }
 		inline size_t getDatSize() const noexcept { return this->getNrElements() * this->memoryBuffer.element_size; }
-		inline IndexType getInternalDatSize() const noexcept { return this->memoryBuffer.allocationSize; }
+		inline size_t getInternalDatSize() const noexcept { return this->memoryBuffer.allocationSize; }
 		inline uint32_t getElementSize() const noexcept { return this->memoryBuffer.element_size; }
 
 		inline size_t getUID() const noexcept { return reinterpret_cast<size_t>(this->memoryBuffer.buffer.ddata); }
@@ -1029,7 +1238,47 @@ namespace Ritsu {
 			return *this;
 		}
 
+		/**
+		 * @brief Non-owning view of the same memory in a new shape, zero-copy.
+		 */
+		Tensor reshape(const Shape<IndexType> &newShape) const {
+			if (newShape.getNrElements() != this->getNrElements()) {
+				throw InvalidArgumentException("Reshape must preserve the number of elements.");
+			}
+			const_cast<Tensor *>(this)->detach();
+			Tensor view(this->memoryBuffer.buffer.data, this->getDatSize(), newShape, this->memoryBuffer.element_size);
+			view.attachView(*this);
+			return view;
+		}
+
 	  protected:
+		/**
+		 * @brief Compute this = op(this, tensor) elementwise, broadcasting the tensor to the shape of
+		 *	this tensor.
+		 */
+		template <typename Op> Tensor &broadcastInplace(const Tensor &tensor, Op op) {
+			/*	Same number of elements, element by element.	*/
+			if (this->getNrElements() == tensor.getNrElements()) {
+				Broadcast<IndexType>::apply(this->getRawData(), this->getShape(), tensor.getRawData(),
+											this->getShape(), this->getRawData(), this->getShape(), op);
+				return *this;
+			}
+
+			if (!Broadcast<IndexType>::isBroadcastable(this->getShape(), tensor.getShape())) {
+				throw InvalidArgumentException("Tensor can not be broadcast to the shape of the in-place result.");
+			}
+
+			/*	The result may only differ from this shape by axes of size 1.	*/
+			const Shape<IndexType> shape = Broadcast<IndexType>::computeShape(this->getShape(), tensor.getShape());
+			if (shape.getNrElements() != this->getNrElements()) {
+				throw InvalidArgumentException("Tensor can not be broadcast to the shape of the in-place result.");
+			}
+
+			Broadcast<IndexType>::apply(this->getRawData(), this->getShape(), tensor.getRawData(), tensor.getShape(),
+										this->getRawData(), shape, op);
+			return *this;
+		}
+
 		using TensorBuffer = union _buffer_t {
 			uint8_t *data = nullptr; /*	*/
 			DType *ddata;			 /*	*/
@@ -1039,19 +1288,93 @@ namespace Ritsu {
 			TensorBuffer buffer;				 /*	*/
 			size_t allocationSize = 0;			 /*	*/
 			size_t uid = 0;						 /*	*/
-			std::atomic_int32_t nrReferences{1}; /*	*/
+			std::atomic<TensorSharedBuffer *> shared{nullptr}; /*	Reference counted memory, if any.	*/
 			size_t ownerUid = 0;				 /*	*/
 			uint32_t element_size = 0;			 /*	*/
 			Shape<IndexType> memoryShape;		 /*	*/
 		};
 
-		size_t NrElements = 0;			  /*	Cache value of shape number of elements.*/
+		SizeType NrElements = 0;		  /*	Cache value of shape number of elements.*/
 		Shape<IndexType> shape;			  /*	Shape of tensor.	*/
 		InternalBuffer memoryBuffer;	  /*	Internal buffer.	*/
 		const std::type_info *typeinfo{}; /*	*/
 
 		inline bool ownAllocation() const noexcept { return this->memoryBuffer.uid == this->memoryBuffer.ownerUid; }
 
+		inline bool isTransient() const noexcept {
+			const TensorSharedBuffer *buffer = this->memoryBuffer.shared.load(std::memory_order_acquire);
+			return buffer != nullptr && this->ownAllocation() && buffer->allocator->isTransient();
+		}
+
+		/**
+		 * @brief True if a copy can share the memory instead of copying it. Memory with views, or
+		 *	transient memory, such as from an arena, is always copied.
+		 */
+		inline bool isShareable() const noexcept {
+			const TensorSharedBuffer *buffer = this->memoryBuffer.shared.load(std::memory_order_acquire);
+			return buffer != nullptr && this->ownAllocation() && !buffer->hasViews() &&
+				   !buffer->allocator->isTransient() && this->getNrElements() > 0;
+		}
+
+		/**
+		 * @brief Become an owner of the memory of the other tensor, copy-on-write.
+		 */
+		void share(const Tensor &other) noexcept {
+			TensorSharedBuffer *buffer = other.memoryBuffer.shared.load(std::memory_order_acquire);
+			buffer->addOwner();
+
+			this->memoryBuffer.buffer.data = other.memoryBuffer.buffer.data;
+			this->memoryBuffer.shared.store(buffer, std::memory_order_release);
+			this->memoryBuffer.allocationSize = other.memoryBuffer.allocationSize;
+			this->memoryBuffer.element_size = other.memoryBuffer.element_size;
+			this->memoryBuffer.memoryShape = other.memoryBuffer.memoryShape;
+			this->memoryBuffer.uid = reinterpret_cast<size_t>(this);
+			this->memoryBuffer.ownerUid = this->memoryBuffer.uid;
+			this->shape = other.shape;
+			this->NrElements = other.NrElements;
+			this->typeinfo = other.typeinfo;
+		}
+
+		/**
+		 * @brief Keep the memory of the parent alive for as long as this view.
+		 */
+		void attachView(const Tensor &parent) noexcept {
+			TensorSharedBuffer *buffer = parent.memoryBuffer.shared.load(std::memory_order_acquire);
+			if (buffer != nullptr) {
+				buffer->addView();
+				this->memoryBuffer.shared.store(buffer, std::memory_order_release);
+			}
+		}
+
+		/**
+		 * @brief Copy the memory if shared with another owner, before it is modified.
+		 */
+		inline void detach() {
+			const TensorSharedBuffer *buffer = this->memoryBuffer.shared.load(std::memory_order_acquire);
+			if (buffer != nullptr && buffer->isShared() && this->ownAllocation()) {
+				this->detachShared();
+			}
+		}
+
+		void detachShared() {
+			std::lock_guard<std::mutex> guard(TensorSharedBuffer::getLock(this));
+
+			/*	Another thread writing to this tensor may already have copied it.	*/
+			TensorSharedBuffer *buffer = this->memoryBuffer.shared.load(std::memory_order_acquire);
+			if (!buffer->isShared()) {
+				return;
+			}
+
+			const size_t size = this->memoryBuffer.allocationSize;
+			TensorSharedBuffer *copy = TensorSharedBuffer::create(*buffer->allocator, size, alignmentByte);
+			std::memcpy(copy->getData(), this->memoryBuffer.buffer.data, size);
+
+			this->memoryBuffer.buffer.data = copy->getData();
+			this->memoryBuffer.shared.store(copy, std::memory_order_release);
+			TensorSharedBuffer::release(buffer, true, alignmentByte);
+			TensorAllocationCounter::increment(size);
+		}
+
 	  public:
 		static inline void assertEqualSize(const Tensor &tensorA, const Tensor &tensorB) {
 			assert(tensorA.getShape() == tensorB.getShape());
@@ -1092,10 +1415,15 @@ namespace Ritsu {
 		 */
 		static Tensor &log10(Tensor &tensorA) noexcept {
 
-#pragma omp parallel for simd shared(tensorA)
-			for (IndexType i = 0; i < tensorA.getNrElements(); i++) {
-				tensorA.getRawData()[i] = static_cast<DType>(std::log10(tensorA.getRawData()[i]));
-			}
+			const SizeType nrElements = tensorA.getNrElements();
+			const TensorSpan<DType> data = tensorA.span();
+
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t index = begin; index < end; index++) {
+					data[index] = VectorMath::log10<DType>(data[index]);
+				}
+			});
 			return tensorA;
 		}
 
@@ -1105,11 +1433,14 @@ namespace Ritsu {
 		static Tensor &abs(Tensor &tensorA) noexcept {
 
 			const size_t nrElements = tensorA.getNrElements();
-#pragma omp for simd // shared(tensorA)
-			for (size_t i = 0; i < nrElements; i++) {
-				tensorA.getRawData()[i] =
-					static_cast<Tensor::DType>(Math::abs<DType>(tensorA.getRawData()[i]));
-			}
+			const TensorSpan<DType> data = tensorA.span();
+
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					data[i] = static_cast<Tensor::DType>(Math::abs<DType>(data[i]));
+				}
+			});
 
 			return tensorA;
 		}
@@ -1134,7 +1465,7 @@ namespace Ritsu {
 		}
 
 		/**
-		 * @brief
+		 * @brief Sum along the axis, the axis is kept with a dimension of 1.
 		 */
 		static Tensor sum(const Tensor &tensorA, const int axis) noexcept {
 
@@ -1146,34 +1477,17 @@ namespace Ritsu {
 				return tensorA;
 			}
 
-			Shape<IndexType> dim;
-			size_t batch_size = 0;
-
-			/*	*/
-			if (tensorA.getShape().getNrDimensions() == 1) {
-				dim = {1};
-				batch_size = 1;
-			} else {
-				dim = tensorA.getShape().getSubShape(axis);
-				dim[axis] = 1;
-				batch_size = tensorA.getShape().getAxisDimensions(axis);
-			}
-
-			/*	*/
-			Tensor result = Tensor::zero(dim);
+			const typename AxisReduce<IndexType>::Layout layout =
+				AxisReduce<IndexType>::computeLayout(tensorA.getShape(), axis);
+			Tensor result(AxisReduce<IndexType>::computeShape(tensorA.getShape(), axis));
 
-/*	*/
-#pragma omp simd
-			for (size_t i = 0; i < batch_size; i++) {
-				const Tensor subset = tensorA.getSubset({{static_cast<IndexType>(i)}});
-				result += subset;
-			}
+			AxisReduce<IndexType>::template sum<DType>(tensorA.getRawData<DType>(), result.getRawData<DType>(), layout);
 
 			return result;
 		}
 
 		/**
-		 * @brief
+		 * @brief Mean along the axis, the axis is kept with a dimension of 1.
 		 */
 		static Tensor mean(const Tensor &tensorA, const int axis) noexcept {
 
@@ -1185,40 +1499,11 @@ namespace Ritsu {
 				return tensorA;
 			}
 
-			Tensor resultMean = Tensor::sum(tensorA, axis);
-
-			Shape<IndexType> dim;
-			size_t batch_size = 0;
-			dim = tensorA.getShape().getSubShape({0});
-			batch_size = tensorA.getShape().getAxisDimensions(axis);
-
-			// if (tensorA.getShape().getNrDimensions() == 1) {
-			//	dim = {1};
-			//	batch_size = 1;
-			// } else {
-			//
-			//}
-
-			const DType averageInverse = (static_cast<DType>(1) / static_cast<DType>(batch_size));
-			resultMean = resultMean * averageInverse;
-			return resultMean;
+			const typename AxisReduce<IndexType>::Layout layout =
+				AxisReduce<IndexType>::computeLayout(tensorA.getShape(), axis);
+			Tensor result(AxisReduce<IndexType>::computeShape(tensorA.getShape(), axis));
 
-			Tensor result(dim);
-
-/*	*/
-#pragma omp parallel for
-			for (size_t i = 0; i < batch_size; i++) {
-
-				const Tensor subset = tensorA.getSubset(
-					{{static_cast<IndexType>(i)},
-					 {0, tensorA.getShape()[0] - 1} /*TODO:remove*/}); // TODO:fix a unit test to make it work.
-
-				const DType *data = subset.getRawData<DType>();
-
-				const size_t elements = subset.getNrElements();
-				const DType meanResult = Math::mean<DType>(data, elements);
-				result.getValue(i) = meanResult;
-			}
+			AxisReduce<IndexType>::template mean<DType>(tensorA.getRawData<DType>(), result.getRawData<DType>(), layout);
 
 			return result;
 		}
@@ -1232,10 +1517,10 @@ namespace Ritsu {
 		}
 
 		/**
-		 * @brief
+		 * @brief Sample variance along the axis, around the mean along the same axis, see mean(tensor,
+		 *	axis). The axis is kept with a dimension of 1.
 		 */
-		static Tensor variance(const Tensor &tensorA, const Tensor meanTensor,
-							   const int axis) noexcept { // TODO: impl and override the none-axis
+		static Tensor variance(const Tensor &tensorA, const Tensor &meanTensor, const int axis) noexcept {
 			/*	*/
 			if (tensorA.getNrElements() == 0) {
 				return {};
@@ -1244,34 +1529,13 @@ namespace Ritsu {
 				return tensorA;
 			}
 
-			Shape<IndexType> dim;
-			size_t batch_size = 0;
-
-			if (tensorA.getShape().getNrDimensions() == 1) {
-				dim = {1};
-				batch_size = 1;
-			} else {
-				dim = tensorA.getShape().getSubShape(axis);
-				dim[axis] = 1;
-				batch_size = tensorA.getShape().getAxisDimensions(axis);
-			}
-
-			Tensor result(dim);
+			const typename AxisReduce<IndexType>::Layout layout =
+				AxisReduce<IndexType>::computeLayout(tensorA.getShape(), axis);
+			Tensor result(AxisReduce<IndexType>::computeShape(tensorA.getShape(), axis));
+			assert(meanTensor.getNrElements() == result.getNrElements());
 
-			/*	*/
-#pragma omp parallel for
-			for (size_t i = 0; i < batch_size; i++) {
-				const Tensor subset = tensorA.getSubset(
-					{{static_cast<IndexType>(i)},
-					 {0, tensorA.getShape()[0] - 1} /*TODO:remove*/}); // TODO:fix a unit test to make it work.
-
-				const DType *data = subset.getRawData<DType>();
-
-				const size_t elements = subset.getNrElements();
-				const DType mean = meanTensor.getValue(i);
-				const DType meanResult = Math::variance<DType>(data, elements, mean);
-				result.getValue(i) = meanResult;
-			}
+			AxisReduce<IndexType>::template variance<DType>(tensorA.getRawData<DType>(), meanTensor.getRawData<DType>(),
+															 result.getRawData<DType>(), layout);
 
 			return result;
 		}
@@ -1323,9 +1587,9 @@ namespace Ritsu {
 			Tensor<DType> oneshot = std::move(Tensor::zero(newShape));
 
 			/*	*/
-			const IndexType nrElements = tensor.getShape()[0];
+			const SizeType nrElements = tensor.getShape()[0];
 
-			for (IndexType i = 0; i < nrElements; i++) {
+			for (SizeType i = 0; i < nrElements; i++) {
 				const IndexType value = tensor.getValue(i);
 				Tensor<DType> ref = oneshot.getSubset({{static_cast<IndexType>(i)}});
 				ref.getValue(static_cast<IndexType>(value)) = static_cast<IndexType>(1);
@@ -1376,11 +1640,12 @@ namespace Ritsu {
 		 * @brief
 		 */
 		static Tensor matrixMultiply(const Tensor &tensorALeft, const Tensor &tensorBRight) {
-			/*	TODO: add multiple dims- layers.	*/
 
-			const IndexType B_col = tensorBRight.getShape().getNrDimensions() > 1 ? tensorBRight.getShape()[1] : 1;
-			const IndexType B_row = tensorALeft.getShape()[0];
-			Tensor output(Shape<IndexType>({B_row, B_col}));
+			if (!isMatrixOperationSupported(tensorALeft.getShape(), tensorBRight.getShape())) {
+				throw RuntimeException("Invalid Matrix Shape for Multiplication");
+			}
+
+			Tensor output(Tensor::matrixMultiplyShape(tensorALeft.getShape(), tensorBRight.getShape()));
 
 			Tensor::matrixMultiply(tensorALeft, tensorBRight, output);
 
@@ -1389,63 +1654,83 @@ namespace Ritsu {
 
 		static constexpr bool isMatrixOperationSupported(const Shape<IndexType> &shapeA,
 														 const Shape<IndexType> &shapeB) noexcept {
-			const IndexType A_col = shapeA.getNrDimensions() > 1 ? shapeA[1] : 1;
-			const IndexType B_row = shapeB[0];
-			return A_col == B_row;
-		}
+			const IndexType nrDimA = shapeA.getNrDimensions();
+			const IndexType nrDimB = shapeB.getNrDimensions();
 
-		// TODO: squeeze
-		static Tensor matrixMultiply(const Tensor &tensorALeft, const Tensor &tensorBRight, Tensor &__restrict output) {
-
-			if (!isMatrixOperationSupported(tensorALeft.getShape(), tensorBRight.getShape())) {
-				throw RuntimeException("Invalid Matrix Shape for Multiplication");
+			const IndexType A_col = nrDimA > 1 ? shapeA.getAxisDimensions(-1) : 1;
+			const IndexType B_row = nrDimB > 2 ? shapeB.getAxisDimensions(-2) : shapeB[0];
+			if (A_col != B_row) {
+				return false;
 			}
 
-			// TODO: verify shape.
-			if (tensorALeft.getShape().getNrDimensions() > 2) {
-				throw NotImplementedException("Not supported");
+			/*	Batch dimensions must match, unless one of the operands is broadcast.	*/
+			if (nrDimA > 2 && nrDimB > 2) {
+				return shapeA.getSubShapeMem(0, nrDimA - 3) == shapeB.getSubShapeMem(0, nrDimB - 3);
 			}
+			return true;
+		}
 
-			const IndexType A_row = tensorALeft.getShape()[0];
-			const IndexType A_col = tensorALeft.getShape().getNrDimensions() > 1 ? tensorALeft.getShape()[1] : 1;
+		/**
+		 * @brief Output shape of the (batched) matrix multiplication.
+		 *	Leading dimensions beyond the last two are batch dimensions.
+		 */
+		static Shape<IndexType> matrixMultiplyShape(const Shape<IndexType> &shapeA, const Shape<IndexType> &shapeB) {
+			const IndexType nrDimA = shapeA.getNrDimensions();
+			const IndexType nrDimB = shapeB.getNrDimensions();
 
-			const IndexType B_col = tensorBRight.getShape().getNrDimensions() > 1 ? tensorBRight.getShape()[1] : 1;
-			const IndexType B_row = tensorBRight.getShape()[0];
+			const IndexType A_row = nrDimA > 2 ? shapeA.getAxisDimensions(-2) : shapeA[0];
+			const IndexType B_col = nrDimB > 1 ? shapeB.getAxisDimensions(-1) : 1;
 
-			const IndexType output_row = output.getShape()[0];
-			const IndexType output_col = output.getShape().getNrDimensions() > 1 ? output.getShape()[1] : 1;
+			if (nrDimA <= 2 && nrDimB <= 2) {
+				return Shape<IndexType>({A_row, B_col});
+			}
 
-			assert(A_col == B_row);
-			const IndexType K = A_col;
+			Shape<IndexType> outputShape =
+				nrDimA > 2 ? shapeA.getSubShapeMem(0, nrDimA - 3) : shapeB.getSubShapeMem(0, nrDimB - 3);
+			outputShape.insert(outputShape.getNrDimensions(), {A_row, B_col});
+			return outputShape;
+		}
 
-			IndexType a_row_index;
-			IndexType b_col_index = 0;
-#pragma omp parallel for simd collapse(2) shared(tensorALeft, tensorBRight, output) schedule(static)
-			for (a_row_index = 0; a_row_index < A_row; a_row_index++) {
-				for (b_col_index = 0; b_col_index < B_col; b_col_index++) {
+		/**
+		 * @brief Matrix multiplication, batched over any leading dimensions.
+		 *	[B, M, K] x [K, N] broadcast the right matrix, [M, K] x [B, K, N] the left one and
+		 *	[B, M, K] x [B, K, N] multiply each batch pair. Each slice is computed as the 2D case.
+		 */
+		static Tensor &matrixMultiply(const Tensor &tensorALeft, const Tensor &tensorBRight, Tensor &__restrict output) {
 
-					const IndexType indexOutput = a_row_index * output_col + b_col_index;
+			if (!isMatrixOperationSupported(tensorALeft.getShape(), tensorBRight.getShape())) {
+				throw RuntimeException("Invalid Matrix Shape for Multiplication");
+			}
 
-					DType sum = 0;
-					IndexType k = 0;
+			const IndexType nrDimA = tensorALeft.getShape().getNrDimensions();
+			const IndexType nrDimB = tensorBRight.getShape().getNrDimensions();
+			const IndexType nrDimOutput = output.getShape().getNrDimensions();
 
-#pragma omp simd reduction(+ : sum) simdlen(alignmentWidth)
-					for (k = 0; k < K; k++) {
+			const IndexType A_row = nrDimA > 2 ? tensorALeft.getShape().getAxisDimensions(-2) : tensorALeft.getShape()[0];
+			const IndexType A_col = nrDimA > 1 ? tensorALeft.getShape().getAxisDimensions(-1) : 1;
 
-						const IndexType indexA = k * A_row + a_row_index;
-						const IndexType indexB = b_col_index * K + k;
+			const IndexType B_col = nrDimB > 1 ? tensorBRight.getShape().getAxisDimensions(-1) : 1;
+			const IndexType B_row = nrDimB > 2 ? tensorBRight.getShape().getAxisDimensions(-2) : tensorBRight.getShape()[0];
 
-						assert(indexA < tensorALeft.getNrElements());
-						assert(indexB < tensorBRight.getNrElements());
+			const IndexType output_col = nrDimOutput > 1 ? output.getShape().getAxisDimensions(-1) : 1;
 
-						sum += tensorALeft.getValue<DType>(indexA) * tensorBRight.getValue<DType>(indexB);
-					}
+			assert(A_col == B_row);
+			const IndexType K = A_col;
 
-					assert(indexOutput < output.getNrElements());
-					output.getValue<DType>(indexOutput) = sum;
-				}
+			const IndexType batchA = nrDimA > 2 ? tensorALeft.getNrElements() / (A_row * A_col) : 1;
+			const IndexType batchB = nrDimB > 2 ? tensorBRight.getNrElements() / (B_row * B_col) : 1;
+			const IndexType batch = std::max(batchA, batchB);
+
+			if (output.getNrElements() < batch * A_row * B_col) {
+				throw RuntimeException("Invalid Output Shape for Matrix Multiplication");
 			}
 
+			/*	A and B are read column-major, the output is written row-major.	*/
+			Gemm::gemmBatched<DType>(batch, A_row, B_col, K, static_cast<DType>(1), tensorALeft.getRawData<DType>(),
+									 batchA > 1 ? A_row * K : 0, 1, A_row, tensorBRight.getRawData<DType>(),
+									 batchB > 1 ? K * B_col : 0, 1, K, static_cast<DType>(0),
+									 output.getRawData<DType>(), A_row * output_col, output_col, 1);
+
 			return output;
 		}
 
@@ -1453,20 +1738,10 @@ namespace Ritsu {
 		 * @brief
 		 */
 		static Tensor equal(const Tensor &tensorA, const Tensor &tensorB) {
-			assertEqualMember(tensorA, tensorB);
-
-			Tensor output(tensorA.getShape());
-			const IndexType nrElements = tensorA.getNrElements();
-
-#pragma omp for simd simdlen(alignmentWidth)
-			for (IndexType i = 0; i < nrElements; i++) {
-
-				const bool equal = tensorA.getValue<DType>(i) == tensorB.getValue<DType>(i);
-				const DType value = equal ? static_cast<DType>(1) : static_cast<DType>(0);
-
-				output.getValue<DType>(i) = value;
-			}
-
+			Tensor output;
+			Tensor::broadcastOperation(tensorA, tensorB, output, [](const DType a, const DType b) {
+				return a == b ? static_cast<DType>(1) : static_cast<DType>(0);
+			});
 			return output;
 		}
 
@@ -1474,14 +1749,10 @@ namespace Ritsu {
 		 * @brief
 		 */
 		static Tensor notEqual(const Tensor &tensorA, const Tensor &tensorB) {
-			assertEqualMember(tensorA, tensorB);
-			Tensor output(tensorA.getShape());
-
-#pragma omp parallel for shared(tensorA, tensorB, output)
-			for (size_t i = 0; i < tensorA.getNrElements(); i++) {
-				const bool not_equal = tensorA.getValue<DType>(i) != tensorB.getValue<DType>(i);
-				output.getValue<DType>(i) = not_equal ? static_cast<DType>(1) : static_cast<DType>(0);
-			}
+			Tensor output;
+			Tensor::broadcastOperation(tensorA, tensorB, output, [](const DType a, const DType b) {
+				return a != b ? static_cast<DType>(1) : static_cast<DType>(0);
+			});
 			return output;
 		}
 
@@ -1489,19 +1760,10 @@ namespace Ritsu {
 		 * @brief
 		 */
 		static Tensor greater(const Tensor &tensorA, const Tensor &tensorB) {
-			assertEqualMember(tensorA, tensorB);
-
-			Tensor output(tensorA.getShape());
-			const IndexType nrElements = tensorA.getNrElements();
-
-#pragma omp parallel for simd shared(tensorA, tensorB, output)
-			for (IndexType i = 0; i < nrElements; i++) {
-				const bool greater_result = tensorA.getValue<DType>(i) > tensorB.getValue<DType>(i);
-				const DType value = greater_result ? static_cast<DType>(1) : static_cast<DType>(0);
-
-				output.getValue<DType>(i) = value;
-			}
-
+			Tensor output;
+			Tensor::broadcastOperation(tensorA, tensorB, output, [](const DType a, const DType b) {
+				return a > b ? static_cast<DType>(1) : static_cast<DType>(0);
+			});
 			return output;
 		}
 
@@ -1509,21 +1771,43 @@ namespace Ritsu {
 		 * @brief
 		 */
 		static Tensor less(const Tensor &tensorA, const Tensor &tensorB) {
-			assertEqualMember(tensorA, tensorB);
-
-			Tensor output(tensorA.getShape());
-			const IndexType nrElements = tensorA.getNrElements();
+			Tensor output;
+			Tensor::broadcastOperation(tensorA, tensorB, output, [](const DType a, const DType b) {
+				return a < b ? static_cast<DType>(1) : static_cast<DType>(0);
+			});
+			return output;
+		}
 
-#pragma omp parallel for simd shared(tensorA, tensorB, output)
+		/**
+		 * @brief Fill the output, in its current shape, with the tensor broadcast to that shape.
+		 */
+		static void broadcastTo(const Tensor &tensor, Tensor &output) {
+			output.broadcastInplace(tensor, [](const DType, const DType b) { return b; });
+		}
 
-			for (IndexType i = 0; i < nrElements; i++) {
-				const bool less_result = tensorA.getValue<DType>(i) < tensorB.getValue<DType>(i);
-				const DType value = less_result ? static_cast<DType>(1) : static_cast<DType>(0);
+		/**
+		 * @brief Compute output = op(tensorA, tensorB) elementwise, broadcasting the operands to a
+		 *	common shape. The output is resized to the broadcast shape if needed.
+		 *	Operands with the same number of elements are combined element by element.
+		 */
+		template <typename Op>
+		static void broadcastOperation(const Tensor &tensorA, const Tensor &tensorB, Tensor &output, Op op) {
+			const Shape<IndexType> shape = tensorA.getNrElements() == tensorB.getNrElements()
+											   ? tensorA.getShape()
+											   : Broadcast<IndexType>::computeShape(tensorA.getShape(), tensorB.getShape());
 
-				output.getValue<DType>(i) = value;
+			if (output.getRawData() == nullptr || output.getShape() != shape) {
+				output.resizeBuffer(shape, DTypeSize);
+				output.typeinfo = &typeid(DType);
 			}
 
-			return output;
+			if (tensorA.getNrElements() == tensorB.getNrElements()) {
+				Broadcast<IndexType>::apply(tensorA.getRawData(), shape, tensorB.getRawData(), shape,
+											output.getRawData(), shape, op);
+			} else {
+				Broadcast<IndexType>::apply(tensorA.getRawData(), tensorA.getShape(), tensorB.getRawData(),
+											tensorB.getShape(), output.getRawData(), shape, op);
+			}
 		}
 
 		/**
@@ -1535,12 +1819,13 @@ namespace Ritsu {
 						  "Must be a decimal type(float/double/half) or integer.");
 			Tensor<DType> tensor({static_cast<IndexType>(list.size())});
 
-			IndexType index = 0;
-#pragma omp for simd
-			for (typename std::initializer_list<U>::const_iterator i = list.begin(); i != list.end(); i++) {
-				const U value = static_cast<U>(*i);
+			const TensorSpan<DType> data = tensor.span();
+			const U *values = list.begin();
+			const SizeType nrElements = list.size();
 
-				tensor.template getValue<DType>(index++) = static_cast<DType>(value);
+#pragma omp simd
+			for (SizeType i = 0; i < nrElements; i++) {
+				data[i] = static_cast<DType>(values[i]);
 			}
 
 			return tensor;
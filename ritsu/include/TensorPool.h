@@ -15,11 +15,579 @@
  */
 #pragma once
 #include "Object.h"
+#include "core/RuntimeConfig.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
 
 namespace Ritsu {
 
-	class MemoryAllocator : Object {
+	/**
+	 * @brief Snapshot of the allocator counters.
+	 */
+	struct MemoryAllocatorStatistics {
+		size_t hits = 0;		   /*	Allocations served from a free list.	*/
+		size_t misses = 0;		   /*	Allocations requested from the system.	*/
+		size_t bytesAllocated = 0; /*	Total bytes requested from the system.	*/
+		size_t bytesInUse = 0;	   /*	Bytes currently handed out.	*/
+		size_t peakBytesInUse = 0; /*	Highest bytesInUse.	*/
+		size_t bytesCached = 0;	   /*	Bytes kept in free lists.	*/
+	};
+
+	/**
+	 * @brief Allocator interface used by Tensor for all owned buffers.
+	 */
+	class MemoryAllocator : public Object {
+	  public:
+		MemoryAllocator(const std::string &name) : Object(name) {}
+		virtual ~MemoryAllocator() = default;
+
+		/**
+		 * @brief Allocate size bytes, with the address aligned to alignment.
+		 */
+		virtual void *allocate(const size_t size, const size_t alignment) = 0;
+
+		/**
+		 * @brief Release memory from allocate, with the same size and alignment.
+		 */
+		virtual void deallocate(void *memory, const size_t size, const size_t alignment) noexcept = 0;
+
+		/**
+		 * @brief Number of bytes actually reserved for a request. Resizing within the same
+		 * usable size can reuse the allocation.
+		 */
+		virtual size_t getUsableSize(const size_t size, const size_t alignment) const noexcept { return size; }
+
+		/**
+		 * @brief If the memory is only valid for a limited scope, such as an arena. Moving a
+		 * transient tensor into a tensor with persistent memory copies instead of taking it.
+		 */
+		virtual bool isTransient() const noexcept { return false; }
+
+		MemoryAllocatorStatistics getStatistics() const noexcept {
+			MemoryAllocatorStatistics statistics;
+			statistics.hits = this->hits.load(std::memory_order_relaxed);
+			statistics.misses = this->misses.load(std::memory_order_relaxed);
+			statistics.bytesAllocated = this->bytesAllocated.load(std::memory_order_relaxed);
+			statistics.bytesInUse = this->bytesInUse.load(std::memory_order_relaxed);
+			statistics.peakBytesInUse = this->peakBytesInUse.load(std::memory_order_relaxed);
+			statistics.bytesCached = this->bytesCached.load(std::memory_order_relaxed);
+			return statistics;
+		}
+
+		/**
+		 * @brief Reset the hit, miss and allocated counters, the peak restarts from the bytes in use.
+		 */
+		void resetStatistics() noexcept {
+			this->hits.store(0, std::memory_order_relaxed);
+			this->misses.store(0, std::memory_order_relaxed);
+			this->bytesAllocated.store(0, std::memory_order_relaxed);
+			this->peakBytesInUse.store(this->bytesInUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Allocator used by new tensors. The allocator of the innermost ScopedAllocator of
+		 * the calling thread, otherwise the process default, otherwise the global TensorPool.
+		 */
+		static MemoryAllocator &getDefault() noexcept;
+
+		/**
+		 * @brief Override the allocator for new tensors, nullptr restores the global TensorPool.
+		 *	Existing tensors keep releasing through the allocator they were allocated with.
+		 */
+		static void setDefault(MemoryAllocator *allocator) noexcept { defaultAllocator.store(allocator); }
+
+		/**
+		 * @brief Ask the kernel to back the range with transparent huge pages, where supported.
+		 */
+		static void adviseHugePage(void *memory, const size_t size) noexcept {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+			madvise(memory, size, MADV_HUGEPAGE);
+#else
+			(void)memory;
+			(void)size;
+#endif
+		}
+
+		static constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+	  protected:
+		void recordAllocation(const size_t size, const bool hit) noexcept {
+			if (hit) {
+				this->hits.fetch_add(1, std::memory_order_relaxed);
+			} else {
+				this->misses.fetch_add(1, std::memory_order_relaxed);
+				this->bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+			}
+			const size_t inUse = this->bytesInUse.fetch_add(size, std::memory_order_relaxed) + size;
+			size_t peak = this->peakBytesInUse.load(std::memory_order_relaxed);
+			while (inUse > peak && !this->peakBytesInUse.compare_exchange_weak(peak, inUse)) {
+			}
+		}
+
+		void recordDeallocation(const size_t size) noexcept {
+			this->bytesInUse.fetch_sub(size, std::memory_order_relaxed);
+		}
+
+		std::atomic<size_t> bytesCached{0};
+
+		static void *allocateSystem(const size_t size, const size_t alignment) noexcept {
+			void *memory = nullptr;
+#if defined(_WIN32)
+			memory = _aligned_malloc(size, alignment);
+#else
+			if (posix_memalign(&memory, alignment < sizeof(void *) ? sizeof(void *) : alignment, size) != 0) {
+				memory = nullptr;
+			}
+#endif
+			return memory;
+		}
+
+		static void deallocateSystem(void *memory) noexcept {
+#if defined(_WIN32)
+			_aligned_free(memory);
+#else
+			free(memory);
+#endif
+		}
+
+	  private:
+		std::atomic<size_t> hits{0};
+		std::atomic<size_t> misses{0};
+		std::atomic<size_t> bytesAllocated{0};
+		std::atomic<size_t> bytesInUse{0};
+		std::atomic<size_t> peakBytesInUse{0};
+
+		static inline std::atomic<MemoryAllocator *> defaultAllocator{nullptr};
+
+	  protected:
+		static inline thread_local MemoryAllocator *threadAllocator = nullptr;
+
+		friend class ScopedAllocator;
+	};
+
+	/**
+	 * @brief Direct aligned allocation, without any recycling. Allocations of at least the huge
+	 * page threshold are aligned to the huge page size and advised to use huge pages.
+	 */
+	class AlignedAllocator : public MemoryAllocator {
 	  public:
+		AlignedAllocator(const size_t hugePageThreshold = 0) : MemoryAllocator("aligned") {
+			this->setHugePageThreshold(hugePageThreshold);
+		}
+
+		void *allocate(const size_t size, const size_t alignment) override {
+			void *memory = this->allocateBlock(size, alignment);
+			if (memory != nullptr) {
+				this->recordAllocation(size, false);
+			}
+			return memory;
+		}
+
+		void deallocate(void *memory, const size_t size, const size_t alignment) noexcept override {
+			if (memory == nullptr) {
+				return;
+			}
+			MemoryAllocator::deallocateSystem(memory);
+			this->recordDeallocation(size);
+		}
+
+		/**
+		 * @brief Minimum size in bytes to back with huge pages, 0 disables.
+		 */
+		void setHugePageThreshold(const size_t threshold) noexcept { this->hugePageThreshold = threshold; }
+		size_t getHugePageThreshold() const noexcept { return this->hugePageThreshold; }
+
+	  protected:
+		void *allocateBlock(const size_t size, const size_t alignment) const noexcept {
+			const bool hugePage = this->hugePageThreshold > 0 && size >= this->hugePageThreshold;
+			void *memory = MemoryAllocator::allocateSystem(size, hugePage ? HugePageSize : alignment);
+			if (memory != nullptr && hugePage) {
+				MemoryAllocator::adviseHugePage(memory, size);
+			}
+			return memory;
+		}
+
+	  private:
+		size_t hugePageThreshold = 0;
 	};
 
-}; // namespace Ritsu
\ No newline at end of file
+	/**
+	 * @brief Recycling allocator, rounding requests up to size classes and keeping released
+	 * blocks in a per-thread free list for reuse by the next allocation of the same class.
+	 *
+	 *	Size classes are multiples of 64 bytes up to 256 bytes, then four classes per power of two,
+	 *	wasting at most 25%. Requests larger than MaxBlockSize, or aligned to more than BlockAlignment,
+	 *	bypass the free lists.
+	 */
+	class TensorPool : public AlignedAllocator {
+	  public:
+		static constexpr size_t BlockAlignment = 64;
+		static constexpr size_t MaxBlockSize = static_cast<size_t>(64) * 1024 * 1024;
+		static constexpr size_t NrSizeClasses = 4 + (26 - 8) * 4;
+
+		TensorPool(const size_t maxCachedBytesPerThread = static_cast<size_t>(64) * 1024 * 1024,
+				   const size_t hugePageThreshold = 0)
+			: AlignedAllocator(hugePageThreshold), maxCachedBytes(maxCachedBytesPerThread),
+			  poolIndex(nextPoolIndex.fetch_add(1)) {
+			this->setName("pool");
+		}
+
+		void *allocate(const size_t size, const size_t alignment) override {
+			if (!TensorPool::isPooled(size, alignment)) {
+				return AlignedAllocator::allocate(size, alignment);
+			}
+
+			const size_t sizeClass = TensorPool::getSizeClass(size);
+			const size_t blockSize = TensorPool::getClassSize(sizeClass);
+
+			ThreadCache *cache = this->getThreadCache();
+			if (cache != nullptr && !cache->blocks[sizeClass].empty()) {
+				void *memory = cache->blocks[sizeClass].back();
+				cache->blocks[sizeClass].pop_back();
+				cache->cachedBytes -= blockSize;
+
+				this->bytesCached.fetch_sub(blockSize, std::memory_order_relaxed);
+				this->recordAllocation(blockSize, true);
+				return memory;
+			}
+
+			void *memory = this->allocateBlock(blockSize, BlockAlignment);
+			if (memory != nullptr) {
+				this->recordAllocation(blockSize, false);
+			}
+			return memory;
+		}
+
+		void deallocate(void *memory, const size_t size, const size_t alignment) noexcept override {
+			if (memory == nullptr) {
+				return;
+			}
+			if (!TensorPool::isPooled(size, alignment)) {
+				AlignedAllocator::deallocate(memory, size, alignment);
+				return;
+			}
+
+			const size_t sizeClass = TensorPool::getSizeClass(size);
+			const size_t blockSize = TensorPool::getClassSize(sizeClass);
+			this->recordDeallocation(blockSize);
+
+			/*	Keep the block for reuse, unless the thread cache is full.	*/
+			ThreadCache *cache = this->getThreadCache();
+			if (cache != nullptr && cache->cachedBytes + blockSize <= this->maxCachedBytes) {
+				cache->blocks[sizeClass].push_back(memory);
+				cache->cachedBytes += blockSize;
+				this->bytesCached.fetch_add(blockSize, std::memory_order_relaxed);
+				return;
+			}
+
+			MemoryAllocator::deallocateSystem(memory);
+		}
+
+		size_t getUsableSize(const size_t size, const size_t alignment) const noexcept override {
+			if (!TensorPool::isPooled(size, alignment)) {
+				return size;
+			}
+			return TensorPool::getClassSize(TensorPool::getSizeClass(size));
+		}
+
+		/**
+		 * @brief Release all blocks cached by the calling thread.
+		 */
+		void trim() noexcept {
+			ThreadCache *cache = this->getThreadCache();
+			if (cache == nullptr) {
+				return;
+			}
+			for (size_t i = 0; i < NrSizeClasses; i++) {
+				for (void *memory : cache->blocks[i]) {
+					MemoryAllocator::deallocateSystem(memory);
+				}
+				cache->blocks[i].clear();
+			}
+			this->bytesCached.fetch_sub(cache->cachedBytes, std::memory_order_relaxed);
+			cache->cachedBytes = 0;
+		}
+
+		/**
+		 * @brief Process wide pool, used as the default tensor allocator.
+		 */
+		static TensorPool &getGlobal() noexcept {
+			/*	Never destroyed, tensors with static storage may outlive it otherwise.	*/
+			static TensorPool *pool = new TensorPool();
+			return *pool;
+		}
+
+		static constexpr bool isPooled(const size_t size, const size_t alignment) noexcept {
+			return size > 0 && size <= MaxBlockSize && alignment <= BlockAlignment;
+		}
+
+		static constexpr size_t getSizeClass(const size_t size) noexcept {
+			if (size <= 256) {
+				return (size + 63) / 64 - 1;
+			}
+			/*	Power of two range (2^p, 2^(p+1)], split in four.	*/
+			size_t power = 0;
+			for (size_t value = size - 1; value > 1; value >>= 1) {
+				power++;
+			}
+			const size_t step = static_cast<size_t>(1) << (power - 2);
+			const size_t index = (size - (static_cast<size_t>(1) << power) + step - 1) / step;
+			return 4 + (power - 8) * 4 + (index - 1);
+		}
+
+		static constexpr size_t getClassSize(const size_t sizeClass) noexcept {
+			if (sizeClass < 4) {
+				return (sizeClass + 1) * 64;
+			}
+			const size_t power = 8 + (sizeClass - 4) / 4;
+			const size_t index = (sizeClass - 4) % 4 + 1;
+			return (static_cast<size_t>(1) << power) + index * (static_cast<size_t>(1) << (power - 2));
+		}
+
+	  private:
+		struct ThreadCache {
+			std::array<std::vector<void *>, NrSizeClasses> blocks;
+			size_t cachedBytes = 0;
+
+			~ThreadCache() {
+				for (size_t i = 0; i < NrSizeClasses; i++) {
+					for (void *memory : blocks[i]) {
+						MemoryAllocator::deallocateSystem(memory);
+					}
+				}
+			}
+		};
+
+		struct ThreadCacheList {
+			std::vector<std::unique_ptr<ThreadCache>> caches;
+			bool *destroyed;
+
+			~ThreadCacheList() { *destroyed = true; }
+		};
+
+		/**
+		 * @brief Free list of the calling thread for this pool, nullptr while the thread exits.
+		 */
+		ThreadCache *getThreadCache() noexcept {
+			static thread_local bool destroyed = false;
+			if (destroyed) {
+				return nullptr;
+			}
+			static thread_local ThreadCacheList list{{}, &destroyed};
+			if (list.caches.size() <= this->poolIndex) {
+				list.caches.resize(this->poolIndex + 1);
+			}
+			if (!list.caches[this->poolIndex]) {
+				list.caches[this->poolIndex] = std::make_unique<ThreadCache>();
+			}
+			return list.caches[this->poolIndex].get();
+		}
+
+		size_t maxCachedBytes;
+		size_t poolIndex;
+
+		static inline std::atomic<size_t> nextPoolIndex{0};
+	};
+
+	/**
+	 * @brief Bump allocator for short lived tensors. Allocations advance an offset in a list of
+	 * chunks and deallocation does nothing, memory is reclaimed by rewinding to a marker. The chunks
+	 * are scratch memory, placed by RuntimeConfig::getScratchPolicy.
+	 */
+	class ArenaAllocator : public MemoryAllocator {
+	  public:
+		struct Marker {
+			size_t chunk = 0;
+			size_t offset = 0;
+		};
+
+		ArenaAllocator(const size_t initialChunkSize = static_cast<size_t>(1024) * 1024)
+			: MemoryAllocator("arena"), initialChunkSize(initialChunkSize) {}
+		ArenaAllocator(const ArenaAllocator &other) = delete;
+		ArenaAllocator &operator=(const ArenaAllocator &other) = delete;
+
+		~ArenaAllocator() override {
+			for (const Chunk &chunk : this->chunks) {
+				MemoryAllocator::deallocateSystem(chunk.memory);
+			}
+		}
+
+		void *allocate(const size_t size, const size_t alignment) override {
+			/*	Advance to the next chunk large enough.	*/
+			while (this->current < this->chunks.size()) {
+				const Chunk &chunk = this->chunks[this->current];
+				const size_t offset = ((this->offset + alignment - 1) / alignment) * alignment;
+				if (offset + size <= chunk.size) {
+					this->offset = offset + size;
+					this->recordAllocation(size, true);
+					return chunk.memory + offset;
+				}
+				this->current++;
+				this->offset = 0;
+			}
+
+			/*	New chunk, at least double the last one.	*/
+			const size_t lastSize = this->chunks.empty() ? this->initialChunkSize / 2 : this->chunks.back().size;
+			size_t chunkSize = lastSize * 2;
+			while (chunkSize < size + alignment) {
+				chunkSize *= 2;
+			}
+			uint8_t *memory = static_cast<uint8_t *>(MemoryAllocator::allocateSystem(chunkSize, ChunkAlignment));
+			if (memory == nullptr) {
+				return nullptr;
+			}
+			RuntimeConfig::bindMemory(memory, chunkSize, RuntimeConfig::getScratchPolicy());
+
+			this->chunks.push_back({memory, chunkSize});
+			this->current = this->chunks.size() - 1;
+			this->offset = size;
+			this->recordAllocation(size, false);
+			return memory;
+		}
+
+		void deallocate(void *memory, const size_t size, const size_t alignment) noexcept override {
+			this->recordDeallocation(size);
+		}
+
+		bool isTransient() const noexcept override { return true; }
+
+		Marker mark() const noexcept { return {this->current, this->offset}; }
+
+		/**
+		 * @brief Release everything allocated after the marker. All tensors allocated since must
+		 * be dead. Rewinding to the start merges the chunks, so the next pass fits in one chunk.
+		 */
+		void rewind(const Marker &marker) noexcept {
+#ifndef NDEBUG
+			/*	Poison the released memory, tensors escaping the scope read NaN.	*/
+			for (size_t i = marker.chunk; i < this->chunks.size() && i <= this->current; i++) {
+				const size_t begin = i == marker.chunk ? marker.offset : 0;
+				const size_t end = i == this->current ? this->offset : this->chunks[i].size;
+				if (end > begin) {
+					std::memset(this->chunks[i].memory + begin, 0xff, end - begin);
+				}
+			}
+#endif
+			this->current = marker.chunk;
+			this->offset = marker.offset;
+
+			if (marker.chunk == 0 && marker.offset == 0 && this->chunks.size() > 1) {
+				size_t total = 0;
+				for (const Chunk &chunk : this->chunks) {
+					total += chunk.size;
+					MemoryAllocator::deallocateSystem(chunk.memory);
+				}
+				this->chunks.clear();
+
+				uint8_t *memory = static_cast<uint8_t *>(MemoryAllocator::allocateSystem(total, ChunkAlignment));
+				if (memory != nullptr) {
+					RuntimeConfig::bindMemory(memory, total, RuntimeConfig::getScratchPolicy());
+					this->chunks.push_back({memory, total});
+				}
+			}
+		}
+
+		/**
+		 * @brief Total size of the chunks.
+		 */
+		size_t getCapacity() const noexcept {
+			size_t total = 0;
+			for (const Chunk &chunk : this->chunks) {
+				total += chunk.size;
+			}
+			return total;
+		}
+
+		/**
+		 * @brief Arena of the calling thread, used by ScopedArena.
+		 */
+		static ArenaAllocator &getThreadArena() noexcept {
+			static thread_local ArenaAllocator arena;
+			return arena;
+		}
+
+		static constexpr size_t ChunkAlignment = 64;
+
+	  private:
+		struct Chunk {
+			uint8_t *memory;
+			size_t size;
+		};
+
+		std::vector<Chunk> chunks;
+		size_t current = 0;
+		size_t offset = 0;
+		size_t initialChunkSize;
+	};
+
+	/**
+	 * @brief Route tensor allocations of the calling thread to an allocator, until the end of the
+	 * scope. nullptr selects the process default, e.g. for state that must outlive a ScopedArena.
+	 */
+	class ScopedAllocator {
+	  public:
+		ScopedAllocator(MemoryAllocator *allocator) noexcept : previous(MemoryAllocator::threadAllocator) {
+			MemoryAllocator::threadAllocator = allocator;
+		}
+		ScopedAllocator(const ScopedAllocator &other) = delete;
+		ScopedAllocator &operator=(const ScopedAllocator &other) = delete;
+
+		~ScopedAllocator() noexcept { MemoryAllocator::threadAllocator = this->previous; }
+
+	  private:
+		MemoryAllocator *previous;
+	};
+
+	/**
+	 * @brief Allocate all tensors of the calling thread from the thread arena until the end of the
+	 * scope, where the memory is released at once. Tensors allocated in the scope must not outlive
+	 * it, except by being moved into a tensor already holding persistent memory, which copies.
+	 *
+	 *	{
+	 *		Ritsu::ScopedArena scope;
+	 *		Tensor<float> tmp = a * b + c;
+	 *	}
+	 */
+	class ScopedArena {
+	  public:
+		ScopedArena() noexcept : ScopedArena(ArenaAllocator::getThreadArena()) {}
+		ScopedArena(ArenaAllocator &arena) noexcept : arena(arena), marker(arena.mark()), scope(&arena) {}
+		ScopedArena(const ScopedArena &other) = delete;
+		ScopedArena &operator=(const ScopedArena &other) = delete;
+
+		~ScopedArena() noexcept { this->arena.rewind(this->marker); }
+
+		ArenaAllocator &getArena() noexcept { return this->arena; }
+
+	  private:
+		ArenaAllocator &arena;
+		ArenaAllocator::Marker marker;
+		ScopedAllocator scope;
+	};
+
+	inline MemoryAllocator &MemoryAllocator::getDefault() noexcept {
+		if (threadAllocator != nullptr) {
+			return *threadAllocator;
+		}
+		MemoryAllocator *allocator = defaultAllocator.load();
+		if (allocator == nullptr) {
+			return TensorPool::getGlobal();
+		}
+		return *allocator;
+	}
+
+} // namespace Ritsu
@@ -0,0 +1,285 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Valdemar Lindberg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ */
+#pragma once
+#include "RitsuDef.h"
+#include "Tensor.h"
+#include "core/Gemm.h"
+#include "core/Shape.h"
+#include <cstddef>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace Ritsu {
+
+	/**
+	 * @brief Non-owning strided view of tensor memory.
+	 *
+	 *	A view is a shape, a stride in elements for each axis and an offset into the memory of a
+	 *	tensor, with the last axis being the innermost. Transpose, permute, slicing on any axis and
+	 *	broadcasting only change the strides and offset, no data is copied. The tensor must outlive
+	 *	its views.
+	 */
+	template <typename T = float> class TensorView {
+	  public:
+		using DType = T;
+		using IndexType = typename Tensor<T>::IndexType;
+		using SizeType = typename Tensor<T>::SizeType;
+		using StrideType = std::ptrdiff_t;
+
+	  public:
+		/**
+		 * @brief View of the whole tensor, in its current shape.
+		 */
+		TensorView(const Tensor<T> &tensor)
+			: data(const_cast<T *>(tensor.getRawData())), shape(tensor.getShape()),
+			  strides(TensorView::computeStrides(tensor.getShape())), offset(0) {}
+
+		/**
+		 * @brief Writable view of the whole tensor, the tensor memory is no longer shared with copies.
+		 */
+		TensorView(Tensor<T> &tensor)
+			: data(tensor.getRawData()), shape(tensor.getShape()),
+			  strides(TensorView::computeStrides(tensor.getShape())), offset(0) {}
+
+		TensorView(T *data, const Shape<IndexType> &shape, const std::vector<StrideType> &strides,
+				   const StrideType offset = 0)
+			: data(data), shape(shape), strides(strides), offset(offset) {
+			if (this->shape.getNrDimensions() != this->strides.size()) {
+				throw InvalidArgumentException("Number of strides must match the number of dimensions.");
+			}
+		}
+
+		inline const Shape<IndexType> &getShape() const noexcept { return this->shape; }
+		inline const std::vector<StrideType> &getStrides() const noexcept { return this->strides; }
+		inline StrideType getOffset() const noexcept { return this->offset; }
+		inline SizeType getNrElements() const noexcept { return this->shape.getNrElements(); }
+		inline IndexType getNrDimensions() const noexcept { return this->shape.getNrDimensions(); }
+
+		/**
+		 * @brief Pointer to the first element of the view.
+		 */
+		inline T *getRawData() const noexcept { return &this->data[this->offset]; }
+
+		/**
+		 * @brief True if the elements are laid out densely in row-major order.
+		 */
+		bool isContiguous() const noexcept {
+			StrideType expected = 1;
+			for (int axis = static_cast<int>(this->getNrDimensions()) - 1; axis >= 0; axis--) {
+				if (this->shape[axis] != 1 && this->strides[axis] != expected) {
+					return false;
+				}
+				expected *= this->shape[axis];
+			}
+			return true;
+		}
+
+		inline T &getValue(const std::initializer_list<IndexType> &location) const noexcept {
+			assert(location.size() == this->getNrDimensions());
+
+			StrideType index = this->offset;
+			size_t axis = 0;
+			for (const IndexType value : location) {
+				assert(value < this->shape[axis]);
+				index += static_cast<StrideType>(value) * this->strides[axis++];
+			}
+			return this->data[index];
+		}
+
+		/**
+		 * @brief Reverse the order of the axes, zero-copy.
+		 */
+		TensorView transpose() const {
+			std::vector<unsigned int> axes(this->getNrDimensions());
+			std::iota(axes.rbegin(), axes.rend(), 0);
+			return this->permute(axes);
+		}
+
+		/**
+		 * @brief Reorder the axes, axis i of the view is axis axes[i] of this view.
+		 */
+		TensorView permute(const std::vector<unsigned int> &axes) const {
+			if (axes.size() != this->getNrDimensions()) {
+				throw InvalidArgumentException("Permutation must list every axis.");
+			}
+
+			std::vector<IndexType> dims(axes.size());
+			std::vector<StrideType> newStrides(axes.size());
+			std::vector<bool> used(axes.size(), false);
+
+			for (size_t i = 0; i < axes.size(); i++) {
+				if (axes[i] >= axes.size() || used[axes[i]]) {
+					throw InvalidArgumentException("Invalid axis permutation.");
+				}
+				used[axes[i]] = true;
+				dims[i] = this->shape[axes[i]];
+				newStrides[i] = this->strides[axes[i]];
+			}
+
+			return TensorView(this->data, Shape<IndexType>(dims), newStrides, this->offset);
+		}
+
+		/**
+		 * @brief Elements [start, end) along an axis, with an optional step, zero-copy.
+		 */
+		TensorView slice(const int axis, const IndexType start, const IndexType end, const IndexType step = 1) const {
+			const int nrDims = static_cast<int>(this->getNrDimensions());
+			const int axisIndex = axis < 0 ? axis + nrDims : axis;
+
+			if (axisIndex < 0 || axisIndex >= nrDims || step == 0) {
+				throw InvalidArgumentException("Invalid slice axis.");
+			}
+			if (start >= end || end > this->shape[axisIndex]) {
+				throw InvalidArgumentException("Invalid slice range.");
+			}
+
+			std::vector<IndexType> dims = static_cast<const std::vector<IndexType> &>(this->shape);
+			std::vector<StrideType> newStrides = this->strides;
+
+			dims[axisIndex] = (end - start + step - 1) / step;
+			newStrides[axisIndex] *= step;
+
+			return TensorView(this->data, Shape<IndexType>(dims), newStrides,
+							  this->offset + static_cast<StrideType>(start) * this->strides[axisIndex]);
+		}
+
+		/**
+		 * @brief Same elements in a new shape, zero-copy. Only contiguous views can be reshaped,
+		 *	use contiguous() first otherwise.
+		 */
+		TensorView reshape(const Shape<IndexType> &newShape) const {
+			if (newShape.getNrElements() != this->getNrElements()) {
+				throw InvalidArgumentException("Reshape must preserve the number of elements.");
+			}
+			if (!this->isContiguous()) {
+				throw RuntimeException("Can not reshape a non-contiguous view.");
+			}
+			return TensorView(this->data, newShape, TensorView::computeStrides(newShape), this->offset);
+		}
+
+		TensorView flatten() const {
+			return this->reshape(Shape<IndexType>({static_cast<IndexType>(this->getNrElements())}));
+		}
+
+		/**
+		 * @brief Copy the elements into a dense tensor in row-major order.
+		 */
+		Tensor<T> contiguous() const {
+			Tensor<T> output(this->shape);
+			this->copyTo(output);
+			return output;
+		}
+
+		/**
+		 * @brief Copy the elements into output, which must have the same number of elements.
+		 *	Contiguous views are copied directly, others are gathered row by row.
+		 */
+		void copyTo(Tensor<T> &output) const {
+			const size_t nrElements = this->getNrElements();
+
+			if (output.getNrElements() != nrElements) {
+				throw InvalidArgumentException("Output must have the same number of elements as the view.");
+			}
+
+			T *dest = output.getRawData();
+			if (this->isContiguous()) {
+				std::memcpy(dest, this->getRawData(), nrElements * sizeof(T));
+				return;
+			}
+
+			/*	Gather, the innermost axis as a strided inner loop.	*/
+			const int nrDims = static_cast<int>(this->getNrDimensions());
+			const size_t innerDim = this->shape[nrDims - 1];
+			const StrideType innerStride = this->strides[nrDims - 1];
+			const size_t nrRows = nrElements / innerDim;
+
+			const bool threaded = CpuDispatch::selectPath(nrElements) == ExecutionPath::Threaded;
+
+			CpuDispatch::parallelForEach(nrRows, threaded, [&](const size_t row) {
+				StrideType index = this->offset;
+				size_t remainder = row;
+				for (int axis = nrDims - 2; axis >= 0; axis--) {
+					index += static_cast<StrideType>(remainder % this->shape[axis]) * this->strides[axis];
+					remainder /= this->shape[axis];
+				}
+
+				const T *source = &this->data[index];
+				T *rowDest = &dest[row * innerDim];
+#pragma omp simd
+				for (size_t i = 0; i < innerDim; i++) {
+					rowDest[i] = source[static_cast<StrideType>(i) * innerStride];
+				}
+			});
+		}
+
+		/**
+		 * @brief output[M, N] = A[M, K] * B[K, N] of two 2D views. The strides are passed directly
+		 *	to the GEMM, thus transposed or sliced operands are never copied.
+		 */
+		static Tensor<T> &matrixMultiply(const TensorView &viewA, const TensorView &viewB, Tensor<T> &output) {
+			if (viewA.getNrDimensions() != 2 || viewB.getNrDimensions() != 2) {
+				throw InvalidArgumentException("Matrix multiplication of views requires 2D views.");
+			}
+
+			const IndexType M = viewA.getShape()[0];
+			const IndexType K = viewA.getShape()[1];
+			const IndexType N = viewB.getShape()[1];
+
+			if (viewB.getShape()[0] != K) {
+				throw RuntimeException("Invalid Matrix Shape for Multiplication");
+			}
+
+			const Shape<IndexType> outputShape({M, N});
+			if (output.getShape() != outputShape) {
+				output = Tensor<T>(outputShape);
+			}
+
+			Gemm::gemm<T>(M, N, K, static_cast<T>(1), viewA.getRawData(), viewA.getStrides()[0],
+						  viewA.getStrides()[1], viewB.getRawData(), viewB.getStrides()[0], viewB.getStrides()[1],
+						  static_cast<T>(0), output.getRawData(), N, 1);
+
+			return output;
+		}
+
+		static Tensor<T> matrixMultiply(const TensorView &viewA, const TensorView &viewB) {
+			Tensor<T> output;
+			return TensorView::matrixMultiply(viewA, viewB, output);
+		}
+
+		/**
+		 * @brief Row-major strides, in elements, of a dense tensor of the shape.
+		 */
+		static std::vector<StrideType> computeStrides(const Shape<IndexType> &shape) {
+			const int nrDims = static_cast<int>(shape.getNrDimensions());
+			std::vector<StrideType> strides(nrDims);
+
+			StrideType stride = 1;
+			for (int axis = nrDims - 1; axis >= 0; axis--) {
+				strides[axis] = stride;
+				stride *= shape[axis];
+			}
+			return strides;
+		}
+
+	  private:
+		T *data;
+		Shape<IndexType> shape;
+		std::vector<StrideType> strides;
+		StrideType offset;
+	};
+
+} // namespace Ritsu
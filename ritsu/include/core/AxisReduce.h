@@ -0,0 +1,270 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Valdemar Lindberg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ */
+#pragma once
+#include "../Math.h"
+#include "../RitsuDef.h"
+#include "CpuDispatch.h"
+#include "Shape.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace Ritsu {
+
+	/**
+	 * @brief Sum, mean and variance along a single axis of a contiguous tensor.
+	 *
+	 *	The input is seen as [outer, dim, inner], where dim is the reduced axis, outer the product of
+	 *	the axes before it and inner the product of the axes after it. The output is [outer, inner],
+	 *	the shape of the input with the reduced axis kept as 1. When inner is 1 each output is the sum
+	 *	of a contiguous row, vectorized along the row. Otherwise the rows of the reduced axis are
+	 *	added into the output, vectorized along the kept inner axes. The result only depends on the
+	 *	shape, not on the number of threads.
+	 */
+	template <typename IndexType> class AxisReduce {
+	  public:
+		struct Layout {
+			size_t outer; /*	Number of elements of the axes before the reduced axis.	*/
+			size_t dim;	  /*	Number of elements along the reduced axis.	*/
+			size_t inner; /*	Number of elements of the axes after the reduced axis.	*/
+		};
+
+		/**
+		 * @brief Layout of reducing the shape along the axis, negative axes count from the end.
+		 */
+		static Layout computeLayout(const Shape<IndexType> &shape, const int axis) {
+			const int nrDims = static_cast<int>(shape.getNrDimensions());
+			if (nrDims == 0 || axis >= nrDims || axis < -nrDims) {
+				throw InvalidArgumentException("Axis out of range of the shape.");
+			}
+
+			const int axisIndex = Math::mod<int>(axis, nrDims);
+			Layout layout{1, shape[axisIndex], 1};
+			for (int i = 0; i < axisIndex; i++) {
+				layout.outer *= shape[i];
+			}
+			for (int i = axisIndex + 1; i < nrDims; i++) {
+				layout.inner *= shape[i];
+			}
+			return layout;
+		}
+
+		/**
+		 * @brief Shape of the result, the reduced axis kept with a dimension of 1.
+		 */
+		static Shape<IndexType> computeShape(const Shape<IndexType> &shape, const int axis) {
+			AxisReduce::computeLayout(shape, axis);
+
+			Shape<IndexType> result = shape;
+			result[Math::mod<int>(axis, static_cast<int>(shape.getNrDimensions()))] = 1;
+			return result;
+		}
+
+		/**
+		 * @brief output[o, i] = sum_k input[o, k, i].
+		 */
+		template <typename T> static void sum(const T *input, T *output, const Layout &layout) {
+			AxisReduce::reduce<false, T>(input, nullptr, output, layout);
+		}
+
+		/**
+		 * @brief output[o, i] = sum_k input[o, k, i] / dim.
+		 */
+		template <typename T> static void mean(const T *input, T *output, const Layout &layout) {
+			AxisReduce::reduce<false, T>(input, nullptr, output, layout);
+			AxisReduce::divide<T>(output, layout.outer * layout.inner, layout.dim);
+		}
+
+		/**
+		 * @brief Sample variance, output[o, i] = sum_k (input[o, k, i] - mean[o, i])^2 / (dim - 1).
+		 */
+		template <typename T> static void variance(const T *input, const T *mean, T *output, const Layout &layout) {
+			AxisReduce::reduce<true, T>(input, mean, output, layout);
+			AxisReduce::divide<T>(output, layout.outer * layout.inner, layout.dim > 1 ? layout.dim - 1 : 1);
+		}
+
+	  private:
+		/*	Number of elements of the kept inner axes added per block, small enough for the partial
+		 *	sums to stay in the L1 cache.	*/
+		static constexpr size_t InnerTile = 1024;
+		/*	Below this many independent blocks of outputs, the reduced axis is split as well.	*/
+		static constexpr size_t MinBlocks = 64;
+
+		template <bool Deviation, typename T>
+		static void reduce(const T *input, const T *mean, T *output, const Layout &layout) {
+			if (layout.outer * layout.inner == 0) {
+				return;
+			}
+			if (layout.dim == 0) {
+				std::fill(output, output + layout.outer * layout.inner, static_cast<T>(0));
+				return;
+			}
+
+			if (layout.inner == 1) {
+				AxisReduce::reduceRows<Deviation, T>(input, mean, output, layout);
+			} else {
+				AxisReduce::reduceColumns<Deviation, T>(input, mean, output, layout);
+			}
+		}
+
+		/*	Reduction along the contiguous axis, one row per output.	*/
+		template <bool Deviation, typename T>
+		static void reduceRows(const T *input, const T *mean, T *output, const Layout &layout) {
+			const size_t dim = layout.dim;
+
+			/*	Few long rows, each row is split over the threads.	*/
+			if (layout.outer < MinBlocks && dim > CpuDispatch::BlockSize) {
+				for (size_t row = 0; row < layout.outer; row++) {
+					const T *rowInput = &input[row * dim];
+					const T rowMean = Deviation ? mean[row] : static_cast<T>(0);
+					output[row] = CpuDispatch::parallelReduce<T>(
+						dim,
+						[rowInput, rowMean](const size_t begin, const size_t end) {
+							if constexpr (Deviation) {
+								return Math::sumSquaredDeviation<T>(rowInput, begin, end, rowMean);
+							} else {
+								return Math::sumRange<T>(rowInput, begin, end);
+							}
+						},
+						[](const T a, const T b) { return a + b; });
+				}
+				return;
+			}
+
+			/*	Blocks of whole rows.	*/
+			const size_t rowsPerBlock = std::max<size_t>(1, CpuDispatch::BlockSize / dim);
+			const size_t nrBlocks = (layout.outer + rowsPerBlock - 1) / rowsPerBlock;
+
+			const bool threaded =
+				nrBlocks > 1 && CpuDispatch::selectPath(layout.outer * dim) == ExecutionPath::Threaded;
+
+			CpuDispatch::parallelForEach(nrBlocks, threaded, [&](const size_t block) {
+				const size_t first = block * rowsPerBlock;
+				const size_t last = std::min(first + rowsPerBlock, layout.outer);
+
+				CpuDispatch::invoke([&]() {
+					for (size_t row = first; row < last; row++) {
+						if constexpr (Deviation) {
+							output[row] = Math::sumSquaredDeviation<T>(&input[row * dim], 0, dim, mean[row]);
+						} else {
+							output[row] = Math::sumRange<T>(&input[row * dim], 0, dim);
+						}
+					}
+				});
+			});
+		}
+
+		/*	Reduction along an outer axis, the rows of the reduced axis are added element wise.	*/
+		template <bool Deviation, typename T>
+		static void reduceColumns(const T *input, const T *mean, T *output, const Layout &layout) {
+			const size_t dim = layout.dim;
+			const size_t inner = layout.inner;
+			const size_t nrTiles = (inner + InnerTile - 1) / InnerTile;
+			const size_t nrOutputBlocks = layout.outer * nrTiles;
+
+			/*	Split the reduced axis into chunks when there are too few outputs to go around, the
+			 *	partial sums of the chunks are added afterwards in order.	*/
+			size_t nrChunks = 1;
+			if (nrOutputBlocks < MinBlocks) {
+				const size_t tileWidth = std::min(inner, InnerTile);
+				const size_t minRows = std::max<size_t>(1, CpuDispatch::BlockSize / tileWidth);
+				nrChunks = std::max<size_t>(1, std::min(dim / minRows, MinBlocks / nrOutputBlocks));
+			}
+			const size_t rowsPerChunk = (dim + nrChunks - 1) / nrChunks;
+			nrChunks = (dim + rowsPerChunk - 1) / rowsPerChunk;
+
+			/*	Partial sums of each chunk, in the layout [chunk, outer, inner].	*/
+			std::unique_ptr<T[]> partials(nrChunks > 1 ? new T[nrChunks * layout.outer * inner] : nullptr);
+			const size_t nrBlocks = nrOutputBlocks * nrChunks;
+
+			const bool threaded =
+				nrBlocks > 1 && CpuDispatch::selectPath(layout.outer * dim * inner) == ExecutionPath::Threaded;
+
+			CpuDispatch::parallelForEach(nrBlocks, threaded, [&](const size_t block) {
+				const size_t chunk = block / nrOutputBlocks;
+				const size_t outer = (block % nrOutputBlocks) / nrTiles;
+				const size_t tile = block % nrTiles;
+
+				const size_t begin = tile * InnerTile;
+				const size_t width = std::min(InnerTile, inner - begin);
+				const size_t firstRow = chunk * rowsPerChunk;
+				const size_t lastRow = std::min(firstRow + rowsPerChunk, dim);
+
+				const T *outerInput = &input[outer * dim * inner + begin];
+				const T *tileMean = Deviation ? &mean[outer * inner + begin] : nullptr;
+				T *sum = nrChunks > 1 ? &partials[(chunk * layout.outer + outer) * inner + begin]
+									  : &output[outer * inner + begin];
+
+				CpuDispatch::invoke([&]() {
+#pragma omp simd
+					for (size_t i = 0; i < width; i++) {
+						sum[i] = 0;
+					}
+					for (size_t row = firstRow; row < lastRow; row++) {
+						const T *rowInput = &outerInput[row * inner];
+						if constexpr (Deviation) {
+#pragma omp simd
+							for (size_t i = 0; i < width; i++) {
+								const T deviation = rowInput[i] - tileMean[i];
+								sum[i] += deviation * deviation;
+							}
+						} else {
+#pragma omp simd
+							for (size_t i = 0; i < width; i++) {
+								sum[i] += rowInput[i];
+							}
+						}
+					}
+				});
+			});
+
+			if (nrChunks > 1) {
+				const size_t nrOutputs = layout.outer * inner;
+				CpuDispatch::parallelFor(nrOutputs, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+					for (size_t i = begin; i < end; i++) {
+						output[i] = partials[i];
+					}
+					for (size_t chunk = 1; chunk < nrChunks; chunk++) {
+						const T *chunkSum = &partials[chunk * nrOutputs];
+#pragma omp simd
+						for (size_t i = begin; i < end; i++) {
+							output[i] += chunkSum[i];
+						}
+					}
+				});
+			}
+		}
+
+		template <typename T> static void divide(T *output, const size_t nrElements, const size_t divisor) {
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+				if constexpr (std::is_floating_point_v<T>) {
+					const T inverse = static_cast<T>(1) / static_cast<T>(divisor);
+#pragma omp simd
+					for (size_t i = begin; i < end; i++) {
+						output[i] *= inverse;
+					}
+				} else {
+					for (size_t i = begin; i < end; i++) {
+						output[i] = static_cast<T>(output[i] / static_cast<T>(divisor));
+					}
+				}
+			});
+		}
+	};
+
+} // namespace Ritsu
@@ -0,0 +1,252 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Valdemar Lindberg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ */
+#pragma once
+#include "../RitsuDef.h"
+#include "CpuDispatch.h"
+#include "Shape.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Ritsu {
+
+	/**
+	 * @brief NumPy style broadcasting of two shapes.
+	 *
+	 *	Shapes are aligned on the last axis, the last axis being contiguous in memory. Two
+	 *	dimensions are compatible when equal or when one of them is 1, missing leading axes are
+	 *	treated as 1. A broadcast operand is never materialized, its axes are read with a stride of 0.
+	 */
+	template <typename IndexType> class Broadcast {
+	  public:
+		static bool isBroadcastable(const Shape<IndexType> &shapeA, const Shape<IndexType> &shapeB) noexcept {
+			const int nrDimA = static_cast<int>(shapeA.getNrDimensions());
+			const int nrDimB = static_cast<int>(shapeB.getNrDimensions());
+
+			for (int i = 1; i <= std::min(nrDimA, nrDimB); i++) {
+				const IndexType dimA = shapeA[nrDimA - i];
+				const IndexType dimB = shapeB[nrDimB - i];
+				if (dimA != dimB && dimA != 1 && dimB != 1) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/**
+		 * @brief Shape of the result of a binary operation between the two shapes.
+		 */
+		static Shape<IndexType> computeShape(const Shape<IndexType> &shapeA, const Shape<IndexType> &shapeB) {
+			if (shapeA == shapeB) {
+				return shapeA;
+			}
+
+			if (!isBroadcastable(shapeA, shapeB)) {
+				throw InvalidArgumentException("Shapes can not be broadcast together.");
+			}
+
+			const int nrDimA = static_cast<int>(shapeA.getNrDimensions());
+			const int nrDimB = static_cast<int>(shapeB.getNrDimensions());
+			const int nrDims = std::max(nrDimA, nrDimB);
+
+			std::vector<IndexType> dims(nrDims);
+			for (int i = 1; i <= nrDims; i++) {
+				const IndexType dimA = i <= nrDimA ? shapeA[nrDimA - i] : 1;
+				const IndexType dimB = i <= nrDimB ? shapeB[nrDimB - i] : 1;
+				dims[nrDims - i] = dimA == 1 ? dimB : dimA;
+			}
+
+			return Shape<IndexType>(dims);
+		}
+
+		/**
+		 * @brief Compute output = op(a, b) for each element of the output shape, where output shape
+		 *	is the broadcast shape of the two operands. The output may alias an operand that is not
+		 *	broadcast.
+		 */
+		template <typename TA, typename TB, typename TO, typename Op>
+		static void apply(const TA *a, const Shape<IndexType> &shapeA, const TB *b, const Shape<IndexType> &shapeB,
+						  TO *output, const Shape<IndexType> &shapeOutput, Op op) {
+
+			const size_t nrElements = shapeOutput.getNrElements();
+			const size_t nrElementsA = shapeA.getNrElements();
+			const size_t nrElementsB = shapeB.getNrElements();
+
+			/*	Equal shapes, a single flat pass.	*/
+			if (nrElementsA == nrElements && nrElementsB == nrElements) {
+				CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+					for (size_t i = begin; i < end; i++) {
+						output[i] = op(a[i], b[i]);
+					}
+				});
+				return;
+			}
+
+			/*	Scalar operand.	*/
+			if (nrElementsB == 1 && nrElementsA == nrElements) {
+				const TB valueB = b[0];
+				CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+					for (size_t i = begin; i < end; i++) {
+						output[i] = op(a[i], valueB);
+					}
+				});
+				return;
+			}
+			if (nrElementsA == 1 && nrElementsB == nrElements) {
+				const TA valueA = a[0];
+				CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+					for (size_t i = begin; i < end; i++) {
+						output[i] = op(valueA, b[i]);
+					}
+				});
+				return;
+			}
+
+			/*	General case, merge adjacent axes with the same broadcast pattern, then iterate the
+			 *	outer axes with the innermost merged axis as a contiguous (or stride 0) loop.	*/
+			const std::vector<Axis> axes = mergeAxes(shapeA, shapeB, shapeOutput);
+			if (axes.empty()) {
+				output[0] = op(a[0], b[0]);
+				return;
+			}
+
+			/*	32-bit offsets whenever the output fits, 64-bit division is notably slower.	*/
+			if (nrElements <= std::numeric_limits<uint32_t>::max()) {
+				Broadcast::applyAxes<uint32_t>(a, b, output, axes, nrElements, op);
+			} else {
+				Broadcast::applyAxes<size_t>(a, b, output, axes, nrElements, op);
+			}
+		}
+
+	  private:
+		struct Axis {
+			size_t dim;		/*	Number of elements in the output along the axis.	*/
+			size_t strideA; /*	Stride in elements of operand A, 0 if broadcast.	*/
+			size_t strideB; /*	Stride in elements of operand B, 0 if broadcast.	*/
+		};
+
+		template <typename OffsetType, typename TA, typename TB, typename TO, typename Op>
+		static void applyAxes(const TA *a, const TB *b, TO *output, const std::vector<Axis> &axes,
+							  const size_t nrElements, Op op) {
+
+			const Axis inner = axes[0];
+			const OffsetType innerDim = static_cast<OffsetType>(inner.dim);
+			const OffsetType nrOuter = static_cast<OffsetType>(nrElements / inner.dim);
+
+			const bool threaded = CpuDispatch::selectPath(nrElements) == ExecutionPath::Threaded;
+
+			CpuDispatch::parallelForEach(static_cast<size_t>(nrOuter), threaded, [&](const size_t index) {
+				const OffsetType outer = static_cast<OffsetType>(index);
+
+				/*	Offset of the operands from the outer multi index.	*/
+				OffsetType offsetA = 0;
+				OffsetType offsetB = 0;
+				OffsetType remainder = outer;
+				for (size_t axis = 1; axis < axes.size(); axis++) {
+					const OffsetType dim = static_cast<OffsetType>(axes[axis].dim);
+					const OffsetType index = remainder % dim;
+					remainder /= dim;
+					offsetA += index * static_cast<OffsetType>(axes[axis].strideA);
+					offsetB += index * static_cast<OffsetType>(axes[axis].strideB);
+				}
+
+				const TA *rowA = &a[offsetA];
+				const TB *rowB = &b[offsetB];
+				TO *rowOutput = &output[static_cast<size_t>(outer) * innerDim];
+
+				CpuDispatch::invoke([&]() {
+					if (inner.strideA != 0 && inner.strideB != 0) {
+#pragma omp simd
+						for (OffsetType i = 0; i < innerDim; i++) {
+							rowOutput[i] = op(rowA[i], rowB[i]);
+						}
+					} else if (inner.strideA != 0) {
+						const TB valueB = rowB[0];
+#pragma omp simd
+						for (OffsetType i = 0; i < innerDim; i++) {
+							rowOutput[i] = op(rowA[i], valueB);
+						}
+					} else if (inner.strideB != 0) {
+						const TA valueA = rowA[0];
+#pragma omp simd
+						for (OffsetType i = 0; i < innerDim; i++) {
+							rowOutput[i] = op(valueA, rowB[i]);
+						}
+					} else {
+						const TO value = op(rowA[0], rowB[0]);
+#pragma omp simd
+						for (OffsetType i = 0; i < innerDim; i++) {
+							rowOutput[i] = value;
+						}
+					}
+				});
+			});
+		}
+
+		/**
+		 * @brief Output axes, innermost first, with axes of dimension 1 removed and consecutive
+		 *	axes broadcast in the same way merged into one.
+		 */
+		static std::vector<Axis> mergeAxes(const Shape<IndexType> &shapeA, const Shape<IndexType> &shapeB,
+										   const Shape<IndexType> &shapeOutput) {
+			const int nrDimA = static_cast<int>(shapeA.getNrDimensions());
+			const int nrDimB = static_cast<int>(shapeB.getNrDimensions());
+			const int nrDims = static_cast<int>(shapeOutput.getNrDimensions());
+
+			std::vector<Axis> axes;
+			std::vector<bool> broadcastA;
+			std::vector<bool> broadcastB;
+
+			for (int i = 1; i <= nrDims; i++) {
+				const size_t dim = shapeOutput[nrDims - i];
+				if (dim == 1) {
+					continue;
+				}
+				const bool isBroadcastA = (i <= nrDimA ? shapeA[nrDimA - i] : 1) == 1;
+				const bool isBroadcastB = (i <= nrDimB ? shapeB[nrDimB - i] : 1) == 1;
+
+				if (!axes.empty() && broadcastA.back() == isBroadcastA && broadcastB.back() == isBroadcastB) {
+					axes.back().dim *= dim;
+				} else {
+					axes.push_back({dim, 0, 0});
+					broadcastA.push_back(isBroadcastA);
+					broadcastB.push_back(isBroadcastB);
+				}
+			}
+
+			/*	Strides of the merged axes.	*/
+			size_t strideA = 1;
+			size_t strideB = 1;
+			for (size_t i = 0; i < axes.size(); i++) {
+				if (!broadcastA[i]) {
+					axes[i].strideA = strideA;
+					strideA *= axes[i].dim;
+				}
+				if (!broadcastB[i]) {
+					axes[i].strideB = strideB;
+					strideB *= axes[i].dim;
+				}
+			}
+
+			return axes;
+		}
+	};
+
+} // namespace Ritsu
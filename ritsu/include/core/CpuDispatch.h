@@ -0,0 +1,559 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Valdemar Lindberg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ */
+#pragma once
+#include "../RitsuDef.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RITSU_CPU_X86 1
+/*	Instruction set of a single function, independent of the flags the translation unit is built with.	*/
+#define RITSU_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define RITSU_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define RITSU_TARGET_AVX512 __attribute__((target("avx512f,avx512vl,avx512bw,avx512dq,avx2,fma")))
+#endif
+
+namespace Ritsu {
+
+	/**
+	 * @brief Instruction set tiers of the SIMD kernels, in increasing order on each architecture.
+	 */
+	enum class CpuTier : unsigned int {
+		Generic = 0, /*	Baseline of the compile flags.	*/
+		SSE42 = 1,	 /*	x86 SSE4.2.	*/
+		AVX2 = 2,	 /*	x86 AVX2 and FMA.	*/
+		AVX512 = 3,	 /*	x86 AVX-512 F, VL, BW and DQ.	*/
+		NEON = 4,	 /*	ARM Advanced SIMD.	*/
+	};
+
+	/**
+	 * @brief How parallelFor and parallelReduce ran a kernel.
+	 */
+	enum class ExecutionPath : unsigned int {
+		Serial = 0,	  /*	Inline in the caller, too few elements to be worth dispatching.	*/
+		Simd = 1,	  /*	Kernel of the current tier, on the calling thread.	*/
+		Threaded = 2, /*	Kernel of the current tier, blocks distributed over the threads.	*/
+	};
+
+	/**
+	 * @brief Selects the instruction set of the SIMD kernels at runtime.
+	 *
+	 *	The kernels are compiled once per tier with the target attribute, thus the library does
+	 *	not have to be built with -march=native to use the instructions of the machine it runs on.
+	 *	The tier is detected once from cpuid, and can be forced with the RITSU_CPU_TIER environment
+	 *	variable (generic, sse4.2, avx2, avx512, neon) or with setTier.
+	 *
+	 *	The threaded kernels run on the OpenMP threads, or on a ThreadPool when the library is built
+	 *	without OpenMP, with RITSU_THREAD_POOL defined, or when the application sets its own pool.
+	 */
+	class CpuDispatch {
+	  public:
+		/**
+		 * @brief Tier the kernels are currently dispatched to.
+		 */
+		static inline CpuTier getTier() noexcept { return CpuDispatch::current().load(std::memory_order_relaxed); }
+
+		/**
+		 * @brief Force the kernels to a tier, it must be supported by the processor.
+		 */
+		static void setTier(const CpuTier tier) {
+			if (!CpuDispatch::isSupported(tier)) {
+				throw NotSupportedException("CPU tier is not supported by the processor.");
+			}
+			CpuDispatch::current().store(tier, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Restore the tier detected from the processor.
+		 */
+		static void resetTier() noexcept {
+			CpuDispatch::current().store(CpuDispatch::getDetectedTier(), std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Highest tier supported by the processor.
+		 */
+		static CpuTier getDetectedTier() noexcept {
+			static const CpuTier detected = CpuDispatch::detect();
+			return detected;
+		}
+
+		static bool isSupported(const CpuTier tier) noexcept {
+			const CpuTier detected = CpuDispatch::getDetectedTier();
+			switch (tier) {
+			case CpuTier::Generic:
+				return true;
+			case CpuTier::NEON:
+				return detected == CpuTier::NEON;
+			default:
+				return detected != CpuTier::NEON && static_cast<unsigned int>(tier) <= static_cast<unsigned int>(detected);
+			}
+		}
+
+		static const char *getTierName(const CpuTier tier) noexcept {
+			switch (tier) {
+			case CpuTier::SSE42:
+				return "sse4.2";
+			case CpuTier::AVX2:
+				return "avx2";
+			case CpuTier::AVX512:
+				return "avx512";
+			case CpuTier::NEON:
+				return "neon";
+			case CpuTier::Generic:
+			default:
+				return "generic";
+			}
+		}
+
+		/**
+		 * @brief Tier of a name as returned by getTierName.
+		 */
+		static CpuTier parseTier(const char *name) {
+			const CpuTier tiers[] = {CpuTier::Generic, CpuTier::SSE42, CpuTier::AVX2, CpuTier::AVX512, CpuTier::NEON};
+			for (const CpuTier tier : tiers) {
+				if (std::strcmp(name, CpuDispatch::getTierName(tier)) == 0) {
+					return tier;
+				}
+			}
+			throw InvalidArgumentException("Unknown CPU tier.");
+		}
+
+		/**
+		 * @brief Run the kernel compiled for the current tier. The kernel is a callable with no
+		 *	arguments, inlined into a copy of the caller per tier. OpenMP parallel regions inside the
+		 *	kernel are outlined before inlining and thus only run generic code, split the work across
+		 *	threads outside the kernel instead.
+		 */
+		template <typename Kernel> static inline void invoke(const Kernel &kernel) {
+			switch (CpuDispatch::getTier()) {
+#if defined(RITSU_CPU_X86)
+			case CpuTier::AVX512:
+				CpuDispatch::invokeAVX512(kernel);
+				break;
+			case CpuTier::AVX2:
+				CpuDispatch::invokeAVX2(kernel);
+				break;
+			case CpuTier::SSE42:
+				CpuDispatch::invokeSSE42(kernel);
+				break;
+#endif
+			default:
+				kernel();
+				break;
+			}
+		}
+
+		/**
+		 * @brief Run kernel(begin, end) over [0, nrElements). The path is chosen by the number of
+		 *	elements, see getPath. Threaded, the range is split into blocks distributed over the
+		 *	threads, otherwise the kernel is called once for the whole range.
+		 */
+		template <typename Kernel> static void parallelFor(const size_t nrElements, const Kernel &kernel) {
+			const ExecutionPath path = CpuDispatch::selectPath(nrElements);
+
+			if (path == ExecutionPath::Serial) {
+				kernel(static_cast<size_t>(0), nrElements);
+				return;
+			}
+			if (path == ExecutionPath::Simd) {
+				CpuDispatch::invoke([&]() { kernel(static_cast<size_t>(0), nrElements); });
+				return;
+			}
+
+			const size_t nrBlocks = (nrElements + CpuDispatch::BlockSize - 1) / CpuDispatch::BlockSize;
+
+			CpuDispatch::parallelForEach(nrBlocks, true, [&](const size_t block) {
+				const size_t begin = block * CpuDispatch::BlockSize;
+				const size_t end = begin + CpuDispatch::BlockSize < nrElements ? begin + CpuDispatch::BlockSize : nrElements;
+				CpuDispatch::invoke([&]() { kernel(begin, end); });
+			});
+		}
+
+		/**
+		 * @brief Reduce [0, nrElements) with kernel(begin, end) per block, the results of the
+		 *	blocks are combined pairwise with combine(a, b). The blocks and the order of combination
+		 *	only depend on the number of elements, the path only decides whether the blocks are
+		 *	distributed over the threads, thus the result is the same for any number of threads.
+		 */
+		template <typename Result, typename Kernel, typename Combine>
+		static Result parallelReduce(const size_t nrElements, const Kernel &kernel, const Combine &combine) {
+			const size_t nrBlocks = (nrElements + CpuDispatch::BlockSize - 1) / CpuDispatch::BlockSize;
+			const ExecutionPath path = CpuDispatch::selectPath(nrElements);
+
+			if (nrBlocks <= 1) {
+				if (path == ExecutionPath::Serial) {
+					return kernel(static_cast<size_t>(0), nrElements);
+				}
+				Result result;
+				CpuDispatch::invoke([&]() { result = kernel(static_cast<size_t>(0), nrElements); });
+				return result;
+			}
+
+			std::vector<Result> partials(nrBlocks);
+			const auto computeBlock = [&](const size_t block) {
+				const size_t begin = block * CpuDispatch::BlockSize;
+				const size_t end = begin + CpuDispatch::BlockSize < nrElements ? begin + CpuDispatch::BlockSize : nrElements;
+				partials[block] = kernel(begin, end);
+			};
+
+			if (path == ExecutionPath::Threaded) {
+				CpuDispatch::parallelForEach(nrBlocks, true,
+											 [&](const size_t block) { CpuDispatch::invoke([&]() { computeBlock(block); }); });
+			} else {
+				CpuDispatch::invoke([&]() {
+					for (size_t block = 0; block < nrBlocks; block++) {
+						computeBlock(block);
+					}
+				});
+			}
+
+			/*	Fixed binary tree, neighbours first.	*/
+			for (size_t stride = 1; stride < nrBlocks; stride *= 2) {
+				for (size_t index = 0; index + stride < nrBlocks; index += 2 * stride) {
+					partials[index] = combine(partials[index], partials[index + stride]);
+				}
+			}
+			return partials[0];
+		}
+
+		/**
+		 * @brief Run kernel(index) for each index in [0, count), distributed over the threads if
+		 *	threaded, on the calling thread otherwise. For kernels that split the work themselves,
+		 *	e.g. by rows, with the path from selectPath. The kernel dispatches to the tier itself.
+		 */
+		template <typename Kernel>
+		static void parallelForEach(const size_t count, const bool threaded, const Kernel &kernel) {
+			ThreadPool *pool = threaded ? CpuDispatch::getThreadPool() : nullptr;
+			if (pool != nullptr) {
+				/*	A few chunks per thread, to balance uneven indices by stealing.	*/
+				const size_t nrChunks = static_cast<size_t>(pool->getNrThreads()) * 4;
+				pool->parallelFor(count, (count + nrChunks - 1) / nrChunks, [&](const size_t begin, const size_t end) {
+					for (size_t index = begin; index < end; index++) {
+						kernel(index);
+					}
+				});
+				return;
+			}
+
+#pragma omp parallel for schedule(static) if (threaded)
+			for (size_t index = 0; index < count; index++) {
+				kernel(index);
+			}
+		}
+
+		/**
+		 * @brief Path of a kernel over nrElements. Serial below SerialThreshold elements, threaded
+		 *	from the parallel threshold on when more than one thread is available and the caller is
+		 *	not already in a parallel region, SIMD on the calling thread otherwise.
+		 */
+		static ExecutionPath getPath(const size_t nrElements) noexcept {
+			if (nrElements < CpuDispatch::SerialThreshold) {
+				return ExecutionPath::Serial;
+			}
+			/*	A single block is never split, check it before the threshold, it may have to be tuned.	*/
+			if (nrElements <= CpuDispatch::BlockSize || !CpuDispatch::canThread()) {
+				return ExecutionPath::Simd;
+			}
+			return nrElements >= CpuDispatch::getParallelThreshold() ? ExecutionPath::Threaded : ExecutionPath::Simd;
+		}
+
+		/**
+		 * @brief getPath, reported to the profiler hook. Used by the kernels that split the work over
+		 *	the threads themselves, e.g. by rows, with an if clause on the parallel region.
+		 */
+		static ExecutionPath selectPath(const size_t nrElements) {
+			const ExecutionPath path = CpuDispatch::getPath(nrElements);
+			const ProfilerHook hook = CpuDispatch::getProfilerHook();
+			if (hook != nullptr) {
+				hook(path, nrElements);
+			}
+			return path;
+		}
+
+		static const char *getPathName(const ExecutionPath path) noexcept {
+			switch (path) {
+			case ExecutionPath::Serial:
+				return "serial";
+			case ExecutionPath::Simd:
+				return "simd";
+			case ExecutionPath::Threaded:
+			default:
+				return "threaded";
+			}
+		}
+
+		/**
+		 * @brief Smallest number of elements run on multiple threads. Set by the
+		 *	RITSU_PARALLEL_THRESHOLD environment variable, otherwise measured on first use as the
+		 *	smallest size where splitting a streaming kernel over the threads is faster than running
+		 *	it on one.
+		 */
+		static size_t getParallelThreshold() noexcept {
+			size_t threshold = CpuDispatch::parallelThreshold().load(std::memory_order_relaxed);
+			if (threshold == 0) {
+				threshold = CpuDispatch::getInitialParallelThreshold();
+				CpuDispatch::parallelThreshold().store(threshold, std::memory_order_relaxed);
+			}
+			return threshold;
+		}
+
+		static void setParallelThreshold(const size_t nrElements) noexcept {
+			CpuDispatch::parallelThreshold().store(std::max<size_t>(nrElements, 1), std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Restore the threshold of the environment variable or the measured one.
+		 */
+		static void resetParallelThreshold() noexcept {
+			CpuDispatch::parallelThreshold().store(0, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Called with the path and the number of elements of each kernel dispatched, see
+		 *	selectPath, for profiling. nullptr to disable, the default.
+		 */
+		using ProfilerHook = void (*)(const ExecutionPath path, const size_t nrElements);
+
+		static void setProfilerHook(const ProfilerHook hook) noexcept {
+			CpuDispatch::profilerHook().store(hook, std::memory_order_relaxed);
+		}
+
+		static ProfilerHook getProfilerHook() noexcept {
+			return CpuDispatch::profilerHook().load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Run the threaded kernels on the pool, shared with the application. nullptr restores
+		 *	the default, the OpenMP threads, or a pool of ThreadPool::getDefaultNrThreads threads when
+		 *	built without OpenMP or with RITSU_THREAD_POOL. The pool must not be replaced while
+		 *	kernels are running. The parallel threshold is measured again for the new pool.
+		 */
+		static void setThreadPool(std::shared_ptr<ThreadPool> pool) {
+			std::lock_guard<std::mutex> guard(CpuDispatch::poolLock());
+			CpuDispatch::userPool().store(pool.get(), std::memory_order_release);
+			CpuDispatch::sharedPool() = std::move(pool);
+			CpuDispatch::resetParallelThreshold();
+		}
+
+		/**
+		 * @brief Pool the threaded kernels run on, nullptr when they run on the OpenMP threads.
+		 */
+		static ThreadPool *getThreadPool() noexcept {
+			ThreadPool *pool = CpuDispatch::userPool().load(std::memory_order_acquire);
+			if (pool != nullptr) {
+				return pool;
+			}
+#if defined(_OPENMP) && !defined(RITSU_THREAD_POOL)
+			return nullptr;
+#else
+			static ThreadPool defaultPool;
+			return &defaultPool;
+#endif
+		}
+
+		/**
+		 * @brief Number of threads of the threaded kernels.
+		 */
+		static unsigned int getNrThreads() noexcept {
+			const ThreadPool *pool = CpuDispatch::getThreadPool();
+			if (pool != nullptr) {
+				return pool->getNrThreads();
+			}
+#ifdef _OPENMP
+			return static_cast<unsigned int>(omp_get_max_threads());
+#else
+			return 1;
+#endif
+		}
+
+		/*	Number of elements of each block of parallelFor and parallelReduce.	*/
+		static constexpr size_t BlockSize = 8192;
+		/*	Below this number of elements, the kernel is run inline without the tier dispatch.	*/
+		static constexpr size_t SerialThreshold = 64;
+
+	  protected:
+		static std::atomic<CpuTier> &current() noexcept {
+			static std::atomic<CpuTier> tier(CpuDispatch::getInitialTier());
+			return tier;
+		}
+
+		static std::atomic<size_t> &parallelThreshold() noexcept {
+			static std::atomic<size_t> threshold(0);
+			return threshold;
+		}
+
+		static std::atomic<ProfilerHook> &profilerHook() noexcept {
+			static std::atomic<ProfilerHook> hook(nullptr);
+			return hook;
+		}
+
+		static std::mutex &poolLock() noexcept {
+			static std::mutex lock;
+			return lock;
+		}
+
+		static std::atomic<ThreadPool *> &userPool() noexcept {
+			static std::atomic<ThreadPool *> pool(nullptr);
+			return pool;
+		}
+
+		/*	Keeps the pool set by the application alive.	*/
+		static std::shared_ptr<ThreadPool> &sharedPool() noexcept {
+			static std::shared_ptr<ThreadPool> pool;
+			return pool;
+		}
+
+		/*	Work stealing lets the pool nest parallel kernels, OpenMP runs nested regions on a single thread.	*/
+		static bool canThread() noexcept {
+			const ThreadPool *pool = CpuDispatch::getThreadPool();
+			if (pool != nullptr) {
+				return pool->getNrThreads() > 1;
+			}
+#ifdef _OPENMP
+			return omp_get_max_threads() > 1 && !omp_in_parallel();
+#else
+			return false;
+#endif
+		}
+
+		static size_t getInitialParallelThreshold() noexcept {
+			const char *environment = std::getenv("RITSU_PARALLEL_THRESHOLD");
+			if (environment != nullptr) {
+				char *end = nullptr;
+				const unsigned long long threshold = std::strtoull(environment, &end, 10);
+				if (end != environment && *end == '\0' && threshold > 0) {
+					return static_cast<size_t>(threshold);
+				}
+			}
+			return CpuDispatch::measureParallelThreshold();
+		}
+
+		/*	Double the size until a streaming kernel split over the threads beats the calling thread.	*/
+		static size_t measureParallelThreshold() noexcept {
+			constexpr size_t MaxElements = static_cast<size_t>(1) << 20;
+			constexpr int Repeats = 5;
+
+			if (!CpuDispatch::canThread()) {
+				return 2 * MaxElements;
+			}
+
+			std::vector<float> data(MaxElements, 1.0f);
+			float *values = data.data();
+			const auto kernel = [values](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					values[i] = values[i] * 0.5f + 1.0f;
+				}
+			};
+
+			/*	Start the threads before measuring.	*/
+			CpuDispatch::parallelForEach(CpuDispatch::getNrThreads(), true, [](const size_t) {});
+
+			for (size_t nrElements = 2 * CpuDispatch::BlockSize; nrElements <= MaxElements; nrElements *= 2) {
+				const size_t nrBlocks = nrElements / CpuDispatch::BlockSize;
+				double serial = std::numeric_limits<double>::max();
+				double threaded = std::numeric_limits<double>::max();
+
+				for (int repeat = 0; repeat < Repeats; repeat++) {
+					auto start = std::chrono::steady_clock::now();
+					CpuDispatch::invoke([&]() { kernel(0, nrElements); });
+					const std::chrono::duration<double> serialTime = std::chrono::steady_clock::now() - start;
+					serial = std::min(serial, serialTime.count());
+
+					start = std::chrono::steady_clock::now();
+					CpuDispatch::parallelForEach(nrBlocks, true, [&](const size_t block) {
+						const size_t begin = block * CpuDispatch::BlockSize;
+						CpuDispatch::invoke([&]() { kernel(begin, begin + CpuDispatch::BlockSize); });
+					});
+					const std::chrono::duration<double> threadedTime = std::chrono::steady_clock::now() - start;
+					threaded = std::min(threaded, threadedTime.count());
+				}
+
+				if (threaded < serial) {
+					return nrElements;
+				}
+			}
+			return 2 * MaxElements;
+		}
+
+		/*	The tier requested by the environment if supported, the detected tier otherwise.	*/
+		static CpuTier getInitialTier() noexcept {
+			const char *environment = std::getenv("RITSU_CPU_TIER");
+			if (environment != nullptr) {
+				try {
+					const CpuTier tier = CpuDispatch::parseTier(environment);
+					if (CpuDispatch::isSupported(tier)) {
+						return tier;
+					}
+				} catch (const InvalidArgumentException &) {
+				}
+			}
+			return CpuDispatch::getDetectedTier();
+		}
+
+		static CpuTier detect() noexcept {
+#if defined(RITSU_CPU_X86)
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+				__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq")) {
+				return CpuTier::AVX512;
+			}
+			if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+				return CpuTier::AVX2;
+			}
+			if (__builtin_cpu_supports("sse4.2")) {
+				return CpuTier::SSE42;
+			}
+			return CpuTier::Generic;
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+			/*	Advanced SIMD is part of the AArch64 baseline.	*/
+			return CpuTier::NEON;
+#else
+			return CpuTier::Generic;
+#endif
+		}
+
+#if defined(RITSU_CPU_X86)
+		template <typename Kernel>
+		RITSU_TARGET_SSE42 __attribute__((flatten, noinline)) static void invokeSSE42(const Kernel &kernel) {
+			kernel();
+		}
+
+		template <typename Kernel>
+		RITSU_TARGET_AVX2 __attribute__((flatten, noinline)) static void invokeAVX2(const Kernel &kernel) {
+			kernel();
+		}
+
+		template <typename Kernel>
+		RITSU_TARGET_AVX512 __attribute__((flatten, noinline)) static void invokeAVX512(const Kernel &kernel) {
+			kernel();
+		}
+#endif
+	};
+
+} // namespace Ritsu
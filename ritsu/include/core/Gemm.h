@@ -0,0 +1,770 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Valdemar Lindberg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ */
+#pragma once
+#include "CpuDispatch.h"
+#include "RuntimeConfig.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#if defined(RITSU_CPU_X86)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace Ritsu {
+
+	/**
+	 * @brief Blocking parameters of the packed GEMM for a CPU tier.
+	 *	MR x NR is the register tile computed by the micro kernel, KC is the depth of the
+	 *	packed panels (L1), MC the number of rows of A kept hot in L2 and NC the number of
+	 *	columns of B packed at once (L3).
+	 */
+	template <typename T, CpuTier Tier = CpuTier::Generic> struct GemmBlocking {
+		static constexpr size_t MR = 4;
+		static constexpr size_t NR = 8;
+		static constexpr size_t KC = 256;
+		static constexpr size_t MC = 64;
+		static constexpr size_t NC = 2048;
+	};
+
+	template <> struct GemmBlocking<float, CpuTier::AVX512> {
+		static constexpr size_t MR = 8;
+		static constexpr size_t NR = 32;
+		static constexpr size_t KC = 256;
+		static constexpr size_t MC = 128;
+		static constexpr size_t NC = 4096;
+	};
+	template <> struct GemmBlocking<double, CpuTier::AVX512> {
+		static constexpr size_t MR = 8;
+		static constexpr size_t NR = 16;
+		static constexpr size_t KC = 256;
+		static constexpr size_t MC = 64;
+		static constexpr size_t NC = 2048;
+	};
+	template <> struct GemmBlocking<float, CpuTier::AVX2> {
+		static constexpr size_t MR = 6;
+		static constexpr size_t NR = 16;
+		static constexpr size_t KC = 256;
+		static constexpr size_t MC = 96;
+		static constexpr size_t NC = 4096;
+	};
+	template <> struct GemmBlocking<double, CpuTier::AVX2> {
+		static constexpr size_t MR = 6;
+		static constexpr size_t NR = 8;
+		static constexpr size_t KC = 256;
+		static constexpr size_t MC = 48;
+		static constexpr size_t NC = 2048;
+	};
+	template <> struct GemmBlocking<float, CpuTier::NEON> {
+		static constexpr size_t MR = 8;
+		static constexpr size_t NR = 8;
+		static constexpr size_t KC = 256;
+		static constexpr size_t MC = 64;
+		static constexpr size_t NC = 2048;
+	};
+
+	/**
+	 * @brief Epilogue of a product that leaves the result as is, see Gemm::gemm.
+	 */
+	struct GemmIdentity {
+		template <typename T>
+		constexpr T operator()([[maybe_unused]] const size_t row, [[maybe_unused]] const size_t column,
+							   const T value) const noexcept {
+			return value;
+		}
+	};
+
+	/**
+	 * @brief The B operand of a product, packed ahead of time into the panels of the micro kernel for an
+	 *	operand that takes part in many products, such as the weights of a layer. It refers to the source
+	 *	matrix, which must not be modified while packed, see Gemm::pack.
+	 */
+	template <typename T> struct GemmPackedB {
+		std::vector<T> panels;
+		const T *source = nullptr;
+		std::ptrdiff_t rowStride = 0;
+		std::ptrdiff_t colStride = 0;
+		size_t K = 0;
+		size_t N = 0;
+		CpuTier tier = CpuTier::Generic;
+
+		void clear() noexcept {
+			this->panels.clear();
+			this->source = nullptr;
+		}
+	};
+
+	/**
+	 * @brief General matrix multiplication, C = alpha * A * B + beta * C.
+	 *	Each operand is described by a pointer together with a row and column stride, which
+	 *	allows both row-major and column-major (and transposed) operands without copying.
+	 *	Large products are computed by packing cache blocks of A and B into contiguous
+	 *	panels and sweeping a register tiled micro kernel over them. The output tiles are
+	 *	distributed over the threads, see CpuDispatch::parallelForEach. The micro kernel and
+	 *	blocking are those of the current CpuDispatch tier.
+	 */
+	class Gemm {
+	  public:
+		/**
+		 * @brief C[M x N] = epilogue(alpha * A[M x K] * B[K x N] + beta * C).
+		 *	When beta is zero, C is never read. The epilogue is called as epilogue(row, column, value) on
+		 *	each element of C once it is complete, while the block of C is still in cache, e.g. to add a
+		 *	bias and apply an activation without another pass over C.
+		 */
+		template <typename T, typename Epilogue = GemmIdentity>
+		static void gemm(const size_t M, const size_t N, const size_t K, const T alpha, const T *A,
+						 const std::ptrdiff_t rowStrideA, const std::ptrdiff_t colStrideA, const T *B,
+						 const std::ptrdiff_t rowStrideB, const std::ptrdiff_t colStrideB, const T beta, T *C,
+						 const std::ptrdiff_t rowStrideC, const std::ptrdiff_t colStrideC,
+						 const Epilogue &epilogue = Epilogue()) {
+			Gemm::gemmBatched<T, Epilogue>(1, M, N, K, alpha, A, 0, rowStrideA, colStrideA, B, 0, rowStrideB,
+										   colStrideB, beta, C, 0, rowStrideC, colStrideC, epilogue);
+		}
+
+		/**
+		 * @brief C[M x N] = epilogue(alpha * A[M x K] * B[K x N] + beta * C), with B packed by Gemm::pack.
+		 *	Matrix vector products, and a B packed for another tier, use the source of B instead.
+		 */
+		template <typename T, typename Epilogue = GemmIdentity>
+		static void gemm(const size_t M, const T alpha, const T *A, const std::ptrdiff_t rowStrideA,
+						 const std::ptrdiff_t colStrideA, const GemmPackedB<T> &B, const T beta, T *C,
+						 const std::ptrdiff_t rowStrideC, const std::ptrdiff_t colStrideC,
+						 const Epilogue &epilogue = Epilogue()) {
+
+			if (M <= 1 || B.N <= 1 || B.K == 0 || B.panels.empty() || B.tier != Gemm::getTier<T>()) {
+				Gemm::gemm<T, Epilogue>(M, B.N, B.K, alpha, A, rowStrideA, colStrideA, B.source, B.rowStride,
+										B.colStride, beta, C, rowStrideC, colStrideC, epilogue);
+				return;
+			}
+
+			Gemm::dispatchTier<T>([&](auto tier) {
+				Gemm::gemmPacked<T, decltype(tier)::value>(1, M, B.N, B.K, alpha, A, 0, rowStrideA, colStrideA,
+															B.source, 0, B.rowStride, B.colStride, beta, C, 0,
+															rowStrideC, colStrideC, epilogue, B.panels.data());
+			});
+		}
+
+		/**
+		 * @brief Pack B[K x N] into the panels of the micro kernel of the current tier, the same packing
+		 *	Gemm::gemm otherwise does on every call.
+		 */
+		template <typename T>
+		static void pack(const size_t K, const size_t N, const T *B, const std::ptrdiff_t rowStrideB,
+						 const std::ptrdiff_t colStrideB, GemmPackedB<T> &packed) {
+			Gemm::dispatchTier<T>([&](auto tier) {
+				constexpr CpuTier Tier = decltype(tier)::value;
+				using Block = GemmBlocking<T, Tier>;
+				constexpr size_t NR = Block::NR;
+
+				/*	Panels of each NC block of columns, for each KC slice of the rows, see gemmPacked.	*/
+				packed.panels.resize(((N + NR - 1) / NR) * NR * K);
+				RuntimeConfig::bindMemory(packed.panels.data(), packed.panels.size() * sizeof(T),
+										  RuntimeConfig::getWeightPolicy());
+
+				const bool parallel = (N * K) >= Gemm::ParallelThreshold;
+				for (size_t jc = 0; jc < N; jc += Block::NC) {
+					const size_t nc = std::min(Block::NC, N - jc);
+					const size_t nPanelsB = (nc + NR - 1) / NR;
+
+					for (size_t pc = 0; pc < K; pc += Block::KC) {
+						const size_t kc = std::min(Block::KC, K - pc);
+						T *slice = packed.panels.data() + jc * K + pc * nPanelsB * NR;
+
+						CpuDispatch::parallelForEach(nPanelsB, parallel, [&](const size_t panel) {
+							Gemm::packB<T, Tier>(kc, std::min(NR, nc - panel * NR),
+												 B + pc * rowStrideB + (jc + panel * NR) * colStrideB, rowStrideB,
+												 colStrideB, slice + panel * NR * kc);
+						});
+					}
+				}
+
+				packed.tier = Tier;
+			});
+
+			packed.source = B;
+			packed.rowStride = rowStrideB;
+			packed.colStride = colStrideB;
+			packed.K = K;
+			packed.N = N;
+		}
+
+		/**
+		 * @brief Check if packed holds B[K x N], packed for the current tier.
+		 */
+		template <typename T>
+		static bool isPacked(const GemmPackedB<T> &packed, const size_t K, const size_t N, const T *B,
+							 const std::ptrdiff_t rowStrideB, const std::ptrdiff_t colStrideB) noexcept {
+			return packed.source == B && packed.K == K && packed.N == N && packed.rowStride == rowStrideB &&
+				   packed.colStride == colStrideB && !(packed.panels.empty() && K * N > 0) &&
+				   packed.tier == Gemm::getTier<T>();
+		}
+
+		/**
+		 * @brief Tier of the micro kernel that products of T use.
+		 */
+		template <typename T> static CpuTier getTier() noexcept {
+			CpuTier current = CpuTier::Generic;
+			Gemm::dispatchTier<T>([&](auto tier) { current = decltype(tier)::value; });
+			return current;
+		}
+
+		/**
+		 * @brief C[b] = alpha * A[b] * B[b] + beta * C[b], for each of the batch matrices.
+		 *	A batch stride of zero broadcasts the same matrix to every batch, in which case
+		 *	it is only packed once for the whole batch. The epilogue is given the row and column within
+		 *	the batch matrix.
+		 */
+		template <typename T, typename Epilogue = GemmIdentity>
+		static void gemmBatched(const size_t batch, const size_t M, const size_t N, const size_t K, const T alpha,
+								const T *A, const std::ptrdiff_t batchStrideA, const std::ptrdiff_t rowStrideA,
+								const std::ptrdiff_t colStrideA, const T *B, const std::ptrdiff_t batchStrideB,
+								const std::ptrdiff_t rowStrideB, const std::ptrdiff_t colStrideB, const T beta, T *C,
+								const std::ptrdiff_t batchStrideC, const std::ptrdiff_t rowStrideC,
+								const std::ptrdiff_t colStrideC, const Epilogue &epilogue = Epilogue()) {
+
+			if (batch == 0 || M == 0 || N == 0) {
+				return;
+			}
+
+			if (K == 0) {
+				for (size_t b = 0; b < batch; b++) {
+					Gemm::scale<T>(M, N, beta, C + b * batchStrideC, rowStrideC, colStrideC);
+					Gemm::apply<T>(M, N, C + b * batchStrideC, rowStrideC, colStrideC, epilogue);
+				}
+				return;
+			}
+
+			/*	Matrix vector products gain nothing from packing.	*/
+			if (N == 1 || M == 1) {
+				const bool parallel = batch > 1 && (batch * M * N * K) >= Gemm::ParallelThreshold;
+
+				CpuDispatch::parallelForEach(batch, parallel, [&](const size_t b) {
+					if (N == 1) {
+						Gemm::gemv<T>(M, K, alpha, A + b * batchStrideA, rowStrideA, colStrideA, B + b * batchStrideB,
+									  rowStrideB, beta, C + b * batchStrideC, rowStrideC);
+					} else {
+						Gemm::gemv<T>(N, K, alpha, B + b * batchStrideB, colStrideB, rowStrideB, A + b * batchStrideA,
+									  colStrideA, beta, C + b * batchStrideC, colStrideC);
+					}
+					/*	The vector is still in cache.	*/
+					if constexpr (!std::is_same_v<Epilogue, GemmIdentity>) {
+						Gemm::apply<T>(M, N, C + b * batchStrideC, rowStrideC, colStrideC, epilogue);
+					}
+				});
+				return;
+			}
+
+			Gemm::dispatchTier<T>([&](auto tier) {
+				Gemm::gemmPacked<T, decltype(tier)::value>(batch, M, N, K, alpha, A, batchStrideA, rowStrideA,
+															colStrideA, B, batchStrideB, rowStrideB, colStrideB, beta, C,
+															batchStrideC, rowStrideC, colStrideC, epilogue, nullptr);
+			});
+		}
+
+		/**
+		 * @brief y[M] = alpha * A[M x K] * x[K] + beta * y.
+		 */
+		template <typename T>
+		static void gemv(const size_t M, const size_t K, const T alpha, const T *A, const std::ptrdiff_t rowStrideA,
+						 const std::ptrdiff_t colStrideA, const T *x, const std::ptrdiff_t incx, const T beta, T *y,
+						 const std::ptrdiff_t incy) {
+
+			const bool parallel = (M * K) >= Gemm::ParallelThreshold;
+
+			if (rowStrideA == 1) {
+				/*	Columns are contiguous, accumulate column by column onto each block of y.	*/
+				constexpr size_t block = 256;
+				const size_t nBlocks = (M + block - 1) / block;
+
+				CpuDispatch::parallelForEach(nBlocks, parallel, [&](const size_t b) {
+					const size_t start = b * block;
+					const size_t length = std::min(block, M - start);
+
+					alignas(64) T accumulator[block];
+					for (size_t i = 0; i < length; i++) {
+						accumulator[i] = 0;
+					}
+
+					CpuDispatch::invoke([&]() {
+						for (size_t k = 0; k < K; k++) {
+							const T *column = A + k * colStrideA + start;
+							const T xk = x[k * incx];
+#pragma omp simd
+							for (size_t i = 0; i < length; i++) {
+								accumulator[i] += column[i] * xk;
+							}
+						}
+					});
+
+					for (size_t i = 0; i < length; i++) {
+						T &out = y[(start + i) * incy];
+						const T value = static_cast<T>(alpha * accumulator[i]);
+						out = beta == static_cast<T>(0) ? value : static_cast<T>(value + beta * out);
+					}
+				});
+			} else {
+				CpuDispatch::parallelForEach(M, parallel, [&](const size_t i) {
+					const T *row = A + i * rowStrideA;
+					T sum = 0;
+#pragma omp simd reduction(+ : sum)
+					for (size_t k = 0; k < K; k++) {
+						sum += row[k * colStrideA] * x[k * incx];
+					}
+
+					T &out = y[i * incy];
+					const T value = static_cast<T>(alpha * sum);
+					out = beta == static_cast<T>(0) ? value : static_cast<T>(value + beta * out);
+				});
+			}
+		}
+
+	  protected:
+		/*	Number of multiply-adds before the work is split across threads.	*/
+		static constexpr size_t ParallelThreshold = 64 * 64 * 64;
+
+		/**
+		 * @brief Call function with the tier of the micro kernel, as an integral constant.
+		 */
+		template <typename T, typename Function> static void dispatchTier(Function &&function) {
+			/*	Integer products only have the generic micro kernel.	*/
+			if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+				switch (CpuDispatch::getTier()) {
+#if defined(RITSU_CPU_X86)
+				case CpuTier::AVX512:
+					function(std::integral_constant<CpuTier, CpuTier::AVX512>());
+					return;
+				case CpuTier::AVX2:
+					function(std::integral_constant<CpuTier, CpuTier::AVX2>());
+					return;
+#endif
+#if defined(__ARM_NEON)
+				case CpuTier::NEON:
+					function(std::integral_constant<CpuTier, CpuTier::NEON>());
+					return;
+#endif
+				default:
+					break;
+				}
+			}
+			function(std::integral_constant<CpuTier, CpuTier::Generic>());
+		}
+
+		template <typename T>
+		static void scale(const size_t M, const size_t N, const T beta, T *C, const std::ptrdiff_t rowStrideC,
+						  const std::ptrdiff_t colStrideC) noexcept {
+			for (size_t i = 0; i < M; i++) {
+				for (size_t j = 0; j < N; j++) {
+					T &out = C[i * rowStrideC + j * colStrideC];
+					out = beta == static_cast<T>(0) ? static_cast<T>(0) : static_cast<T>(beta * out);
+				}
+			}
+		}
+
+		/**
+		 * @brief Apply the epilogue to the M x N block of C at row, column, vectorized for the tier.
+		 */
+		template <typename T, typename Epilogue>
+		static void apply(const size_t M, const size_t N, T *C, const std::ptrdiff_t rowStrideC,
+						  const std::ptrdiff_t colStrideC, const Epilogue &epilogue, const size_t row = 0,
+						  const size_t column = 0) {
+			CpuDispatch::invoke([&]() {
+				for (size_t i = 0; i < M; i++) {
+					T *rowC = C + i * rowStrideC;
+					if (colStrideC == 1) {
+#pragma omp simd
+						for (size_t j = 0; j < N; j++) {
+							rowC[j] = epilogue(row + i, column + j, rowC[j]);
+						}
+					} else {
+						for (size_t j = 0; j < N; j++) {
+							rowC[j * colStrideC] = epilogue(row + i, column + j, rowC[j * colStrideC]);
+						}
+					}
+				}
+			});
+		}
+
+		/**
+		 * @brief Packed, cache blocked product with the micro kernel of the tier.
+		 *	B is read from prepackedB, packed by Gemm::pack, when given.
+		 */
+		template <typename T, CpuTier Tier, typename Epilogue>
+		static void gemmPacked(const size_t batch, const size_t M, const size_t N, const size_t K, const T alpha,
+							   const T *A, const std::ptrdiff_t batchStrideA, const std::ptrdiff_t rowStrideA,
+							   const std::ptrdiff_t colStrideA, const T *B, const std::ptrdiff_t batchStrideB,
+							   const std::ptrdiff_t rowStrideB, const std::ptrdiff_t colStrideB, const T beta, T *C,
+							   const std::ptrdiff_t batchStrideC, const std::ptrdiff_t rowStrideC,
+							   const std::ptrdiff_t colStrideC, const Epilogue &epilogue, const T *prepackedB) {
+
+			using Block = GemmBlocking<T, Tier>;
+			constexpr size_t MR = Block::MR;
+			constexpr size_t NR = Block::NR;
+
+			const bool parallel = (batch * M * N * K) >= Gemm::ParallelThreshold;
+			const size_t batchA = batchStrideA == 0 ? 1 : batch;
+			const size_t batchB = batchStrideB == 0 ? 1 : batch;
+
+			for (size_t jc = 0; jc < N; jc += Block::NC) {
+				const size_t nc = std::min(Block::NC, N - jc);
+				const size_t nPanelsB = (nc + NR - 1) / NR;
+
+				for (size_t pc = 0; pc < K; pc += Block::KC) {
+					const size_t kc = std::min(Block::KC, K - pc);
+					const size_t nPanelsA = (M + MR - 1) / MR;
+					const size_t nBlocksM = (M + Block::MC - 1) / Block::MC;
+
+					/*	Accumulate onto C after the first slice of K.	*/
+					const T beta_pc = pc == 0 ? beta : static_cast<T>(1);
+
+					const size_t packedSizeA = nPanelsA * MR * kc;
+					const size_t packedSizeB = nPanelsB * NR * kc;
+					T *packedA = Gemm::workspace<T>(0, batchA * packedSizeA);
+					T *packedB = prepackedB == nullptr ? Gemm::workspace<T>(1, batchB * packedSizeB) : nullptr;
+					const T *panelsB = prepackedB == nullptr ? packedB : prepackedB + jc * K + pc * nPanelsB * NR;
+
+					const T *blockA = A + pc * colStrideA;
+					const T *blockB = B + pc * rowStrideB + jc * colStrideB;
+					T *blockC = C + jc * colStrideC;
+
+					/*	The panels of B and of A packed together, one index space.	*/
+					const size_t nrPacksB = prepackedB == nullptr ? batchB * nPanelsB : 0;
+					CpuDispatch::parallelForEach(nrPacksB + batchA * nPanelsA, parallel, [&](const size_t index) {
+						if (index < nrPacksB) {
+							const size_t b = index / nPanelsB;
+							const size_t panel = index % nPanelsB;
+							Gemm::packB<T, Tier>(kc, std::min(NR, nc - panel * NR),
+												 blockB + b * batchStrideB + panel * NR * colStrideB, rowStrideB,
+												 colStrideB, packedB + b * packedSizeB + panel * NR * kc);
+						} else {
+							const size_t b = (index - nrPacksB) / nPanelsA;
+							const size_t panel = (index - nrPacksB) % nPanelsA;
+							Gemm::packA<T, Tier>(kc, std::min(MR, M - panel * MR),
+												 blockA + b * batchStrideA + panel * MR * rowStrideA, rowStrideA,
+												 colStrideA, packedA + b * packedSizeA + panel * MR * kc);
+						}
+					});
+
+					CpuDispatch::parallelForEach(batch * nBlocksM * nPanelsB, parallel, [&](const size_t index) {
+						const size_t b = index / (nBlocksM * nPanelsB);
+						const size_t blockM = (index / nPanelsB) % nBlocksM;
+						const size_t panelB = index % nPanelsB;
+
+						alignas(64) T tile[MR * NR];
+
+						const T *sliceA = packedA + (batchA == 1 ? 0 : b) * packedSizeA;
+						const T *sliceB = panelsB + (batchB == 1 ? 0 : b) * packedSizeB + panelB * NR * kc;
+						T *sliceC = blockC + b * batchStrideC;
+
+						const size_t jr = panelB * NR;
+						const size_t nr = std::min(NR, nc - jr);
+						const size_t ic_end = std::min(M, (blockM + 1) * Block::MC);
+
+						for (size_t ir = blockM * Block::MC; ir < ic_end; ir += MR) {
+							const size_t mr = std::min(MR, M - ir);
+
+							Gemm::kernel<T, Tier>(kc, sliceA + (ir / MR) * MR * kc, sliceB, tile);
+							Gemm::store<T, Tier>(mr, nr, tile, alpha, beta_pc, sliceC + ir * rowStrideC + jr * colStrideC,
+												 rowStrideC, colStrideC);
+						}
+
+						/*	After the last slice of K the block of C is complete, and still in cache.	*/
+						if constexpr (!std::is_same_v<Epilogue, GemmIdentity>) {
+							if (pc + kc == K) {
+								const size_t ic = blockM * Block::MC;
+								Gemm::apply<T>(ic_end - ic, nr, sliceC + ic * rowStrideC + jr * colStrideC, rowStrideC,
+											   colStrideC, epilogue, ic, jc + jr);
+							}
+						}
+					});
+				}
+			}
+		}
+
+		/**
+		 * @brief Pack a mr x kc sliver of A into MR interleaved rows, zero padded up to MR.
+		 */
+		template <typename T, CpuTier Tier>
+		static void packA(const size_t kc, const size_t mr, const T *A, const std::ptrdiff_t rowStrideA,
+						  const std::ptrdiff_t colStrideA, T *packed) noexcept {
+			constexpr size_t MR = GemmBlocking<T, Tier>::MR;
+			for (size_t k = 0; k < kc; k++) {
+				const T *column = A + k * colStrideA;
+				for (size_t i = 0; i < mr; i++) {
+					packed[i] = column[i * rowStrideA];
+				}
+				for (size_t i = mr; i < MR; i++) {
+					packed[i] = 0;
+				}
+				packed += MR;
+			}
+		}
+
+		/**
+		 * @brief Pack a kc x nr sliver of B into NR interleaved columns, zero padded up to NR.
+		 */
+		template <typename T, CpuTier Tier>
+		static void packB(const size_t kc, const size_t nr, const T *B, const std::ptrdiff_t rowStrideB,
+						  const std::ptrdiff_t colStrideB, T *packed) noexcept {
+			constexpr size_t NR = GemmBlocking<T, Tier>::NR;
+			for (size_t k = 0; k < kc; k++) {
+				const T *row = B + k * rowStrideB;
+				for (size_t j = 0; j < nr; j++) {
+					packed[j] = row[j * colStrideB];
+				}
+				for (size_t j = nr; j < NR; j++) {
+					packed[j] = 0;
+				}
+				packed += NR;
+			}
+		}
+
+		/**
+		 * @brief Write back the mr x nr valid part of a register tile.
+		 */
+		template <typename T, CpuTier Tier>
+		static void store(const size_t mr, const size_t nr, const T *tile, const T alpha, const T beta, T *C,
+						  const std::ptrdiff_t rowStrideC, const std::ptrdiff_t colStrideC) noexcept {
+			constexpr size_t NR = GemmBlocking<T, Tier>::NR;
+			for (size_t i = 0; i < mr; i++) {
+				T *row = C + i * rowStrideC;
+				if (beta == static_cast<T>(0)) {
+					for (size_t j = 0; j < nr; j++) {
+						row[j * colStrideC] = static_cast<T>(alpha * tile[i * NR + j]);
+					}
+				} else {
+					for (size_t j = 0; j < nr; j++) {
+						T &out = row[j * colStrideC];
+						out = static_cast<T>(alpha * tile[i * NR + j] + beta * out);
+					}
+				}
+			}
+		}
+
+		/**
+		 * @brief Compute tile[MR x NR] = packedA[MR x kc] * packedB[kc x NR] with the micro kernel of the tier.
+		 */
+		template <typename T, CpuTier Tier> static void kernel(const size_t kc, const T *a, const T *b, T *tile) noexcept {
+#if defined(RITSU_CPU_X86)
+			if constexpr (Tier == CpuTier::AVX512) {
+				Gemm::kernelAVX512(kc, a, b, tile);
+				return;
+			}
+			if constexpr (Tier == CpuTier::AVX2) {
+				Gemm::kernelAVX2(kc, a, b, tile);
+				return;
+			}
+#endif
+#if defined(__ARM_NEON)
+			if constexpr (Tier == CpuTier::NEON && std::is_same_v<T, float>) {
+				Gemm::kernelNEON(kc, a, b, tile);
+				return;
+			}
+#endif
+			Gemm::kernelGeneric<T, Tier>(kc, a, b, tile);
+		}
+
+		template <typename T, CpuTier Tier>
+		static void kernelGeneric(const size_t kc, const T *a, const T *b, T *tile) noexcept {
+			constexpr size_t MR = GemmBlocking<T, Tier>::MR;
+			constexpr size_t NR = GemmBlocking<T, Tier>::NR;
+
+			for (size_t i = 0; i < MR * NR; i++) {
+				tile[i] = 0;
+			}
+
+			for (size_t p = 0; p < kc; p++) {
+				for (size_t i = 0; i < MR; i++) {
+					const T ai = a[i];
+#pragma omp simd
+					for (size_t j = 0; j < NR; j++) {
+						tile[i * NR + j] += ai * b[j];
+					}
+				}
+				a += MR;
+				b += NR;
+			}
+		}
+
+		/*	Architecture specific micro kernels, compiled for their instruction set regardless of
+		 *	the compile flags and only called when CpuDispatch selected the tier.	*/
+#if defined(RITSU_CPU_X86)
+		RITSU_TARGET_AVX512 static void kernelAVX512(const size_t kc, const float *a, const float *b,
+													 float *tile) noexcept {
+			constexpr size_t MR = GemmBlocking<float, CpuTier::AVX512>::MR;
+			__m512 c[MR][2];
+			for (size_t i = 0; i < MR; i++) {
+				c[i][0] = _mm512_setzero_ps();
+				c[i][1] = _mm512_setzero_ps();
+			}
+			for (size_t p = 0; p < kc; p++) {
+				const __m512 b0 = _mm512_loadu_ps(b);
+				const __m512 b1 = _mm512_loadu_ps(b + 16);
+				for (size_t i = 0; i < MR; i++) {
+					const __m512 ai = _mm512_set1_ps(a[i]);
+					c[i][0] = _mm512_fmadd_ps(ai, b0, c[i][0]);
+					c[i][1] = _mm512_fmadd_ps(ai, b1, c[i][1]);
+				}
+				a += MR;
+				b += 32;
+			}
+			for (size_t i = 0; i < MR; i++) {
+				_mm512_store_ps(tile + i * 32, c[i][0]);
+				_mm512_store_ps(tile + i * 32 + 16, c[i][1]);
+			}
+		}
+
+		RITSU_TARGET_AVX512 static void kernelAVX512(const size_t kc, const double *a, const double *b,
+													 double *tile) noexcept {
+			constexpr size_t MR = GemmBlocking<double, CpuTier::AVX512>::MR;
+			__m512d c[MR][2];
+			for (size_t i = 0; i < MR; i++) {
+				c[i][0] = _mm512_setzero_pd();
+				c[i][1] = _mm512_setzero_pd();
+			}
+			for (size_t p = 0; p < kc; p++) {
+				const __m512d b0 = _mm512_loadu_pd(b);
+				const __m512d b1 = _mm512_loadu_pd(b + 8);
+				for (size_t i = 0; i < MR; i++) {
+					const __m512d ai = _mm512_set1_pd(a[i]);
+					c[i][0] = _mm512_fmadd_pd(ai, b0, c[i][0]);
+					c[i][1] = _mm512_fmadd_pd(ai, b1, c[i][1]);
+				}
+				a += MR;
+				b += 16;
+			}
+			for (size_t i = 0; i < MR; i++) {
+				_mm512_store_pd(tile + i * 16, c[i][0]);
+				_mm512_store_pd(tile + i * 16 + 8, c[i][1]);
+			}
+		}
+
+		RITSU_TARGET_AVX2 static void kernelAVX2(const size_t kc, const float *a, const float *b, float *tile) noexcept {
+			constexpr size_t MR = GemmBlocking<float, CpuTier::AVX2>::MR;
+			__m256 c[MR][2];
+			for (size_t i = 0; i < MR; i++) {
+				c[i][0] = _mm256_setzero_ps();
+				c[i][1] = _mm256_setzero_ps();
+			}
+			for (size_t p = 0; p < kc; p++) {
+				const __m256 b0 = _mm256_loadu_ps(b);
+				const __m256 b1 = _mm256_loadu_ps(b + 8);
+				for (size_t i = 0; i < MR; i++) {
+					const __m256 ai = _mm256_broadcast_ss(a + i);
+					c[i][0] = _mm256_fmadd_ps(ai, b0, c[i][0]);
+					c[i][1] = _mm256_fmadd_ps(ai, b1, c[i][1]);
+				}
+				a += MR;
+				b += 16;
+			}
+			for (size_t i = 0; i < MR; i++) {
+				_mm256_store_ps(tile + i * 16, c[i][0]);
+				_mm256_store_ps(tile + i * 16 + 8, c[i][1]);
+			}
+		}
+
+		RITSU_TARGET_AVX2 static void kernelAVX2(const size_t kc, const double *a, const double *b,
+												 double *tile) noexcept {
+			constexpr size_t MR = GemmBlocking<double, CpuTier::AVX2>::MR;
+			__m256d c[MR][2];
+			for (size_t i = 0; i < MR; i++) {
+				c[i][0] = _mm256_setzero_pd();
+				c[i][1] = _mm256_setzero_pd();
+			}
+			for (size_t p = 0; p < kc; p++) {
+				const __m256d b0 = _mm256_loadu_pd(b);
+				const __m256d b1 = _mm256_loadu_pd(b + 4);
+				for (size_t i = 0; i < MR; i++) {
+					const __m256d ai = _mm256_broadcast_sd(a + i);
+					c[i][0] = _mm256_fmadd_pd(ai, b0, c[i][0]);
+					c[i][1] = _mm256_fmadd_pd(ai, b1, c[i][1]);
+				}
+				a += MR;
+				b += 8;
+			}
+			for (size_t i = 0; i < MR; i++) {
+				_mm256_store_pd(tile + i * 8, c[i][0]);
+				_mm256_store_pd(tile + i * 8 + 4, c[i][1]);
+			}
+		}
+#endif
+
+#if defined(__ARM_NEON)
+		static void kernelNEON(const size_t kc, const float *a, const float *b, float *tile) noexcept {
+			constexpr size_t MR = GemmBlocking<float, CpuTier::NEON>::MR;
+			float32x4_t c[MR][2];
+			for (size_t i = 0; i < MR; i++) {
+				c[i][0] = vdupq_n_f32(0);
+				c[i][1] = vdupq_n_f32(0);
+			}
+			for (size_t p = 0; p < kc; p++) {
+				const float32x4_t b0 = vld1q_f32(b);
+				const float32x4_t b1 = vld1q_f32(b + 4);
+				for (size_t i = 0; i < MR; i++) {
+					const float32x4_t ai = vdupq_n_f32(a[i]);
+#if defined(__ARM_FEATURE_FMA)
+					c[i][0] = vfmaq_f32(c[i][0], ai, b0);
+					c[i][1] = vfmaq_f32(c[i][1], ai, b1);
+#else
+					c[i][0] = vmlaq_f32(c[i][0], ai, b0);
+					c[i][1] = vmlaq_f32(c[i][1], ai, b1);
+#endif
+				}
+				a += MR;
+				b += 8;
+			}
+			for (size_t i = 0; i < MR; i++) {
+				vst1q_f32(tile + i * 8, c[i][0]);
+				vst1q_f32(tile + i * 8 + 4, c[i][1]);
+			}
+		}
+#endif
+
+		/**
+		 * @brief Per thread packing buffer, grown on demand and reused between calls. Scratch memory,
+		 *	placed by RuntimeConfig::getScratchPolicy.
+		 */
+		template <typename T> static T *workspace(const unsigned int slot, const size_t nrElements) {
+			struct Buffer {
+				void *data = nullptr;
+				size_t size = 0;
+				~Buffer() { std::free(this->data); }
+			};
+			static thread_local Buffer buffers[2];
+
+			Buffer &buffer = buffers[slot];
+			const size_t required = ((nrElements * sizeof(T) + 63) / 64) * 64;
+			if (buffer.size < required) {
+				std::free(buffer.data);
+				buffer.data = std::aligned_alloc(64, required);
+				if (buffer.data == nullptr) {
+					buffer.size = 0;
+					throw std::bad_alloc();
+				}
+				RuntimeConfig::bindMemory(buffer.data, required, RuntimeConfig::getScratchPolicy());
+				buffer.size = required;
+			}
+			return static_cast<T *>(buffer.data);
+		}
+	};
+
+} // namespace Ritsu
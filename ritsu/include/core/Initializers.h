@@ -16,7 +16,10 @@
 #pragma once
 #include "Random.h"
 #include "Tensor.h"
+#include "core/CpuDispatch.h"
+#include "core/RuntimeConfig.h"
 #include "core/Shape.h"
+#include <algorithm>
 
 namespace Ritsu {
 
@@ -39,6 +42,23 @@ namespace Ritsu {
 
 		Tensor<DType> operator()(const Shape<unsigned int> &shape) { return this->get(shape); }
 		Tensor<DType> &operator()(Tensor<DType> &tensor) { return this->set(tensor); }
+
+	  protected:
+		/**
+		 * @brief Place the memory of the tensor by the weight NUMA policy, and zero it in the blocks
+		 *	and on the threads of the kernels, thus with first touch each page ends up on the node of
+		 *	the thread that later computes on it.
+		 */
+		static TensorSpan<DType> place(Tensor<DType> &tensor) {
+			const TensorSpan<DType> data = tensor.span();
+			DType *values = data.data();
+
+			RuntimeConfig::bindMemory(values, data.size() * sizeof(DType), RuntimeConfig::getWeightPolicy());
+			CpuDispatch::parallelFor(data.size(), [values](const size_t begin, const size_t end) {
+				std::fill(values + begin, values + end, static_cast<DType>(0));
+			});
+			return data;
+		}
 	};
 
 	template <typename T> class RandomNormalInitializer : public Initializer<T> {
@@ -53,12 +73,14 @@ namespace Ritsu {
 			return set(tensor);
 		}
 
-#pragma omp declare simd
 		Tensor<T> &set(Tensor<T> &tensor) override {
 
-#pragma omp parallel for simd shared(tensor)
-			for (size_t index = 0; index < tensor.getNrElements(); index++) {
-				tensor.getValue(index) = this->random.rand();
+			const TensorSpan<T> data = Initializer<T>::place(tensor);
+			const SizeType nrElements = data.size();
+
+			/*	A single generator, the sequence must not depend on the threads.	*/
+			for (SizeType index = 0; index < nrElements; index++) {
+				data[index] = this->random.rand();
 			}
 			return tensor;
 		}
@@ -81,9 +103,12 @@ namespace Ritsu {
 
 		Tensor<T> &set(Tensor<T> &tensor) override {
 
-#pragma omp parallel for simd shared(tensor)
-			for (size_t index = 0; index < tensor.getNrElements(); index++) {
-				tensor.getValue(index) = this->random.rand();
+			const TensorSpan<T> data = Initializer<T>::place(tensor);
+			const SizeType nrElements = data.size();
+
+			/*	A single generator, the sequence must not depend on the threads.	*/
+			for (SizeType index = 0; index < nrElements; index++) {
+				data[index] = this->random.rand();
 			}
 
 			return tensor;
@@ -105,11 +130,7 @@ namespace Ritsu {
 		}
 
 		Tensor<T> &set(Tensor<T> &tensor) override {
-#pragma omp parallel for simd shared(tensor)
-			for (decltype(tensor.getNrElements()) index = 0; index < tensor.getNrElements(); index++) {
-				tensor.getValue(index) = 0;
-			}
-
+			Initializer<T>::place(tensor);
 			return tensor;
 		}
 	};
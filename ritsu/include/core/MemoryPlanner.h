@@ -0,0 +1,132 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Valdemar Lindberg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ */
+#pragma once
+#include "../Math.h"
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace Ritsu {
+
+	/**
+	 * @brief Assign offsets in a single arena to buffers with known lifetimes, such that buffers
+	 *	never alive at the same time may share memory.
+	 *
+	 *	Lifetimes are inclusive step intervals [first, last]. Offsets are assigned greedily, largest
+	 *	buffer first, at the lowest aligned offset not overlapping any placed buffer that is alive at
+	 *	the same time.
+	 */
+	class MemoryPlanner {
+	  public:
+		MemoryPlanner(const size_t alignment = 64) : alignment(alignment) {}
+
+		/**
+		 * @brief Add a buffer of size bytes, alive from step first to step last.
+		 * @return index of the buffer.
+		 */
+		size_t addBuffer(const size_t size, const size_t first, const size_t last) {
+			this->buffers.push_back({size, first, Math::max<size_t>(first, last), 0});
+			return this->buffers.size() - 1;
+		}
+
+		/**
+		 * @brief Extend the lifetime of the buffer, used when a later value is computed in-place.
+		 */
+		void extend(const size_t index, const size_t last) {
+			this->buffers[index].last = Math::max<size_t>(this->buffers[index].last, last);
+		}
+
+		/**
+		 * @brief Compute the offset of all buffers.
+		 * @return size in bytes of the arena.
+		 */
+		size_t plan() {
+
+			std::vector<size_t> order(this->buffers.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(),
+							 [&](size_t a, size_t b) { return this->buffers[a].size > this->buffers[b].size; });
+
+			std::vector<const Buffer *> placed;
+			std::vector<const Buffer *> overlapping;
+			this->arenaSize = 0;
+
+			for (size_t i = 0; i < order.size(); i++) {
+				Buffer &buffer = this->buffers[order[i]];
+
+				/*	Placed buffers alive at the same time, ordered by offset.	*/
+				overlapping.clear();
+				for (const Buffer *other : placed) {
+					if (buffer.first <= other->last && other->first <= buffer.last) {
+						overlapping.push_back(other);
+					}
+				}
+				std::sort(overlapping.begin(), overlapping.end(),
+						  [](const Buffer *a, const Buffer *b) { return a->offset < b->offset; });
+
+				/*	Lowest gap large enough.	*/
+				size_t offset = 0;
+				for (const Buffer *other : overlapping) {
+					if (offset + buffer.size <= other->offset) {
+						break;
+					}
+					offset = Math::max<size_t>(offset, Math::align<size_t>(other->offset + other->size, this->alignment));
+				}
+
+				buffer.offset = offset;
+				placed.push_back(&buffer);
+				this->arenaSize = Math::max<size_t>(this->arenaSize, offset + buffer.size);
+			}
+
+			this->arenaSize = Math::align<size_t>(this->arenaSize, this->alignment);
+			return this->arenaSize;
+		}
+
+		size_t getOffset(const size_t index) const noexcept { return this->buffers[index].offset; }
+		size_t getSize(const size_t index) const noexcept { return this->buffers[index].size; }
+		size_t getLast(const size_t index) const noexcept { return this->buffers[index].last; }
+		size_t getNrBuffers() const noexcept { return this->buffers.size(); }
+
+		/**
+		 * @brief Size of the arena computed by plan, the peak memory usage.
+		 */
+		size_t getArenaSize() const noexcept { return this->arenaSize; }
+
+		/**
+		 * @brief Size without any reuse, every buffer allocated separately.
+		 */
+		size_t getTotalSize() const noexcept {
+			size_t total = 0;
+			for (const Buffer &buffer : this->buffers) {
+				total += Math::align<size_t>(buffer.size, this->alignment);
+			}
+			return total;
+		}
+
+	  private:
+		struct Buffer {
+			size_t size;   /*	Size in bytes.	*/
+			size_t first;  /*	First step the buffer is alive.	*/
+			size_t last;   /*	Last step the buffer is alive.	*/
+			size_t offset; /*	Offset in bytes in the arena.	*/
+		};
+
+		std::vector<Buffer> buffers;
+		size_t alignment;
+		size_t arenaSize = 0;
+	};
+} // namespace Ritsu
@@ -0,0 +1,343 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Valdemar Lindberg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ */
+#pragma once
+#include "../RitsuDef.h"
+#include "CpuDispatch.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Ritsu {
+
+	/**
+	 * @brief Placement of memory on the NUMA nodes.
+	 */
+	enum class NumaPolicy : unsigned int {
+		Default = 0,	/*	Policy of the process, first touch unless changed, e.g. by numactl.	*/
+		Local = 1,		/*	Node of the thread that first touches each page.	*/
+		Interleave = 2, /*	Pages spread round robin over all the nodes.	*/
+	};
+
+	/**
+	 * @brief Number of threads, core pinning and NUMA placement of the library.
+	 *
+	 *	Weights are the tensors filled by the initializers, scratch the thread arenas and the GEMM
+	 *	packing buffers. The initial configuration is read from the environment, RITSU_NUM_THREADS,
+	 *	RITSU_PIN_THREADS (0 or 1), RITSU_NUMA_WEIGHTS and RITSU_NUMA_SCRATCH (default, local,
+	 *	interleave). The NUMA policies apply to memory allocated after they are set, the number of
+	 *	threads and the pinning take effect with apply.
+	 *
+	 *	RuntimeConfig config = RuntimeConfig::fromEnvironment();
+	 *	config.weightPolicy = NumaPolicy::Interleave;
+	 *	RuntimeConfig::apply(config);
+	 */
+	class RuntimeConfig {
+	  public:
+		unsigned int nrThreads = 0; /*	Number of threads of the kernels, 0 for all available processors.	*/
+		bool pinThreads = false;	/*	Pin each thread to one of the available processors.	*/
+		NumaPolicy weightPolicy = NumaPolicy::Default;
+		NumaPolicy scratchPolicy = NumaPolicy::Default;
+
+		/**
+		 * @brief Configuration of the environment variables, the defaults for those not set.
+		 */
+		static RuntimeConfig fromEnvironment() {
+			RuntimeConfig config;
+
+			const char *threads = std::getenv("RITSU_NUM_THREADS");
+			if (threads != nullptr && std::atoi(threads) > 0) {
+				config.nrThreads = static_cast<unsigned int>(std::atoi(threads));
+			}
+			const char *pin = std::getenv("RITSU_PIN_THREADS");
+			config.pinThreads = pin != nullptr && std::atoi(pin) != 0;
+
+			config.weightPolicy = RuntimeConfig::getEnvironmentPolicy("RITSU_NUMA_WEIGHTS");
+			config.scratchPolicy = RuntimeConfig::getEnvironmentPolicy("RITSU_NUMA_SCRATCH");
+			return config;
+		}
+
+		/**
+		 * @brief Set the number of threads of the kernels, pin or unpin them together with the calling
+		 *	thread, and set the NUMA policies. When the kernels run on a ThreadPool, it is replaced by
+		 *	a new pool of the configured threads, see CpuDispatch::setThreadPool.
+		 */
+		static void apply(const RuntimeConfig &config) {
+			std::lock_guard<std::mutex> guard(RuntimeConfig::lock());
+
+			RuntimeConfig::weights().store(config.weightPolicy, std::memory_order_relaxed);
+			RuntimeConfig::scratch().store(config.scratchPolicy, std::memory_order_relaxed);
+
+			const std::vector<unsigned int> &cpus = RuntimeConfig::getAvailableCpus();
+			const unsigned int nrThreads =
+				config.nrThreads > 0 ? config.nrThreads : static_cast<unsigned int>(std::max<size_t>(cpus.size(), 1));
+			const bool pin = config.pinThreads;
+
+			/*	Thread index to processor, compact in the order of the available processors.	*/
+			const auto placeThread = [pin](const unsigned int index) {
+				const std::vector<unsigned int> &available = RuntimeConfig::getAvailableCpus();
+				if (pin && !available.empty()) {
+					RuntimeConfig::pinCurrentThread(available[index % available.size()]);
+				} else {
+					RuntimeConfig::unpinCurrentThread();
+				}
+			};
+
+			if (CpuDispatch::getThreadPool() != nullptr) {
+				CpuDispatch::setThreadPool(std::make_shared<ThreadPool>(nrThreads, placeThread));
+			} else {
+#ifdef _OPENMP
+				omp_set_num_threads(static_cast<int>(nrThreads));
+#pragma omp parallel
+				{ placeThread(static_cast<unsigned int>(omp_get_thread_num())); }
+#endif
+				CpuDispatch::resetParallelThreshold();
+			}
+			placeThread(0);
+
+			RuntimeConfig::current().reset(new RuntimeConfig(config));
+		}
+
+		/**
+		 * @brief Configuration last applied, the one of the environment if none.
+		 */
+		static RuntimeConfig getCurrent() {
+			std::lock_guard<std::mutex> guard(RuntimeConfig::lock());
+			const std::unique_ptr<RuntimeConfig> &config = RuntimeConfig::current();
+			if (config) {
+				return *config;
+			}
+			return RuntimeConfig::fromEnvironment();
+		}
+
+		static NumaPolicy getWeightPolicy() noexcept { return RuntimeConfig::weights().load(std::memory_order_relaxed); }
+		static NumaPolicy getScratchPolicy() noexcept { return RuntimeConfig::scratch().load(std::memory_order_relaxed); }
+
+		static const char *getNumaPolicyName(const NumaPolicy policy) noexcept {
+			switch (policy) {
+			case NumaPolicy::Local:
+				return "local";
+			case NumaPolicy::Interleave:
+				return "interleave";
+			case NumaPolicy::Default:
+			default:
+				return "default";
+			}
+		}
+
+		/**
+		 * @brief Policy of a name as returned by getNumaPolicyName.
+		 */
+		static NumaPolicy parseNumaPolicy(const char *name) {
+			const NumaPolicy policies[] = {NumaPolicy::Default, NumaPolicy::Local, NumaPolicy::Interleave};
+			for (const NumaPolicy policy : policies) {
+				if (std::strcmp(name, RuntimeConfig::getNumaPolicyName(policy)) == 0) {
+					return policy;
+				}
+			}
+			throw InvalidArgumentException("Unknown NUMA policy.");
+		}
+
+		/**
+		 * @brief Processors the process may run on, e.g. restricted by taskset or numactl, read before
+		 *	any thread is pinned.
+		 */
+		static const std::vector<unsigned int> &getAvailableCpus() noexcept {
+			static const std::vector<unsigned int> cpus = RuntimeConfig::detectCpus();
+			return cpus;
+		}
+
+		/**
+		 * @brief Number of online NUMA nodes, 1 where not supported.
+		 */
+		static unsigned int getNrNumaNodes() noexcept {
+			static const unsigned int nrNodes = RuntimeConfig::detectNrNodes();
+			return nrNodes;
+		}
+
+		static bool pinCurrentThread(const unsigned int cpu) noexcept {
+#if defined(__linux__)
+			if (cpu >= CPU_SETSIZE) {
+				return false;
+			}
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(cpu, &set);
+			return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+			(void)cpu;
+			return false;
+#endif
+		}
+
+		/**
+		 * @brief Allow the calling thread on all the available processors again.
+		 */
+		static bool unpinCurrentThread() noexcept {
+#if defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			for (const unsigned int cpu : RuntimeConfig::getAvailableCpus()) {
+				CPU_SET(cpu, &set);
+			}
+			return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+			return false;
+#endif
+		}
+
+		/**
+		 * @brief Apply the policy to the whole pages of the memory. Interleave moves the pages already
+		 *	touched, local places the pages touched from then on. Memory smaller than MinBindSize is left
+		 *	as is, each binding splits the mapping of the process.
+		 *
+		 * @return true if the policy was applied.
+		 */
+		static bool bindMemory(void *memory, const size_t size, const NumaPolicy policy) noexcept {
+#if defined(__linux__) && defined(SYS_mbind)
+			if (policy == NumaPolicy::Default || memory == nullptr || size < MinBindSize) {
+				return false;
+			}
+
+			const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+			const uintptr_t begin = (reinterpret_cast<uintptr_t>(memory) + pageSize - 1) & ~(pageSize - 1);
+			const uintptr_t end = (reinterpret_cast<uintptr_t>(memory) + size) & ~(pageSize - 1);
+			if (end <= begin) {
+				return false;
+			}
+
+			/*	Values of linux/mempolicy.h, preferred without nodes is the local node.	*/
+			constexpr int PolicyPreferred = 1;
+			constexpr int PolicyInterleave = 3;
+			constexpr unsigned int MoveFlag = 1u << 1;
+
+			unsigned long nodes[MaxNumaNodes / (8 * sizeof(unsigned long))] = {};
+			int mode = PolicyPreferred;
+			unsigned long maxNode = 0;
+			if (policy == NumaPolicy::Interleave) {
+				mode = PolicyInterleave;
+				maxNode = MaxNumaNodes + 1;
+				for (unsigned int node = 0; node < RuntimeConfig::getNrNumaNodes() && node < MaxNumaNodes; node++) {
+					nodes[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+				}
+			}
+
+			const unsigned int flags = policy == NumaPolicy::Interleave ? MoveFlag : 0;
+			return syscall(SYS_mbind, begin, end - begin, mode, maxNode > 0 ? nodes : nullptr, maxNode, flags) == 0;
+#else
+			(void)memory;
+			(void)size;
+			(void)policy;
+			return false;
+#endif
+		}
+
+		/*	Smallest memory bound to a NUMA policy.	*/
+		static constexpr size_t MinBindSize = static_cast<size_t>(256) * 1024;
+		static constexpr unsigned int MaxNumaNodes = 1024;
+
+	  protected:
+		static std::mutex &lock() noexcept {
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		static std::unique_ptr<RuntimeConfig> &current() noexcept {
+			static std::unique_ptr<RuntimeConfig> config;
+			return config;
+		}
+
+		static std::atomic<NumaPolicy> &weights() noexcept {
+			static std::atomic<NumaPolicy> policy(RuntimeConfig::getEnvironmentPolicy("RITSU_NUMA_WEIGHTS"));
+			return policy;
+		}
+
+		static std::atomic<NumaPolicy> &scratch() noexcept {
+			static std::atomic<NumaPolicy> policy(RuntimeConfig::getEnvironmentPolicy("RITSU_NUMA_SCRATCH"));
+			return policy;
+		}
+
+		/*	Policy of the environment variable if set and valid, the default otherwise.	*/
+		static NumaPolicy getEnvironmentPolicy(const char *variable) noexcept {
+			const char *environment = std::getenv(variable);
+			if (environment != nullptr) {
+				try {
+					return RuntimeConfig::parseNumaPolicy(environment);
+				} catch (const InvalidArgumentException &) {
+				}
+			}
+			return NumaPolicy::Default;
+		}
+
+		static std::vector<unsigned int> detectCpus() {
+			std::vector<unsigned int> cpus;
+#if defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+				for (unsigned int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+					if (CPU_ISSET(cpu, &set)) {
+						cpus.push_back(cpu);
+					}
+				}
+			}
+#endif
+			if (cpus.empty()) {
+				for (unsigned int cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u); cpu++) {
+					cpus.push_back(cpu);
+				}
+			}
+			return cpus;
+		}
+
+		/*	Highest node of the online list, e.g. "0-1", plus one.	*/
+		static unsigned int detectNrNodes() noexcept {
+			unsigned int nrNodes = 1;
+#if defined(__linux__)
+			FILE *file = std::fopen("/sys/devices/system/node/online", "r");
+			if (file != nullptr) {
+				char list[256] = {};
+				if (std::fgets(list, sizeof(list), file) != nullptr) {
+					const char *last = list;
+					for (const char *c = list; *c != '\0'; c++) {
+						if (*c == ',' || *c == '-') {
+							last = c + 1;
+						}
+					}
+					nrNodes = static_cast<unsigned int>(std::strtoul(last, nullptr, 10)) + 1;
+				}
+				std::fclose(file);
+			}
+#endif
+			return std::min(nrNodes, MaxNumaNodes);
+		}
+	};
+
+} // namespace Ritsu
@@ -47,6 +47,7 @@ namespace Ritsu {
 		static_assert(std::is_integral<T>::value, "Type must be a integral type.");
 
 		using IndexType = T;
+		using SizeType = Ritsu::SizeType;
 		static constexpr size_t IndexTypeSize = sizeof(IndexType);
 
 	  public:
@@ -286,7 +287,7 @@ namespace Ritsu {
 
 			/*	*/
 			if (this->getNrDimensions() == 1) {
-				*this = {1, this->getNrElements()};
+				*this = {1, static_cast<IndexType>(this->getNrElements())};
 
 			} else if (this->getNrDimensions() == 2) {
 				std::swap(dims[0], dims[1]);
@@ -304,7 +305,7 @@ namespace Ritsu {
 			return tmp;
 		}
 
-		inline IndexType getNrElements() const noexcept { return Shape::computeNrElements<IndexType>(this->dims); }
+		inline SizeType getNrElements() const noexcept { return Shape::computeNrElements<IndexType>(this->dims); }
 
 		inline IndexType getAxisDimensions(const int32_t index) const noexcept {
 			return this->dims[Math::mod<int32_t>(index, this->dims.size())];
@@ -442,15 +443,15 @@ namespace Ritsu {
 		 * Memory is row. thus the result is itself.
 		 */
 #pragma omp declare simd
-		static inline IndexType getIndexMemoryOffset(const Shape<IndexType> &shape, const IndexType index,
-													 const unsigned int orderAxis = 0) noexcept {
+		static inline SizeType getIndexMemoryOffset(const Shape<IndexType> &shape, const SizeType index,
+													const unsigned int orderAxis = 0) noexcept {
 			if (orderAxis == 0) {
 				return index;
 			}
 
 			/*	*/
-			const IndexType axisDim = shape.getAxisDimensions(orderAxis);
-			const IndexType depthSlice = computeDepth(shape, orderAxis);
+			const SizeType axisDim = shape.getAxisDimensions(orderAxis);
+			const SizeType depthSlice = computeDepth(shape, orderAxis);
 			/*	*/
 			return (index % axisDim) * depthSlice + (index / axisDim);
 		}
@@ -480,53 +481,30 @@ namespace Ritsu {
 			return true;
 		}
 
-#pragma omp declare simd uniform(dim, shape)
+		/**
+		 * @brief Memory offset of a multi index, the depth of each axis is accumulated in SizeType
+		 *	so the offset does not overflow when the number of elements does not fit in IndexType.
+		 */
 		template <typename U = IndexType>
-		static size_t computeIndex(const std::vector<U> &dim, const Shape<IndexType> &shape) noexcept {
-			size_t totalSize = 0;
-			const IndexType nrDims = shape.getNrDimensions();
-
-			// if (i < dim.size()) {
-			const unsigned long depth = 1;
-			const U value = *(dim.begin() + 0);
-			totalSize += depth * value;
-			//}
-
-			/*	*/
-			IndexType index;
-#pragma omp simd
-			for (index = 1; index < nrDims; index++) {
-				unsigned long depth = 1;
-
-				if (index > 0) {
-					depth = Math::product(&shape.dims.data()[0], index);
-				}
-
-				if (index < dim.size()) {
-					const U value = *(dim.begin() + index);
-					totalSize += depth * value;
-				}
-			}
-			return totalSize;
+		static SizeType computeIndex(const std::vector<U> &dim, const Shape<IndexType> &shape) noexcept {
+			return Shape::computeIndex<U>(dim.data(), dim.size(), shape);
 		}
 
-#pragma omp declare simd
 		template <typename U = IndexType>
-		static size_t computeIndex(const std::initializer_list<U> &__restrict dim,
-								   const Shape<IndexType> &__restrict shape) noexcept {
-			size_t totalSize = 0;
-			const IndexType nrDims = shape.getNrDimensions();
-
-			for (IndexType i = 0; i < nrDims; i++) {
-				long depth = 1;
-				if (i > 0) {
-					depth = Math::product(&shape.dims.data()[0], i);
-				}
+		static SizeType computeIndex(const std::initializer_list<U> &__restrict dim,
+									 const Shape<IndexType> &__restrict shape) noexcept {
+			return Shape::computeIndex<U>(dim.begin(), dim.size(), shape);
+		}
 
-				if (i < dim.size()) {
-					const U value = *(dim.begin() + i);
-					totalSize += depth * value;
-				}
+		template <typename U = IndexType>
+		static SizeType computeIndex(const U *dim, const size_t nrDim, const Shape<IndexType> &shape) noexcept {
+			const size_t nrDims = std::min<size_t>(nrDim, shape.getNrDimensions());
+
+			SizeType totalSize = 0;
+			SizeType depth = 1;
+			for (size_t i = 0; i < nrDims; i++) {
+				totalSize += depth * static_cast<SizeType>(dim[i]);
+				depth *= shape.dims[i];
 			}
 			return totalSize;
 		}
@@ -535,25 +513,34 @@ namespace Ritsu {
 		 * @brief
 		 */
 #pragma omp declare simd
-		static inline IndexType computeDepth(const Shape<IndexType> &shape, const int depth) noexcept {
-			if (depth > 0) {
-				return Math::product<IndexType>(shape.dims.data(), depth);
+		static inline SizeType computeDepth(const Shape<IndexType> &shape, const int depth) noexcept {
+			SizeType product = 1;
+			for (int i = 0; i < depth; i++) {
+				product *= shape.dims[i];
 			}
-			return 1;
+			return product;
 		}
 
 		/**
 		 * @brief
 		 */
 #pragma omp declare simd
-		template <typename U = IndexType> static inline U computeNrElements(const std::vector<U> &dims) noexcept {
+		template <typename U = IndexType>
+		static inline SizeType computeNrElements(const std::vector<U> &dims) noexcept {
 			static_assert(std::is_integral<U>::value, "Type must be a integral type.");
-			return dims.empty() ? 0 : Math::product(dims);
+			if (dims.empty()) {
+				return 0;
+			}
+			SizeType product = 1;
+			for (const U dim : dims) {
+				product *= static_cast<SizeType>(dim);
+			}
+			return product;
 		}
 
 	  private:
 		std::vector<IndexType> dims;
-		IndexType count; // TODO: add, to improve get number of elements. cache
+		SizeType count; // TODO: add, to improve get number of elements. cache
 		std::vector<IndexType> cacheDim;
 	};
 } // namespace Ritsu
\ No newline at end of file
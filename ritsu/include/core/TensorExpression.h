@@ -0,0 +1,221 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Valdemar Lindberg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ */
+#pragma once
+#include "VectorMath.h"
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+namespace Ritsu {
+
+	/**
+	 * @brief Base of all lazy elementwise tensor expressions.
+	 *
+	 *	An expression only records the operands and operators, nothing is computed until it is
+	 *	assigned to a Tensor, at which point the whole expression is evaluated in a single fused
+	 *	loop without intermediate tensors. Operands are referenced, not copied, thus an expression
+	 *	must not outlive the tensors it was built from.
+	 */
+	template <typename E> class TensorExpression {
+	  public:
+		inline const E &derived() const noexcept { return static_cast<const E &>(*this); }
+
+		/*	Elementwise math functions.	*/
+		inline auto sqrt() const noexcept;
+		inline auto exp() const noexcept;
+		inline auto log() const noexcept;
+		inline auto abs() const noexcept;
+	};
+
+	template <typename E> using is_tensor_expression = std::is_base_of<TensorExpression<E>, E>;
+
+	template <typename E>
+	inline constexpr bool is_tensor_expression_v = std::is_base_of_v<TensorExpression<std::decay_t<E>>, std::decay_t<E>>;
+
+	/**
+	 * @brief Leaf expression, reads the elements of a tensor.
+	 */
+	template <typename TensorType> class TensorOperand : public TensorExpression<TensorOperand<TensorType>> {
+	  public:
+		using DType = typename TensorType::DType;
+		using ShapeType = std::decay_t<decltype(std::declval<const TensorType &>().getShape())>;
+
+		TensorOperand(const TensorType &tensor) noexcept
+			: data(tensor.getRawData()), shape(&tensor.getShape()), nrElements(tensor.getNrElements()) {}
+
+		inline DType eval(const size_t index) const noexcept { return this->data[index]; }
+		inline const ShapeType &getShape() const noexcept { return *this->shape; }
+		inline size_t getNrElements() const noexcept { return this->nrElements; }
+
+	  private:
+		const DType *data;
+		const ShapeType *shape;
+		size_t nrElements;
+	};
+
+	/**
+	 * @brief Binary elementwise expression between two expressions.
+	 */
+	template <typename Op, typename L, typename R>
+	class TensorBinaryExpression : public TensorExpression<TensorBinaryExpression<Op, L, R>> {
+	  public:
+		using DType = std::common_type_t<typename L::DType, typename R::DType>;
+
+		TensorBinaryExpression(const L &left, const R &right) noexcept : left(left), right(right) {
+			assert(left.getNrElements() == right.getNrElements());
+		}
+
+		inline DType eval(const size_t index) const noexcept {
+			return Op::apply(static_cast<DType>(this->left.eval(index)), static_cast<DType>(this->right.eval(index)));
+		}
+		inline const auto &getShape() const noexcept { return this->left.getShape(); }
+		inline size_t getNrElements() const noexcept { return this->left.getNrElements(); }
+
+	  private:
+		L left;
+		R right;
+	};
+
+	/**
+	 * @brief Binary elementwise expression between an expression and a scalar, either on the
+	 *	left (ScalarLeft) or on the right hand side.
+	 */
+	template <typename Op, typename E, bool ScalarLeft>
+	class TensorScalarExpression : public TensorExpression<TensorScalarExpression<Op, E, ScalarLeft>> {
+	  public:
+		using DType = typename E::DType;
+
+		TensorScalarExpression(const E &expression, const DType value) noexcept
+			: expression(expression), value(value) {}
+
+		inline DType eval(const size_t index) const noexcept {
+			if constexpr (ScalarLeft) {
+				return Op::apply(this->value, this->expression.eval(index));
+			} else {
+				return Op::apply(this->expression.eval(index), this->value);
+			}
+		}
+		inline const auto &getShape() const noexcept { return this->expression.getShape(); }
+		inline size_t getNrElements() const noexcept { return this->expression.getNrElements(); }
+
+	  private:
+		E expression;
+		DType value;
+	};
+
+	/**
+	 * @brief Unary elementwise expression.
+	 */
+	template <typename Op, typename E>
+	class TensorUnaryExpression : public TensorExpression<TensorUnaryExpression<Op, E>> {
+	  public:
+		using DType = typename E::DType;
+
+		TensorUnaryExpression(const E &expression) noexcept : expression(expression) {}
+
+		inline DType eval(const size_t index) const noexcept { return Op::apply(this->expression.eval(index)); }
+		inline const auto &getShape() const noexcept { return this->expression.getShape(); }
+		inline size_t getNrElements() const noexcept { return this->expression.getNrElements(); }
+
+	  private:
+		E expression;
+	};
+
+	namespace ExpressionOp {
+		struct Add {
+			template <typename T> static inline T apply(const T a, const T b) noexcept { return a + b; }
+		};
+		struct Subtract {
+			template <typename T> static inline T apply(const T a, const T b) noexcept { return a - b; }
+		};
+		struct Multiply {
+			template <typename T> static inline T apply(const T a, const T b) noexcept { return a * b; }
+		};
+		struct Divide {
+			template <typename T> static inline T apply(const T a, const T b) noexcept { return a / b; }
+		};
+		struct Negate {
+			template <typename T> static inline T apply(const T a) noexcept { return -a; }
+		};
+		struct Sqrt {
+			template <typename T> static inline T apply(const T a) noexcept { return static_cast<T>(std::sqrt(a)); }
+		};
+		struct Exp {
+			template <typename T> static inline T apply(const T a) noexcept { return VectorMath::exp<T>(a); }
+		};
+		struct Log {
+			template <typename T> static inline T apply(const T a) noexcept { return VectorMath::log<T>(a); }
+		};
+		struct Abs {
+			template <typename T> static inline T apply(const T a) noexcept { return static_cast<T>(std::abs(a)); }
+		};
+	} // namespace ExpressionOp
+
+	template <typename E> inline auto TensorExpression<E>::sqrt() const noexcept {
+		return TensorUnaryExpression<ExpressionOp::Sqrt, E>(this->derived());
+	}
+	template <typename E> inline auto TensorExpression<E>::exp() const noexcept {
+		return TensorUnaryExpression<ExpressionOp::Exp, E>(this->derived());
+	}
+	template <typename E> inline auto TensorExpression<E>::log() const noexcept {
+		return TensorUnaryExpression<ExpressionOp::Log, E>(this->derived());
+	}
+	template <typename E> inline auto TensorExpression<E>::abs() const noexcept {
+		return TensorUnaryExpression<ExpressionOp::Abs, E>(this->derived());
+	}
+
+	/**
+	 * @brief Begin a lazy expression from a tensor, such as lazy(a) * value + b.
+	 */
+	template <typename TensorType> inline TensorOperand<TensorType> lazy(const TensorType &tensor) noexcept {
+		return TensorOperand<TensorType>(tensor);
+	}
+
+#define RITSU_TENSOR_EXPRESSION_OPERATOR(symbol, op)                                                                   \
+	template <typename L, typename R>                                                                                  \
+	inline auto operator symbol(const TensorExpression<L> &left, const TensorExpression<R> &right) noexcept {          \
+		return TensorBinaryExpression<ExpressionOp::op, L, R>(left.derived(), right.derived());                        \
+	}                                                                                                                  \
+	template <typename L, typename TensorType, typename = decltype(std::declval<const TensorType &>().getRawData()),  \
+			  typename = std::enable_if_t<!is_tensor_expression_v<TensorType>>>                                       \
+	inline auto operator symbol(const TensorExpression<L> &left, const TensorType &right) noexcept {                   \
+		return TensorBinaryExpression<ExpressionOp::op, L, TensorOperand<TensorType>>(                                 \
+			left.derived(), TensorOperand<TensorType>(right));                                                         \
+	}                                                                                                                  \
+	template <typename E, typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>>                           \
+	inline auto operator symbol(const TensorExpression<E> &expression, const U value) noexcept {                       \
+		return TensorScalarExpression<ExpressionOp::op, E, false>(expression.derived(),                                \
+																   static_cast<typename E::DType>(value));             \
+	}                                                                                                                  \
+	template <typename E, typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>>                           \
+	inline auto operator symbol(const U value, const TensorExpression<E> &expression) noexcept {                       \
+		return TensorScalarExpression<ExpressionOp::op, E, true>(expression.derived(),                                 \
+																  static_cast<typename E::DType>(value));              \
+	}
+
+	RITSU_TENSOR_EXPRESSION_OPERATOR(+, Add)
+	RITSU_TENSOR_EXPRESSION_OPERATOR(-, Subtract)
+	RITSU_TENSOR_EXPRESSION_OPERATOR(*, Multiply)
+	RITSU_TENSOR_EXPRESSION_OPERATOR(/, Divide)
+
+#undef RITSU_TENSOR_EXPRESSION_OPERATOR
+
+	template <typename E> inline auto operator-(const TensorExpression<E> &expression) noexcept {
+		return TensorUnaryExpression<ExpressionOp::Negate, E>(expression.derived());
+	}
+
+} // namespace Ritsu
@@ -0,0 +1,81 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Valdemar Lindberg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ */
+#pragma once
+#include "../RitsuDef.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace Ritsu {
+
+	/**
+	 * @brief Typed contiguous range of tensor elements.
+	 *
+	 *	Unlike Tensor::getValue, indexing a span is a plain pointer offset with the element size
+	 *	known at compile time, no shape lookup and no copy-on-write check, thus loops over a span
+	 *	vectorize. Alignment is the guaranteed alignment in bytes of the first element, which is
+	 *	passed on to the compiler by data(). A span does not keep the memory alive.
+	 */
+	template <typename T, size_t Alignment = alignof(T)> class TensorSpan {
+		static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two.");
+		static_assert(Alignment >= alignof(T), "Alignment must be at least the alignment of the type.");
+
+	  public:
+		using DType = T;
+		static constexpr size_t alignment = Alignment;
+
+		constexpr TensorSpan() noexcept = default;
+		TensorSpan(T *data, const SizeType size) noexcept : pointer(data), nrElements(size) {
+			assert(TensorSpan::isAligned(data));
+		}
+
+		/**
+		 * @brief Pointer to the first element, assumed aligned to Alignment.
+		 */
+		inline T *data() const noexcept { return static_cast<T *>(__builtin_assume_aligned(this->pointer, Alignment)); }
+
+		inline SizeType size() const noexcept { return this->nrElements; }
+		inline bool empty() const noexcept { return this->nrElements == 0; }
+
+		inline T &operator[](const SizeType index) const noexcept {
+			assert(index < this->nrElements);
+			return this->data()[index];
+		}
+
+		inline T *begin() const noexcept { return this->data(); }
+		inline T *end() const noexcept { return this->data() + this->nrElements; }
+
+		/**
+		 * @brief Elements [offset, offset + count), the alignment of the result is only that of T.
+		 */
+		TensorSpan<T> subspan(const SizeType offset, const SizeType count) const noexcept {
+			assert(offset + count <= this->nrElements);
+			return TensorSpan<T>(this->pointer + offset, count);
+		}
+
+		/**
+		 * @brief True if the pointer satisfies the alignment.
+		 */
+		static inline bool isAligned(const void *data) noexcept {
+			return (reinterpret_cast<uintptr_t>(data) & (Alignment - 1)) == 0;
+		}
+
+	  private:
+		T *pointer = nullptr;
+		SizeType nrElements = 0;
+	};
+
+} // namespace Ritsu
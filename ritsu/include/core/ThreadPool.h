@@ -0,0 +1,350 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Valdemar Lindberg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Ritsu {
+
+	/**
+	 * @brief Work stealing thread pool, the threading backend of the kernels when the library is built
+	 *	without OpenMP, see CpuDispatch::setThreadPool.
+	 *
+	 *	Each worker owns a deque of tasks. It runs its own tasks newest first and steals the oldest task
+	 *	of another deque when it runs out. A thread waiting on a task group runs the pending tasks of
+	 *	that group meanwhile, thus parallel loops nested in tasks do not deadlock, and the waiting thread
+	 *	never picks up unrelated work that could reuse its thread local buffers. The thread calling
+	 *	parallelFor takes part in the loop, a pool of N threads has N - 1 workers.
+	 */
+	class ThreadPool {
+	  public:
+		using Task = std::function<void()>;
+
+		/**
+		 * @brief Called by each worker when it starts, with the index of the worker from 1, the calling
+		 *	thread of a parallel loop counts as 0. E.g. to pin the worker to a core.
+		 */
+		using ThreadStart = std::function<void(const unsigned int index)>;
+
+		explicit ThreadPool(const unsigned int nrThreads = ThreadPool::getDefaultNrThreads(),
+							ThreadStart onThreadStart = nullptr) {
+			const unsigned int nrWorkers = nrThreads > 1 ? nrThreads - 1 : 0;
+
+			/*	One deque per worker, and one for the threads that are not workers of the pool.	*/
+			for (unsigned int i = 0; i < nrWorkers + 1; i++) {
+				this->queues.emplace_back(std::make_unique<Queue>());
+			}
+
+			this->workers.reserve(nrWorkers);
+			for (unsigned int i = 0; i < nrWorkers; i++) {
+				this->workers.emplace_back([this, i, onThreadStart]() {
+					if (onThreadStart) {
+						onThreadStart(i + 1);
+					}
+					this->work(i + 1);
+				});
+			}
+		}
+
+		ThreadPool(const ThreadPool &other) = delete;
+		ThreadPool &operator=(const ThreadPool &other) = delete;
+
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> guard(this->sleepLock);
+				this->stopping = true;
+			}
+			this->wake.notify_all();
+			for (std::thread &worker : this->workers) {
+				worker.join();
+			}
+		}
+
+		/**
+		 * @brief Number of threads of a parallel loop, the workers and the calling thread.
+		 */
+		unsigned int getNrThreads() const noexcept { return static_cast<unsigned int>(this->workers.size()) + 1; }
+
+		/**
+		 * @brief Queue a task, not waited for by anyone, see TaskGroup to wait for tasks.
+		 */
+		void submit(Task task) { this->push(std::move(task), nullptr); }
+
+		/**
+		 * @brief Run a single pending task on the calling thread.
+		 *
+		 * @return false if there was no task to run.
+		 */
+		bool runPendingTask() { return this->runPendingTask(nullptr); }
+
+		/**
+		 * @brief Run kernel(begin, end) over [0, nrElements) in chunks of grainSize elements, and wait for
+		 *	all of them. The calling thread runs the first chunk, or the whole range if the pool has no
+		 *	workers.
+		 */
+		template <typename Kernel> void parallelFor(const size_t nrElements, const size_t grainSize, const Kernel &kernel);
+
+		/**
+		 * @brief Reduce [0, nrElements) with kernel(begin, end) per chunk of grainSize elements, the results
+		 *	are combined pairwise in a fixed order, thus the result does not depend on the number of threads.
+		 */
+		template <typename Result, typename Kernel, typename Combine>
+		Result parallelReduce(const size_t nrElements, const size_t grainSize, const Kernel &kernel,
+							  const Combine &combine) {
+			const size_t grain = std::max<size_t>(grainSize, 1);
+			const size_t nrChunks = (nrElements + grain - 1) / grain;
+			if (nrChunks <= 1) {
+				return kernel(static_cast<size_t>(0), nrElements);
+			}
+
+			std::vector<Result> partials(nrChunks);
+			this->parallelFor(nrChunks, 1, [&](const size_t first, const size_t last) {
+				for (size_t chunk = first; chunk < last; chunk++) {
+					const size_t begin = chunk * grain;
+					partials[chunk] = kernel(begin, std::min(begin + grain, nrElements));
+				}
+			});
+
+			for (size_t stride = 1; stride < nrChunks; stride *= 2) {
+				for (size_t index = 0; index + stride < nrChunks; index += 2 * stride) {
+					partials[index] = combine(partials[index], partials[index + stride]);
+				}
+			}
+			return partials[0];
+		}
+
+		/**
+		 * @brief Number of threads of the default pool, the RITSU_NUM_THREADS environment variable if set,
+		 *	the number of hardware threads otherwise.
+		 */
+		static unsigned int getDefaultNrThreads() noexcept {
+			const char *environment = std::getenv("RITSU_NUM_THREADS");
+			if (environment != nullptr) {
+				const int nrThreads = std::atoi(environment);
+				if (nrThreads > 0) {
+					return static_cast<unsigned int>(nrThreads);
+				}
+			}
+			return std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		/**
+		 * @brief Whether the calling thread is a worker of any pool.
+		 */
+		static bool isWorkerThread() noexcept { return ThreadPool::currentPool() != nullptr; }
+
+	  private:
+		friend class TaskGroup;
+
+		struct Entry {
+			Task task;
+			const void *group; /*	Task group the task belongs to, nullptr if none.	*/
+		};
+
+		struct Queue {
+			std::mutex lock;
+			std::deque<Entry> entries;
+		};
+
+		/*	From a worker the task is pushed onto the worker's own deque, otherwise the deques are
+		 *	filled round robin.	*/
+		void push(Task task, const void *group) {
+			const size_t index = ThreadPool::currentPool() == this
+									 ? ThreadPool::currentWorker()
+									 : this->nextQueue.fetch_add(1, std::memory_order_relaxed) % this->queues.size();
+
+			/*	Counted before it is visible, a worker never sees a task without it being counted.	*/
+			this->pending.fetch_add(1, std::memory_order_acq_rel);
+			{
+				std::lock_guard<std::mutex> guard(this->queues[index]->lock);
+				this->queues[index]->entries.push_back({std::move(task), group});
+			}
+			{
+				std::lock_guard<std::mutex> guard(this->sleepLock);
+			}
+			this->wake.notify_one();
+		}
+
+		/*	Run a pending task, only a task of the group unless group is nullptr.	*/
+		bool runPendingTask(const void *group) {
+			Task task;
+			if (!this->pop(task, group)) {
+				return false;
+			}
+			task();
+			return true;
+		}
+
+		/*	Newest task of the thread's own deque, else the oldest task of another deque.	*/
+		bool pop(Task &task, const void *group) {
+			const size_t nrQueues = this->queues.size();
+			const size_t own = ThreadPool::currentPool() == this ? ThreadPool::currentWorker() : 0;
+
+			for (size_t i = 0; i < nrQueues; i++) {
+				Queue &queue = *this->queues[(own + i) % nrQueues];
+				std::lock_guard<std::mutex> guard(queue.lock);
+
+				const size_t size = queue.entries.size();
+				for (size_t j = 0; j < size; j++) {
+					const size_t position = i == 0 ? size - 1 - j : j;
+					if (group != nullptr && queue.entries[position].group != group) {
+						continue;
+					}
+					task = std::move(queue.entries[position].task);
+					queue.entries.erase(queue.entries.begin() + static_cast<std::ptrdiff_t>(position));
+					this->pending.fetch_sub(1, std::memory_order_acq_rel);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void work(const size_t index) {
+			ThreadPool::currentPool() = this;
+			ThreadPool::currentWorker() = index;
+
+			while (true) {
+				if (this->runPendingTask(nullptr)) {
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(this->sleepLock);
+				this->wake.wait(lock, [this]() {
+					return this->stopping || this->pending.load(std::memory_order_acquire) > 0;
+				});
+				if (this->stopping && this->pending.load(std::memory_order_acquire) == 0) {
+					return;
+				}
+			}
+		}
+
+		static ThreadPool *&currentPool() noexcept {
+			static thread_local ThreadPool *pool = nullptr;
+			return pool;
+		}
+
+		static size_t &currentWorker() noexcept {
+			static thread_local size_t index = 0;
+			return index;
+		}
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> workers;
+		std::atomic<size_t> nextQueue{0};
+		std::atomic<size_t> pending{0}; /*	Tasks queued and not yet taken.	*/
+		std::mutex sleepLock;
+		std::condition_variable wake;
+		bool stopping = false;
+	};
+
+	/**
+	 * @brief Tasks run on a thread pool that are waited for together. The first exception thrown by a
+	 *	task is rethrown by wait.
+	 */
+	class TaskGroup {
+	  public:
+		explicit TaskGroup(ThreadPool &pool) noexcept : pool(pool) {}
+
+		TaskGroup(const TaskGroup &other) = delete;
+		TaskGroup &operator=(const TaskGroup &other) = delete;
+
+		~TaskGroup() {
+			/*	The tasks refer to the group, they must have finished.	*/
+			this->join();
+		}
+
+		template <typename Function> void run(Function &&function) {
+			this->remaining.fetch_add(1, std::memory_order_relaxed);
+			this->pool.push(
+				[this, function = std::forward<Function>(function)]() {
+					try {
+						function();
+					} catch (...) {
+						std::lock_guard<std::mutex> guard(this->lock);
+						if (!this->exception) {
+							this->exception = std::current_exception();
+						}
+					}
+					this->remaining.fetch_sub(1, std::memory_order_acq_rel);
+				},
+				this);
+		}
+
+		/**
+		 * @brief Wait for all the tasks of the group, running the pending tasks of the group meanwhile.
+		 */
+		void wait() {
+			this->join();
+
+			std::exception_ptr thrown;
+			{
+				std::lock_guard<std::mutex> guard(this->lock);
+				std::swap(thrown, this->exception);
+			}
+			if (thrown) {
+				std::rethrow_exception(thrown);
+			}
+		}
+
+	  private:
+		void join() {
+			while (this->remaining.load(std::memory_order_acquire) != 0) {
+				if (!this->pool.runPendingTask(this)) {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		ThreadPool &pool;
+		std::atomic<size_t> remaining{0};
+		std::mutex lock;
+		std::exception_ptr exception;
+	};
+
+	template <typename Kernel>
+	void ThreadPool::parallelFor(const size_t nrElements, const size_t grainSize, const Kernel &kernel) {
+		const size_t grain = std::max<size_t>(grainSize, 1);
+		const size_t nrChunks = (nrElements + grain - 1) / grain;
+
+		if (nrChunks <= 1 || this->workers.empty()) {
+			if (nrElements > 0) {
+				kernel(static_cast<size_t>(0), nrElements);
+			}
+			return;
+		}
+
+		TaskGroup group(*this);
+		for (size_t chunk = 1; chunk < nrChunks; chunk++) {
+			const size_t begin = chunk * grain;
+			const size_t end = std::min(begin + grain, nrElements);
+			group.run([&kernel, begin, end]() { kernel(begin, end); });
+		}
+		kernel(static_cast<size_t>(0), std::min(grain, nrElements));
+		group.wait();
+	}
+
+} // namespace Ritsu
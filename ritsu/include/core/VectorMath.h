@@ -0,0 +1,236 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Valdemar Lindberg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ */
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+/*	RITSU_FAST_SIGMOID used to select an approximate sigmoid, it now selects the fast math
+ *	version of all the transcendental kernels.	*/
+#if defined(RITSU_FAST_SIGMOID) && !defined(RITSU_FAST_MATH)
+#define RITSU_FAST_MATH
+#endif
+
+namespace Ritsu {
+
+	/**
+	 * @brief Single precision exp, log, log10, tanh and sigmoid that vectorize.
+	 *
+	 *	Each function is a range reduction followed by a polynomial, written with plain arithmetic,
+	 *	bit casts and masks only, thus a loop calling them is vectorized with the instruction set
+	 *	of the current CPU tier rather than calling the scalar libm once per element. Maximum
+	 *	error over all floats, against the correctly rounded result:
+	 *
+	 *		exp		1.03 ULP		log		1.00 ULP		log10	2.04 ULP
+	 *		tanh	1.33 ULP		sigmoid	2.41 ULP
+	 *
+	 *	Overflow, underflow, infinity, NaN, zero, negative and subnormal arguments are handled as by
+	 *	libm. With RITSU_FAST_MATH, lower degree polynomials are used for exp and log and special
+	 *	arguments of log are no longer handled. The error is then at most 6 ULP for exp, 3 ULP for
+	 *	tanh and 7 ULP for sigmoid, for results in the normal range, and 3e-6 absolute, up to 92 ULP
+	 *	close to one, for log and log10 of positive normal numbers. Double and integer types are
+	 *	forwarded to libm.
+	 */
+	class VectorMath {
+	  public:
+#pragma omp declare simd notinbranch
+		template <typename T> static inline T exp(const T value) noexcept {
+			if constexpr (std::is_same_v<T, float>) {
+				return VectorMath::expf(value);
+			} else {
+				return static_cast<T>(std::exp(value));
+			}
+		}
+
+#pragma omp declare simd notinbranch
+		template <typename T> static inline T log(const T value) noexcept {
+			if constexpr (std::is_same_v<T, float>) {
+				return VectorMath::logf(value);
+			} else {
+				return static_cast<T>(std::log(value));
+			}
+		}
+
+#pragma omp declare simd notinbranch
+		template <typename T> static inline T log10(const T value) noexcept {
+			if constexpr (std::is_same_v<T, float>) {
+				return VectorMath::logf(value) * Log10E;
+			} else {
+				return static_cast<T>(std::log10(value));
+			}
+		}
+
+#pragma omp declare simd notinbranch
+		template <typename T> static inline T tanh(const T value) noexcept {
+			if constexpr (std::is_same_v<T, float>) {
+				return VectorMath::tanhf(value);
+			} else {
+				return static_cast<T>(std::tanh(value));
+			}
+		}
+
+		/**
+		 * @brief 1 / (1 + exp(-x)).
+		 */
+#pragma omp declare simd notinbranch
+		template <typename T> static inline T sigmoid(const T value) noexcept {
+			if constexpr (std::is_same_v<T, float>) {
+				/*	exp(x) / (1 + exp(x)) for negative x, which does not flush to zero before the result does.	*/
+				const float e = VectorMath::expf(-std::fabs(value));
+				return VectorMath::select(value < 0.0f, e, 1.0f) / (1.0f + e);
+			} else {
+				return static_cast<T>(1) / (static_cast<T>(std::exp(-value)) + static_cast<T>(1));
+			}
+		}
+
+	  protected:
+		static constexpr float Log2E = 1.44269504088896341f;
+		static constexpr float Log10E = 0.434294481903251828f;
+		/*	ln(2) split in a part exact in a few bits and the remainder, Cody and Waite.	*/
+		static constexpr float Ln2Hi = 0.693359375f;
+		static constexpr float Ln2Lo = -2.12194440e-4f;
+
+		static inline int32_t asInt(const float value) noexcept {
+			int32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		static inline float asFloat(const int32_t bits) noexcept {
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		/*	condition ? a : b with a mask rather than a branch. Both operands are computed, which the
+		 *	compiler does not do for a conditional expression whose operands may trap, and thus does
+		 *	not vectorize it.	*/
+		static inline float select(const bool condition, const float a, const float b) noexcept {
+			const int32_t mask = -static_cast<int32_t>(condition);
+			return VectorMath::asFloat((VectorMath::asInt(a) & mask) | (VectorMath::asInt(b) & ~mask));
+		}
+
+		/*	exp(x) = 2^n * exp(r), where n = round(x / ln(2)) and |r| <= ln(2) / 2.	*/
+		static inline float expf(const float value) noexcept {
+			/*	|x| <= 104 is wide enough for the result to overflow to infinity and underflow to zero by
+			 *	itself.	*/
+			const float x = VectorMath::select(std::fabs(value) > 104.0f, std::copysign(104.0f, value), value);
+
+			/*	Round to nearest by the addition of 1.5 * 2^23, the integer ends up in the mantissa.	*/
+			constexpr float Shifter = 12582912.0f;
+			const float shifted = x * Log2E + Shifter;
+			const float n = shifted - Shifter;
+			const int32_t exponent = VectorMath::asInt(shifted) - VectorMath::asInt(Shifter);
+
+			float r = x - n * Ln2Hi;
+			r = r - n * Ln2Lo;
+
+#ifdef RITSU_FAST_MATH
+			float p = 8.369153427591597e-3f;
+			p = p * r + 4.1833823318696374e-2f;
+			p = p * r + 1.6666523150862153e-1f;
+			p = p * r + 4.9999748874459815e-1f;
+#else
+			float p = 1.9875691500e-4f;
+			p = p * r + 1.3981999507e-3f;
+			p = p * r + 8.3334519073e-3f;
+			p = p * r + 4.1665795894e-2f;
+			p = p * r + 1.6666665459e-1f;
+			p = p * r + 5.0000001201e-1f;
+#endif
+			const float y = p * r * r + r + 1.0f;
+
+			/*	2^n in two steps, n alone may not be a normal exponent near the ends of the range.	*/
+			const int32_t half = exponent >> 1;
+			return y * VectorMath::asFloat((half + 127) << 23) * VectorMath::asFloat((exponent - half + 127) << 23);
+		}
+
+		/*	log(x) = e * ln(2) + log(m), where x = m * 2^e and sqrt(0.5) <= m < sqrt(2).	*/
+		static inline float logf(const float value) noexcept {
+#ifdef RITSU_FAST_MATH
+			const float x = value;
+			int32_t exponent = 0;
+#else
+			/*	Scale subnormals into the normal range.	*/
+			const bool subnormal = value < std::numeric_limits<float>::min();
+			const float x = VectorMath::select(subnormal, value * 8388608.0f, value);
+			int32_t exponent = subnormal ? -23 : 0;
+#endif
+			const int32_t bits = VectorMath::asInt(x);
+			exponent += ((bits >> 23) & 0xff) - 126;
+			float m = VectorMath::asFloat((bits & 0x007fffff) | 0x3f000000);
+
+			const bool below = m < 0.707106781186547524f;
+			exponent = below ? exponent - 1 : exponent;
+			m = VectorMath::select(below, m + m, m);
+
+			const float f = m - 1.0f;
+			const float z = f * f;
+			const float e = static_cast<float>(exponent);
+
+#ifdef RITSU_FAST_MATH
+			float p = 1.2941412532732352e-1f;
+			p = p * f - 1.8328799755328865e-1f;
+			p = p * f + 2.0191114936999982e-1f;
+			p = p * f - 2.4953641216528720e-1f;
+			p = p * f + 3.3331329652770130e-1f;
+#else
+			float p = 7.0376836292e-2f;
+			p = p * f - 1.1514610310e-1f;
+			p = p * f + 1.1676998740e-1f;
+			p = p * f - 1.2420140846e-1f;
+			p = p * f + 1.4249322787e-1f;
+			p = p * f - 1.6668057665e-1f;
+			p = p * f + 2.0000714765e-1f;
+			p = p * f - 2.4999993993e-1f;
+			p = p * f + 3.3333331174e-1f;
+#endif
+			float y = f * z * p;
+			y += Ln2Lo * e;
+			y -= 0.5f * z;
+			const float result = f + y + Ln2Hi * e;
+
+#ifdef RITSU_FAST_MATH
+			return result;
+#else
+			/*	Infinity, negative or NaN, and zero.	*/
+			const float special = VectorMath::select(value >= std::numeric_limits<float>::infinity(), value, result);
+			const float negative = VectorMath::select(value > 0.0f, special, std::numeric_limits<float>::quiet_NaN());
+			return VectorMath::select(value == 0.0f, -std::numeric_limits<float>::infinity(), negative);
+#endif
+		}
+
+		/*	Odd polynomial near zero, 1 - 2 / (exp(2|x|) + 1) otherwise.	*/
+		static inline float tanhf(const float value) noexcept {
+			const float z = value * value;
+			float p = -5.70498872745e-3f;
+			p = p * z + 2.06390887954e-2f;
+			p = p * z - 5.37397155531e-2f;
+			p = p * z + 1.33314422036e-1f;
+			p = p * z - 3.33332819422e-1f;
+			const float small = value + value * z * p;
+
+			const float magnitude = std::fabs(value);
+			const float e = VectorMath::expf(magnitude + magnitude);
+			const float large = std::copysign(1.0f - 2.0f / (e + 1.0f), value);
+
+			return VectorMath::select(magnitude < 0.625f, small, large);
+		}
+	};
+
+} // namespace Ritsu
@@ -14,6 +14,7 @@
  * all copies or substantial portions of the Software.
  */
 #pragma once
+#include "Activations.h"
 #include "layers/Layer.h"
 
 namespace Ritsu {
@@ -27,6 +28,17 @@ namespace Ritsu {
 		Activation(const std::string &name = "activation") : Layer(name) {}
 		~Activation() = default;
 
+		/**
+		 * @brief Elementwise function of the activation, that the layer before can apply to its output in
+		 *	place of this layer. None if the activation can not be fused.
+		 */
+		virtual ActivationFunction getFusedFunction() const noexcept { return ActivationFunction::None; }
+
+		/**
+		 * @brief Parameter of the fused function, see computeActivation.
+		 */
+		virtual DType getFusedParameter() const noexcept { return 0; }
+
 		// virtual Tensor<float> operator<<(Tensor<float> &tensor) override { return tensor; }
 		//
 		// virtual Tensor<float> operator>>(Tensor<float> &tensor) override { return tensor; }
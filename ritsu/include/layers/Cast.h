@@ -45,6 +45,12 @@ namespace Ritsu {
 			return tmp;
 		}
 
+		void callBatch(const Tensor<float> &batch, Tensor<float> &output, bool training) override {
+			Layer<T>::reserveBatch(output, this->getBatchShape(batch.getShape()[0]));
+			output.assign(batch);
+			Cast::createCastTensorRef(output);
+		}
+
 		void setInputs(const std::vector<Layer<T> *> &layers) override {
 			this->input = layers[0];
 
@@ -14,11 +14,14 @@
  * all copies or substantial portions of the Software.
  */
 #pragma once
+#include "../Activations.h"
+#include "../core/Gemm.h"
 #include "../core/Initializers.h"
 #include "Layer.h"
 #include "RitsuDef.h"
 #include "Tensor.h"
 #include <cassert>
+#include <cstring>
 #include <ctime>
 
 namespace Ritsu {
@@ -82,10 +85,48 @@ namespace Ritsu {
 			return output;
 		}
 
+		void callBatch(const Tensor<DType> &batch, Tensor<DType> &output, bool training) override {
+			const IndexType batchSize = batch.getShape()[0];
+			const IndexType nrInputs = this->weight.getShape()[-1];
+
+			if (batch.getNrElements() != batchSize * nrInputs) {
+				throw InvalidArgumentException("Invalid Batch Shape");
+			}
+
+			Layer::reserveBatch(output, this->getBatchShape(batchSize));
+			this->computeBatch(batch, output);
+		}
+
+		/**
+		 * @brief callBatch followed by the elementwise activation, applied as the output of the product is
+		 *	written rather than in another pass, see Model::setLayerFusion.
+		 */
+		void callBatchFused(const Tensor<DType> &batch, Tensor<DType> &output, const ActivationFunction function,
+							const DType parameter) {
+			const IndexType batchSize = batch.getShape()[0];
+			const IndexType nrInputs = this->weight.getShape()[-1];
+
+			if (batch.getNrElements() != batchSize * nrInputs) {
+				throw InvalidArgumentException("Invalid Batch Shape");
+			}
+
+			Layer::reserveBatch(output, this->getBatchShape(batchSize));
+			this->computeBatch(batch, output, function, parameter);
+		}
+
+		/**
+		 * @brief The weights may be modified through the references, the packed weights are dropped.
+		 */
 		std::optional<std::vector<Tensor<DType> *>> getTrainableWeights() noexcept override {
+			this->weights_updated();
 			return this->variables_reference;
 		}
 
+		void weights_updated() noexcept override {
+			this->packedWeight.clear();
+			this->packedWeightTransposed.clear();
+		}
+
 		void build(const Shape<IndexType> &buildShape) override {
 
 			if (buildShape.getNrDimensions() > 1) {
@@ -96,6 +137,7 @@ namespace Ritsu {
 			const Shape<IndexType> weightShape =
 				Shape<IndexType>({static_cast<IndexType>(this->units), static_cast<IndexType>(buildShape[0])});
 			this->weight = Tensor<DType>(weightShape);
+			this->weights_updated();
 
 			/*	*/
 			this->shape = {this->units};
@@ -140,14 +182,40 @@ namespace Ritsu {
 		Tensor<float> compute_gradient(const IndexType parameter_index, const Tensor<float> &deriv_z,
 									   const Tensor<float> &Q) override {
 			if (parameter_index == 0) {
-				return deriv_z.dot(Q.transpose());
+				return Dense::weightGradientOf(deriv_z, Q);
 			}
 			if (parameter_index == 1) {
-				return deriv_z.transpose().sum(0);
+				return this->biasGradientOf(deriv_z);
 			}
 			return {};
 		}
 
+		/**
+		 * @brief dW = scale * deriv_z * Q^T and the bias gradient, the sum of deriv_z over the batch times scale,
+		 *	as compute_gradient followed by the scale, written or added into the gradient buffers.
+		 */
+		std::optional<std::vector<Tensor<DType> *>> accumulate_gradients(const Tensor<float> &deriv_z,
+																		 const Tensor<float> &Q, const DType scale,
+																		 const bool accumulate) override {
+			/*	Allocated on first use, inference never needs them. They outlive any arena scope.	*/
+			if (this->weightGradient.getShape() != this->weight.getShape()) {
+				ScopedAllocator persistent(nullptr);
+				this->weightGradient = Tensor<DType>(this->weight.getShape());
+				this->weightGradient.assignInitValue(0);
+				if (this->use_bias) {
+					this->biasGradient = Tensor<DType>(this->bias.getShape());
+					this->biasGradient.assignInitValue(0);
+				}
+			}
+
+			this->computeWeightGradient(deriv_z, Q, scale, accumulate, this->weightGradient);
+			if (this->use_bias) {
+				this->computeBiasGradient(deriv_z, scale, accumulate, this->biasGradient);
+				return std::vector<Tensor<DType> *>{&this->weightGradient, &this->biasGradient};
+			}
+			return std::vector<Tensor<DType> *>{&this->weightGradient};
+		}
+
 	  private:
 		/*	*/
 		Layer<DType> *input{};
@@ -162,9 +230,160 @@ namespace Ritsu {
 			}
 		}
 
-		inline void computeDerivative(const Tensor<float> &value, Tensor<float> &result) const {
-			/*	Dz = W^T*value	*/
-			this->weight.transpose().dot(value, result);
+		/**
+		 * @brief Output[B, units] = activation(Input[B, in] * W + bias), as a single matrix multiplication.
+		 *	The weight memory is laid out as [in, units], see compute.
+		 */
+		void computeBatch(const Tensor<float> &inputTensor, Tensor<float> &output,
+						  const ActivationFunction function = ActivationFunction::None,
+						  const DType parameter = 0) const {
+			const IndexType batchSize = inputTensor.getShape()[0];
+			const IndexType nrInputs = this->weight.getShape()[-1];
+			const DType *biasData = this->use_bias ? this->bias.getRawData() : nullptr;
+
+			/*	A single row gains nothing from the packed weights.	*/
+			const bool packed = batchSize > 1;
+			if (packed) {
+				this->packWeight(this->packedWeight, nrInputs, this->units, this->units, 1);
+			}
+
+			/*	Bias and activation are added to each block of the output while it is still in cache.	*/
+			dispatchActivation(function, [&](auto activation) {
+				const BiasActivation<decltype(activation)::value> epilogue{biasData, parameter};
+				if (packed) {
+					Gemm::gemm<DType>(batchSize, 1, inputTensor.getRawData(), nrInputs, 1, this->packedWeight, 0,
+									  output.getRawData(), this->units, 1, epilogue);
+				} else {
+					Gemm::gemm<DType>(batchSize, this->units, nrInputs, 1, inputTensor.getRawData(), nrInputs, 1,
+									  this->weight.getRawData(), this->units, 1, 0, output.getRawData(), this->units,
+									  1, epilogue);
+				}
+			});
+		}
+
+		/**
+		 * @brief Pack the weight memory as the B[K x N] operand, unless already packed since the weights last
+		 *	changed.
+		 */
+		void packWeight(GemmPackedB<DType> &packed, const size_t K, const size_t N, const std::ptrdiff_t rowStride,
+						const std::ptrdiff_t colStride) const {
+			const DType *weightData = this->weight.getRawData();
+			if (!Gemm::isPacked(packed, K, N, weightData, rowStride, colStride)) {
+				Gemm::pack<DType>(K, N, weightData, rowStride, colStride, packed);
+			}
+		}
+
+		/**
+		 * @brief Epilogue of the product, the bias of the column, if any, followed by the activation.
+		 */
+		template <ActivationFunction Function> struct BiasActivation {
+			const DType *bias;
+			DType parameter;
+
+			DType operator()([[maybe_unused]] const size_t row, const size_t column, DType value) const noexcept {
+				if (this->bias != nullptr) {
+					value += this->bias[column];
+				}
+				return computeActivation<Function, DType>(value, this->parameter);
+			}
+		};
+
+		void computeDerivative(const Tensor<float> &value, Tensor<float> &result) const {
+			const Shape<IndexType> &valueShape = value.getShape();
+			const IndexType nrInputs = this->weight.getShape()[-1];
+
+			if (valueShape.getNrDimensions() > 2 || valueShape[0] != this->units) {
+				/*	Dz = W^T*value	*/
+				this->weight.transpose().dot(value, result);
+				return;
+			}
+
+			/*	Dz[in x B] = W^T * value[units x B], computed as Dz^T = value^T * W^T with the packed W^T, in the
+			 *	layout of Tensor::dot.	*/
+			const IndexType nrColumns = value.getNrElements() / this->units;
+			Tensor<float> output(Shape<IndexType>({nrInputs, nrColumns}));
+
+			if (nrColumns > 1) {
+				this->packWeight(this->packedWeightTransposed, this->units, nrInputs, nrInputs, 1);
+				Gemm::gemm<DType>(nrColumns, 1, value.getRawData(), this->units, 1, this->packedWeightTransposed, 0,
+								  output.getRawData(), 1, nrColumns);
+			} else {
+				Gemm::gemm<DType>(1, nrInputs, this->units, 1, value.getRawData(), this->units, 1,
+								  this->weight.getRawData(), nrInputs, 1, 0, output.getRawData(), 1, 1);
+			}
+			result = std::move(output);
+		}
+
+		void computeWeightGradient(const Tensor<float> &deriv_z, const Tensor<float> &Q, const DType scale,
+								   const bool accumulate, Tensor<DType> &gradient) const {
+			const Shape<IndexType> &zShape = deriv_z.getShape();
+			Shape<IndexType> qShape = Q.getShape();
+			qShape.transpose();
+
+			const IndexType nrInputs = this->weight.getShape()[-1];
+			const IndexType batchSize = zShape.getNrDimensions() > 1 ? zShape[-1] : 1;
+			const IndexType nrColumns = qShape.getNrDimensions() > 1 ? qShape[-1] : 1;
+
+			if (zShape.getNrDimensions() > 2 || qShape.getNrDimensions() > 2 || zShape[0] != this->units ||
+				qShape[0] != batchSize || nrColumns != nrInputs) {
+				Dense::scaleGradient(Dense::weightGradientOf(deriv_z, Q), scale, accumulate, gradient);
+				return;
+			}
+
+			/*	dW[units x in] = scale * deriv_z * Q^T + dW, the scale of the batch as alpha, in the layout of
+			 *	Tensor::dot.	*/
+			Gemm::gemm<DType>(this->units, nrInputs, batchSize, scale, deriv_z.getRawData(), 1, this->units,
+							  Q.getRawData(), 1, batchSize, accumulate ? 1 : 0, gradient.getRawData(), nrInputs, 1);
+		}
+
+		void computeBiasGradient(const Tensor<float> &deriv_z, const DType scale, const bool accumulate,
+								 Tensor<DType> &gradient) const {
+			const size_t nrElements = deriv_z.getNrElements();
+
+			if (deriv_z.getShape()[0] != this->units || nrElements % this->units != 0) {
+				Dense::scaleGradient(this->biasGradientOf(deriv_z), scale, accumulate, gradient);
+				return;
+			}
+
+			/*	Each row of deriv_z is the batch of a unit, summed and scaled in a single pass.	*/
+			const size_t batchSize = nrElements / this->units;
+			const DType *input = deriv_z.getRawData();
+			DType *output = gradient.getRawData();
+
+			CpuDispatch::parallelFor(this->units, [&](const size_t begin, const size_t end) {
+				for (size_t unit = begin; unit < end; unit++) {
+					const DType sum = scale * Math::sumRange<DType>(&input[unit * batchSize], 0, batchSize);
+					output[unit] = accumulate ? output[unit] + sum : sum;
+				}
+			});
+		}
+
+		static Tensor<float> weightGradientOf(const Tensor<float> &deriv_z, const Tensor<float> &Q) {
+			return deriv_z.dot(Q.transpose());
+		}
+
+		Tensor<float> biasGradientOf(const Tensor<float> &deriv_z) const {
+			/*	Sum over the batch, in the shape of the bias.	*/
+			Tensor<float> gradient = Tensor<float>::sum(deriv_z, 1);
+			gradient.reshape(this->bias.getShape());
+			return gradient;
+		}
+
+		static void scaleGradient(const Tensor<float> &gradient, const DType scale, const bool accumulate,
+								  Tensor<DType> &output) {
+			if (gradient.getNrElements() != output.getNrElements()) {
+				throw InvalidArgumentException("Gradient does not match the shape of the weight");
+			}
+
+			const DType *input = gradient.getRawData();
+			DType *data = output.getRawData();
+
+			CpuDispatch::parallelFor(output.getNrElements(), [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					data[i] = accumulate ? data[i] + scale * input[i] : scale * input[i];
+				}
+			});
 		}
 
 		void initweight() noexcept { this->weight_init->set(this->weight); }
@@ -174,7 +393,6 @@ namespace Ritsu {
 			if (this->bias.getNrElements() > 0) {
 
 				this->bias_init->set(this->bias);
-				this->bias.reshape({1, this->bias.getShape().getAxisDimensions(-1)});
 			}
 		}
 
@@ -184,6 +402,13 @@ namespace Ritsu {
 		Tensor<DType> weight;
 		bool use_bias;
 		std::vector<Tensor<float> *> variables_reference; /*	*/
+		/*	Weights packed for the forward and the backward product, packed on first use after the weights
+		 *	change. Inference only ever packs the forward.	*/
+		mutable GemmPackedB<DType> packedWeight;
+		mutable GemmPackedB<DType> packedWeightTransposed;
+		/*	Gradients of the weight and bias, see accumulate_gradients.	*/
+		Tensor<DType> weightGradient;
+		Tensor<DType> biasGradient;
 		Initializer<DType> *weight_init = nullptr;
 		Initializer<DType> *bias_init = nullptr;
 	};
@@ -52,6 +52,18 @@ namespace Ritsu {
 			return tmpOutput;
 		}
 
+		void callBatch(const Tensor<DType> &batch, Tensor<DType> &output, bool training) override {
+			Layer::reserveBatch(output, this->getBatchShape(batch.getShape()[0]));
+			output.assign(batch);
+
+			/*	Only drop during training, identity on inference.	*/
+			if (training) {
+				this->computeDropout(output);
+			}
+		}
+
+		bool supports_inplace() const noexcept override { return true; }
+
 		void setOutputs(const std::vector<Layer<DType> *> &layers) override {
 			/*	Set input layer */
 			this->outputs = layers;
@@ -82,13 +94,14 @@ namespace Ritsu {
 		void computeDropout(Tensor<float> &tensor) const { /*	Iterate through each all elements.    */
 
 			this->random->reset();
-			const IndexType nrElements = tensor.getNrElements();
-
-#pragma omp parallel for shared(tensor)
-			for (IndexType i = 0; i < nrElements; i++) {
-				const DType value = tensor.getValue<DType>(i) * this->random->rand() *
-									(static_cast<DType>(1) / (static_cast<DType>(1) - this->perc));
-				tensor.getValue<DType>(i) = value;
+			const SizeType nrElements = tensor.getNrElements();
+			const TensorSpan<DType> data = tensor.span();
+
+#pragma omp parallel for shared(data)
+			for (SizeType i = 0; i < nrElements; i++) {
+				const DType value =
+					data[i] * this->random->rand() * (static_cast<DType>(1) / (static_cast<DType>(1) - this->perc));
+				data[i] = value;
 			}
 		}
 
@@ -71,12 +71,15 @@ namespace Ritsu {
 	  private:
 		void computeActivation(Tensor<float> &tensor) {
 			/*Iterate through each all elements.    */
-			const size_t nrElements = tensor.getNrElements();
+			const TensorSpan<DType> data = tensor.span();
+			const SizeType nrElements = data.size();
 
-#pragma omp parallel shared(tensor)
-			for (size_t i = 0; i < nrElements; i++) {
-				tensor.getValue<DType>(i) = Ritsu::computeExpLinear(coff, tensor.getValue<DType>(i));
-			}
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					data[i] = Ritsu::computeExpLinear(coff, data[i]);
+				}
+			});
 		}
 
 	  private:
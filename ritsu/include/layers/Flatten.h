@@ -40,6 +40,13 @@ namespace Ritsu {
 			return tmp.flatten();
 		}
 
+		void callBatch(const Tensor<DType> &batch, Tensor<DType> &output, bool training) override {
+			Layer::reserveBatch(output, this->getBatchShape(batch.getShape()[0]));
+			output.assign(batch);
+		}
+
+		bool supports_inplace() const noexcept override { return true; }
+
 		void build(const Shape<IndexType> &buildShape) override { this->shape = buildShape.flatten(); }
 
 		void setInputs(const std::vector<Layer<DType> *> &layers) override {
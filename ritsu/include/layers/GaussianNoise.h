@@ -57,6 +57,18 @@ namespace Ritsu {
 			return tmp;
 		}
 
+		void callBatch(const Tensor<DType> &batch, Tensor<DType> &output, bool training) override {
+			Layer::reserveBatch(output, this->getBatchShape(batch.getShape()[0]));
+			output.assign(batch);
+
+			/*	Only add noise during training, identity on inference.	*/
+			if (training) {
+				this->applyNoise(output);
+			}
+		}
+
+		bool supports_inplace() const noexcept override { return true; }
+
 		void setOutputs(const std::vector<Layer<DType> *> &layers) override {
 			/*	Set input layer */
 			this->outputs = layers;
@@ -84,10 +96,11 @@ namespace Ritsu {
 	  protected:
 		void applyNoise(Tensor<float> &tensor) noexcept {
 			/*Iterate through each all elements.    */
-			const size_t nrElements = tensor.getNrElements();
-#pragma omp parallel for simd shared(tensor)
-			for (size_t i = 0; i < nrElements; i++) {
-				tensor.getValue<DType>(i) += this->random->rand();
+			const TensorSpan<DType> data = tensor.span();
+			const SizeType nrElements = data.size();
+#pragma omp parallel for simd shared(data)
+			for (SizeType i = 0; i < nrElements; i++) {
+				data[i] += this->random->rand();
 			}
 		}
 
@@ -33,6 +33,11 @@ namespace Ritsu {
 
 		Tensor<DType> call(const Tensor<DType> &tensor, bool training) override { return tensor; }
 
+		void callBatch(const Tensor<DType> &batch, Tensor<DType> &output, bool training) override {
+			Layer::reserveBatch(output, this->getBatchShape(batch.getShape()[0]));
+			output.assign(batch);
+		}
+
 		void setInputs([[maybe_unused]] const std::vector<Layer<DType> *> &layers) override {
 			/*	No input layer connection, since input layer.	*/
 		}
@@ -61,6 +61,27 @@ namespace Ritsu {
 		virtual Tensor<float> &call(Tensor<float> &tensor, bool training) = 0;
 		virtual Tensor<float> call(const Tensor<float> &tensor, bool training) = 0;
 
+		/**
+		 * @brief Compute the layer on a whole batch, [batch, ...] -> [batch, shape].
+		 *	The default implementation calls the layer on each sample, built-in layers override it
+		 *	to process the batch at once.
+		 */
+		virtual void callBatch(const Tensor<float> &batch, Tensor<float> &output, bool training) {
+			const IndexType batchSize = batch.getShape()[0];
+			Layer::reserveBatch(output, this->getBatchShape(batchSize));
+
+			for (IndexType batch_index = 0; batch_index < batchSize; batch_index++) {
+				Tensor<float> sample = batch.getSubset({{batch_index}});
+				sample.reduce();
+
+				Tensor<float> outputSample = output.getSubset({{batch_index}});
+
+				/*	Perform layer on data.	*/
+				const Tensor<float> result = this->call(static_cast<const Tensor<float> &>(sample), training);
+				outputSample.assign(result);
+			}
+		}
+
 		/**
 		 * @brief
 		 */
@@ -91,6 +112,12 @@ namespace Ritsu {
 		// non-trainable.
 		virtual std::optional<std::vector<Tensor<DType> *>> getVariables() noexcept { return {}; }
 
+		/**
+		 * @brief Called after the trainable weights have been modified in place, e.g. by the optimizer, for the
+		 *	layer to drop anything derived from them.
+		 */
+		virtual void weights_updated() noexcept {}
+
 		// input
 		virtual std::vector<Layer<T> *> getInputs() const { return {}; };
 
@@ -131,8 +158,24 @@ namespace Ritsu {
 			return {};
 		}
 
+		/**
+		 * @brief Gradients of the trainable weights, in the order of getTrainableWeights, multiplied by scale into
+		 *	buffers owned by the layer, or added onto them when accumulating several batches before a step of
+		 *	the optimizer. Layers without the buffers return nothing, see compute_gradient.
+		 */
+		virtual std::optional<std::vector<Tensor<DType> *>>
+		accumulate_gradients([[maybe_unused]] const Tensor<float> &deriv_z, [[maybe_unused]] const Tensor<float> &Q,
+							 [[maybe_unused]] const DType scale, [[maybe_unused]] const bool accumulate) {
+			return {};
+		}
+
 		virtual bool has_derivative() const noexcept { return true; }
 
+		/**
+		 * @brief If callBatch may write the output over the input, when both share memory.
+		 */
+		virtual bool supports_inplace() const noexcept { return false; }
+
 		void addInputLayers(const std::vector<Layer<DType> *> &layers) {
 			/*	*/
 			this->setInputs(layers);
@@ -143,6 +186,28 @@ namespace Ritsu {
 			this->setOutputs(layers);
 		}
 
+		/**
+		 * @brief Shape of the layer output for a batch, [batchSize, shape].
+		 */
+		Shape<IndexType> getBatchShape(const IndexType batchSize) const {
+			Shape<IndexType> batchShape = this->getShape();
+			batchShape.insert(0, {batchSize});
+			return batchShape;
+		}
+
+	  protected:
+		/**
+		 * @brief Shape the output tensor for the batch, only reallocating if the number of elements differs.
+		 */
+		static Tensor<float> &reserveBatch(Tensor<float> &output, const Shape<IndexType> &batchShape) {
+			if (output.getRawData() == nullptr || output.getNrElements() != batchShape.getNrElements()) {
+				output = Tensor<float>(batchShape);
+			} else if (output.getShape() != batchShape) {
+				output.reshape(batchShape);
+			}
+			return output;
+		}
+
 	  protected:
 		Shape<IndexType> shape;
 	};
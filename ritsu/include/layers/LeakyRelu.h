@@ -84,19 +84,25 @@ namespace Ritsu {
 	  protected:
 		void computeReluLeakyActivation(Tensor<float> &tensor) const {
 			/*Iterate through each all elements.    */
-			const size_t nrElements = tensor.getNrElements();
-#pragma omp parallel for shared(tensor)
-			for (size_t i = 0; i < nrElements; i++) {
-				tensor.getValue<DType>(i) = leakyRelu(tensor.getValue<DType>(i), this->alpha);
-			}
+			const TensorSpan<DType> data = tensor.span();
+			const SizeType nrElements = data.size();
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					data[i] = leakyRelu(data[i], this->alpha);
+				}
+			});
 		}
 
 		void computeReluLeakyDerivative(Tensor<float> &tensor) const {
-			const size_t nrElements = tensor.getNrElements();
-#pragma omp parallel for shared(tensor)
-			for (size_t i = 0; i < nrElements; i++) {
-				tensor.getValue<DType>(i) = leakyReluDerivative(tensor.getValue<DType>(i), this->alpha);
-			}
+			const TensorSpan<DType> data = tensor.span();
+			const SizeType nrElements = data.size();
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					data[i] = leakyReluDerivative(data[i], this->alpha);
+				}
+			});
 		}
 
 	  private:
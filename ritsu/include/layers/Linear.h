@@ -68,22 +68,28 @@ namespace Ritsu {
 	  private:
 		void computeActivation(Tensor<float> &tensor) {
 			/*Iterate through each all elements.    */
-			const size_t nrElements = tensor.getNrElements();
-
-#pragma omp parallel for simd shared(tensor)
-			for (size_t i = 0; i < nrElements; i++) {
-				tensor.getValue<DType>(i) = Ritsu::computeLinear(this->linear, tensor.getValue<DType>(i));
-			}
+			const TensorSpan<DType> data = tensor.span();
+			const SizeType nrElements = data.size();
+
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					data[i] = Ritsu::computeLinear(this->linear, data[i]);
+				}
+			});
 		}
 
 		void computeActivationDerivative(Tensor<float> &tensor) {
 			/*Iterate through each all elements.    */
-			const size_t nrElements = tensor.getNrElements();
-
-#pragma omp parallel for shared(tensor)
-			for (size_t i = 0; i < nrElements; i++) {
-				tensor.getValue<DType>(i) = Ritsu::computeLinearDerivative(this->linear);
-			}
+			const TensorSpan<DType> data = tensor.span();
+			const SizeType nrElements = data.size();
+
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					data[i] = Ritsu::computeLinearDerivative(this->linear);
+				}
+			});
 		}
 
 	  private:
@@ -79,6 +79,9 @@ namespace Ritsu {
 			assert(layers.size() == 1);
 		}
 
+		DType getL1() const noexcept { return this->l1; }
+		DType getL2() const noexcept { return this->l2; }
+
 		std::vector<Layer<DType> *> getInputs() const override { return {input}; }
 		std::vector<Layer<DType> *> getOutputs() const override { return outputs; }
 
@@ -113,10 +116,13 @@ namespace Ritsu {
 		// TODO: relocate to some util
 		static void computeL1(const Tensor<float> &tensor, const DType L1, Tensor<float> &output) noexcept {
 
+			const TensorSpan<const DType> data = tensor.span();
+			const SizeType nrElements = data.size();
+
 			DType sum = 0;
 #pragma omp simd reduction(+ : sum)
-			for (size_t i = 0; i < tensor.getNrElements(); i++) {
-				sum += std::abs(tensor.getValue<DType>(i));
+			for (SizeType i = 0; i < nrElements; i++) {
+				sum += std::abs(data[i]);
 			}
 			sum *= L1;
 
@@ -58,6 +58,14 @@ namespace Ritsu {
 			return output;
 		}
 
+		void callBatch(const Tensor<DType> &batch, Tensor<DType> &output, bool training) override {
+			Layer::reserveBatch(output, this->getBatchShape(batch.getShape()[0]));
+			output.assign(batch);
+			this->computeReluActivation(output);
+		}
+
+		bool supports_inplace() const noexcept override { return true; }
+
 		void setOutputs(const std::vector<Layer<DType> *> &layers) override {
 			/*	Set input layer */
 			this->outputs = layers;
@@ -70,6 +78,8 @@ namespace Ritsu {
 
 		void build(const Shape<IndexType> &buildShape) override { this->shape = buildShape; }
 
+		ActivationFunction getFusedFunction() const noexcept override { return ActivationFunction::Relu; }
+
 		std::vector<Layer<DType> *> getInputs() const override { return {input}; }
 		std::vector<Layer<DType> *> getOutputs() const override { return outputs; }
 
@@ -87,7 +97,7 @@ namespace Ritsu {
 	  protected:
 		void computeReluActivation(Tensor<float> &tensor) {
 
-			const IndexType nrElements = tensor.getNrElements();
+			const SizeType nrElements = tensor.getNrElements();
 			Ritsu::relu<DType>(tensor.getRawData(), nrElements);
 		}
 
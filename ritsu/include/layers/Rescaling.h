@@ -48,6 +48,22 @@ namespace Ritsu {
 			return tmp;
 		}
 
+		void callBatch(const Tensor<DType> &batch, Tensor<DType> &output, bool training) override {
+			Layer::reserveBatch(output, this->getBatchShape(batch.getShape()[0]));
+
+			const SizeType nrElements = output.getNrElements();
+			const DType *input = batch.getRawData();
+			DType *result = output.getRawData();
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					result[i] = input[i] * this->scale;
+				}
+			});
+		}
+
+		bool supports_inplace() const noexcept override { return true; }
+
 		void setInputs(const std::vector<Layer<DType> *> &layers) override {
 			this->input = layers[0];
 			this->shape = this->input->getShape();
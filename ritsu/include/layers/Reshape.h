@@ -49,6 +49,13 @@ namespace Ritsu {
 			return tmp;
 		}
 
+		void callBatch(const Tensor<DType> &batch, Tensor<DType> &output, bool training) override {
+			Layer::reserveBatch(output, this->getBatchShape(batch.getShape()[0]));
+			output.assign(batch);
+		}
+
+		bool supports_inplace() const noexcept override { return true; }
+
 		void build(const Shape<IndexType> &shape) override {
 			//			assert(shape == this->newShape);
 			this->shape = newShape;
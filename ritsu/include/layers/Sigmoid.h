@@ -55,6 +55,14 @@ namespace Ritsu {
 			return output;
 		}
 
+		void callBatch(const Tensor<DType> &batch, Tensor<DType> &output, bool training) override {
+			Layer::reserveBatch(output, this->getBatchShape(batch.getShape()[0]));
+			output.assign(batch);
+			this->computeActivation(output);
+		}
+
+		bool supports_inplace() const noexcept override { return true; }
+
 		void setOutputs(const std::vector<Layer<DType> *> &layers) override {
 			/*	Set input layer */
 			this->outputs = layers;
@@ -67,11 +75,13 @@ namespace Ritsu {
 
 		void build(const Shape<IndexType> &buildShape) override { this->shape = buildShape; }
 
+		ActivationFunction getFusedFunction() const noexcept override { return ActivationFunction::Sigmoid; }
+
 		std::vector<Layer<DType> *> getInputs() const override { return {input}; }
 		std::vector<Layer<DType> *> getOutputs() const override { return outputs; }
 
 		Tensor<float> compute_derivative(const Tensor<float> &tensor) override {
-			Tensor<float> result(tensor.getShape());
+			Tensor<float> result = tensor;
 
 			this->computeSigmoidDerivative(result);
 			return result;
@@ -85,13 +95,13 @@ namespace Ritsu {
 	  private:
 		void computeSigmoidDerivative(Tensor<float> &tensor) const noexcept {
 			/*	Iterate through each all elements.    */
-			const IndexType nrElements = tensor.getNrElements();
+			const SizeType nrElements = tensor.getNrElements();
 			Ritsu::computeSigmoidDerivative<DType>(tensor.getRawData(), nrElements);
 		}
 
 		void computeActivation(Tensor<float> &tensor) noexcept {
 			/*	Iterate through each all elements.    */
-			const IndexType nrElements = tensor.getNrElements();
+			const SizeType nrElements = tensor.getNrElements();
 			Ritsu::computeSigmoid<DType>(tensor.getRawData(), nrElements);
 		}
 
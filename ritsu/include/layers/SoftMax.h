@@ -51,6 +51,23 @@ namespace Ritsu {
 			return tmp;
 		}
 
+		void callBatch(const Tensor<DType> &batch, Tensor<DType> &output, bool training) override {
+			const IndexType batchSize = batch.getShape()[0];
+			const IndexType nrElements = this->getShape().getNrElements();
+
+			Layer::reserveBatch(output, this->getBatchShape(batchSize));
+			output.assign(batch);
+
+			/*	Normalize each sample independently.	*/
+			DType *data = output.getRawData();
+			const bool threaded = CpuDispatch::selectPath(output.getNrElements()) == ExecutionPath::Threaded;
+			CpuDispatch::parallelForEach(batchSize, threaded, [&](const size_t b) {
+				Ritsu::softMax<DType>(&data[static_cast<SizeType>(b) * nrElements], nrElements);
+			});
+		}
+
+		bool supports_inplace() const noexcept override { return true; }
+
 		void build(const Shape<IndexType> &buildShape) override { this->shape = buildShape; }
 
 		void setInputs(const std::vector<Layer<DType> *> &layers) override { this->input = layers[0]; }
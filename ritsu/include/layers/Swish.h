@@ -70,18 +70,24 @@ namespace Ritsu {
 		Tensor<float> compute_derivative(const Tensor<float> &tensor) override { return tensor; }
 		Tensor<float> &compute_derivative(Tensor<float> &tensor) const override { return tensor; }
 
+		ActivationFunction getFusedFunction() const noexcept override { return ActivationFunction::Swish; }
+		DType getFusedParameter() const noexcept override { return this->beta; }
+
 		std::vector<Layer<DType> *> getInputs() const override { return {input}; }
 		std::vector<Layer<DType> *> getOutputs() const override { return outputs; }
 
 	  private:
 		void computeActivation(Tensor<float> &tensor) {
 			/*Iterate through each all elements.    */
-			const size_t nrElements = tensor.getNrElements();
-
-#pragma omp parallel shared(tensor)
-			for (size_t i = 0; i < nrElements; i++) {
-				tensor.getValue<DType>(i) = Ritsu::computeSwish(tensor.getValue<DType>(i), this->beta);
-			}
+			const TensorSpan<DType> data = tensor.span();
+			const SizeType nrElements = data.size();
+
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					data[i] = Ritsu::computeSwish(data[i], this->beta);
+				}
+			});
 		}
 
 	  private:
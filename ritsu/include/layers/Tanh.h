@@ -51,6 +51,14 @@ namespace Ritsu {
 			return output;
 		}
 
+		void callBatch(const Tensor<DType> &batch, Tensor<DType> &output, bool training) override {
+			Layer::reserveBatch(output, this->getBatchShape(batch.getShape()[0]));
+			output.assign(batch);
+			this->computeActivation(output);
+		}
+
+		bool supports_inplace() const noexcept override { return true; }
+
 		void build(const Shape<IndexType> &shape) override { this->shape = shape; }
 
 		void setOutputs(const std::vector<Layer<DType> *> &layers) override {
@@ -58,7 +66,10 @@ namespace Ritsu {
 			this->outputs = layers;
 		}
 
-		void setInputs(const std::vector<Layer<DType> *> &layers) override { this->input = layers[0]; }
+		void setInputs(const std::vector<Layer<DType> *> &layers) override {
+			this->shape = layers[0]->getShape();
+			this->input = layers[0];
+		}
 
 		Tensor<float> compute_derivative(const Tensor<float> &tensor) override {
 			Tensor<float> output = tensor;
@@ -70,28 +81,29 @@ namespace Ritsu {
 			return tensor;
 		}
 
+		ActivationFunction getFusedFunction() const noexcept override { return ActivationFunction::Tanh; }
+
 		std::vector<Layer<DType> *> getInputs() const override { return {input}; }
 		std::vector<Layer<DType> *> getOutputs() const override { return outputs; }
 
 	  protected:
 		static void computeDerivative(Tensor<float> &output) {
 			/*Iterate through each all elements.    */
-			const size_t nrElements = output.getNrElements();
-
-#pragma omp parallel shared(output)
-			for (size_t i = 0; i < nrElements; i++) {
-				output.getValue<DType>(i) = Ritsu::computeTanh(output.getValue<DType>(i));
-			}
+			const TensorSpan<DType> data = output.span();
+			const SizeType nrElements = data.size();
+
+			CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+#pragma omp simd
+				for (size_t i = begin; i < end; i++) {
+					data[i] = Ritsu::computeTanhDerivative(data[i]);
+				}
+			});
 		}
 
 		void computeActivation(Tensor<float> &tensor) {
 			/*Iterate through each all elements.    */
 			const size_t nrElements = tensor.getNrElements();
-
-#pragma omp parallel shared(tensor)
-			for (size_t i = 0; i < nrElements; i++) {
-				tensor.getValue<DType>(i) = Ritsu::computeTanh(tensor.getValue<DType>(i));
-			}
+			Ritsu::computeTanh<DType>(tensor.getRawData(), nrElements);
 		}
 
 	  private:
@@ -44,21 +44,22 @@ namespace Ritsu {
 			const size_t uid = variable.getUID();
 			/*	Init */
 			if (m_dw.find(uid) == m_dw.end()) {
+				/*	Optimizer state outlives any arena scope.	*/
+				ScopedAllocator persistent(nullptr);
 				m_dw[uid] = Tensor<T>::zero(variable.getShape());
 				v_dw[uid] = Tensor<T>::zero(variable.getShape());
 			}
 
-			/*	*/
-			m_dw[uid] = (this->m_dw[uid] * this->beta_1) + gradient * (1 - this->beta_1);
-			v_dw[uid] = (this->v_dw[uid] * this->beta_2) + (gradient * gradient) * (1 - this->beta_2);
+			Tensor<T> &m_dw_uid = this->m_dw[uid];
+			Tensor<T> &v_dw_uid = this->v_dw[uid];
 
-			/*	*/
-			Tensor<T> m_dw_corr = this->m_dw[uid];
-			Tensor<T> v_dw_corr = this->v_dw[uid];
+			/*	Each statement is evaluated in a single fused pass, without temporaries.	*/
+			m_dw_uid = lazy(m_dw_uid) * this->beta_1 + lazy(gradient) * (1 - this->beta_1);
+			v_dw_uid = lazy(v_dw_uid) * this->beta_2 + lazy(gradient) * lazy(gradient) * (1 - this->beta_2);
 
-			Tensor<T> gradient_update =
-				(m_dw_corr / (v_dw_corr.sqrt() + this->epsilon)) * gradient * -this->getLearningRate();
-			this->apply_gradients(gradient_update, variable);
+			/*	Same as apply_gradients, but with the update computed in-place.	*/
+			variable +=
+				lazy(m_dw_uid) / (lazy(v_dw_uid).sqrt() + this->epsilon) * lazy(gradient) * -this->getLearningRate();
 		}
 
 		/**
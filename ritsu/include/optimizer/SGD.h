@@ -45,6 +45,8 @@ namespace Ritsu {
 
 				const size_t uid = variable.getUID();
 				if (velocities.find(uid) == velocities.end()) {
+					/*	Optimizer state outlives any arena scope.	*/
+					ScopedAllocator persistent(nullptr);
 					velocities[uid] = Tensor<T>::zero(variable.getShape());
 				}
 
@@ -0,0 +1,123 @@
+#include "Tensor.h"
+#include "core/AxisReduce.h"
+#include <gtest/gtest.h>
+#include <tuple>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace Ritsu;
+
+using Reduce = AxisReduce<unsigned int>;
+
+class AxisReduceTest : public ::testing::TestWithParam<std::tuple<std::vector<unsigned int>, int>> {};
+
+TEST_P(AxisReduceTest, MatchReference) {
+	const auto [dims, axis] = GetParam();
+	const Shape<unsigned int> shape(dims);
+	const Reduce::Layout layout = Reduce::computeLayout(shape, axis);
+
+	std::vector<float> input(shape.getNrElements());
+	for (size_t i = 0; i < input.size(); i++) {
+		input[i] = static_cast<float>(static_cast<int>(i * 7919 % 2003) - 1001) / 97.0f;
+	}
+
+	/*	Reference in double precision, one output at a time.	*/
+	const size_t nrOutputs = layout.outer * layout.inner;
+	std::vector<double> expectedMean(nrOutputs), expectedVariance(nrOutputs);
+	for (size_t outer = 0; outer < layout.outer; outer++) {
+		for (size_t inner = 0; inner < layout.inner; inner++) {
+			double sum = 0;
+			for (size_t k = 0; k < layout.dim; k++) {
+				sum += input[(outer * layout.dim + k) * layout.inner + inner];
+			}
+			const double mean = sum / layout.dim;
+			double m2 = 0;
+			for (size_t k = 0; k < layout.dim; k++) {
+				const double deviation = input[(outer * layout.dim + k) * layout.inner + inner] - mean;
+				m2 += deviation * deviation;
+			}
+			expectedMean[outer * layout.inner + inner] = mean;
+			expectedVariance[outer * layout.inner + inner] = m2 / (layout.dim - 1);
+		}
+	}
+
+	std::vector<float> sum(nrOutputs), mean(nrOutputs), variance(nrOutputs);
+	Reduce::sum<float>(input.data(), sum.data(), layout);
+	Reduce::mean<float>(input.data(), mean.data(), layout);
+	Reduce::variance<float>(input.data(), mean.data(), variance.data(), layout);
+
+	for (size_t i = 0; i < nrOutputs; i++) {
+		ASSERT_NEAR(sum[i], expectedMean[i] * layout.dim, 1e-5 * layout.dim * 10.0) << i;
+		ASSERT_NEAR(mean[i], expectedMean[i], 1e-4) << i;
+		ASSERT_NEAR(variance[i], expectedVariance[i], 1e-4 * expectedVariance[i]) << i;
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(
+	AxisReduce, AxisReduceTest,
+	::testing::Values(std::make_tuple(std::vector<unsigned int>{1000}, 0),
+					  std::make_tuple(std::vector<unsigned int>{32, 10}, 0),
+					  std::make_tuple(std::vector<unsigned int>{32, 10}, 1),
+					  std::make_tuple(std::vector<unsigned int>{32, 10}, -1),
+					  std::make_tuple(std::vector<unsigned int>{4, 5, 6, 7}, 1),
+					  std::make_tuple(std::vector<unsigned int>{4, 5, 6, 7}, 2),
+					  std::make_tuple(std::vector<unsigned int>{3, 50000}, 1),
+					  std::make_tuple(std::vector<unsigned int>{100000, 3}, 0),
+					  std::make_tuple(std::vector<unsigned int>{3000, 1100}, 0),
+					  std::make_tuple(std::vector<unsigned int>{2, 3000, 70}, 1)));
+
+TEST(AxisReduce, Layout) {
+	const Shape<unsigned int> shape({2, 3, 4, 5});
+
+	const Reduce::Layout layout = Reduce::computeLayout(shape, 2);
+	EXPECT_EQ(layout.outer, 6u);
+	EXPECT_EQ(layout.dim, 4u);
+	EXPECT_EQ(layout.inner, 5u);
+
+	EXPECT_EQ(Reduce::computeShape(shape, 2), Shape<unsigned int>({2, 3, 1, 5}));
+	EXPECT_EQ(Reduce::computeShape(shape, -1), Shape<unsigned int>({2, 3, 4, 1}));
+	EXPECT_THROW(Reduce::computeLayout(shape, 4), InvalidArgumentException);
+	EXPECT_THROW(Reduce::computeLayout(shape, -5), InvalidArgumentException);
+}
+
+TEST(AxisReduce, Integer) {
+	const Shape<unsigned int> shape({3, 4});
+	const std::vector<int32_t> input = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+
+	std::vector<int32_t> rows(3), columns(4);
+	Reduce::sum<int32_t>(input.data(), rows.data(), Reduce::computeLayout(shape, 1));
+	Reduce::mean<int32_t>(input.data(), columns.data(), Reduce::computeLayout(shape, 0));
+
+	EXPECT_EQ(rows, std::vector<int32_t>({10, 26, 42}));
+	EXPECT_EQ(columns, std::vector<int32_t>({5, 6, 7, 8}));
+}
+
+#ifdef _OPENMP
+TEST(AxisReduce, IndependentOfThreads) {
+	const std::vector<std::tuple<Shape<unsigned int>, int>> cases = {
+		{Shape<unsigned int>({3, 50000}), 1}, {Shape<unsigned int>({100000, 3}), 0}, {Shape<unsigned int>({512, 700}), 1}};
+
+	for (const auto &[shape, axis] : cases) {
+		const Reduce::Layout layout = Reduce::computeLayout(shape, axis);
+		std::vector<float> input(shape.getNrElements());
+		for (size_t i = 0; i < input.size(); i++) {
+			input[i] = static_cast<float>((i * 2654435761u) % 1000) * 0.001f + 100.0f;
+		}
+
+		const int nrThreads = omp_get_max_threads();
+		std::vector<float> expected(layout.outer * layout.inner);
+		omp_set_num_threads(1);
+		Reduce::sum<float>(input.data(), expected.data(), layout);
+
+		for (const int threads : {2, 3, 4, 7}) {
+			omp_set_num_threads(threads);
+			std::vector<float> result(expected.size());
+			Reduce::sum<float>(input.data(), result.data(), layout);
+			EXPECT_EQ(result, expected) << threads;
+		}
+		omp_set_num_threads(nrThreads);
+	}
+}
+#endif
@@ -0,0 +1,228 @@
+#include "Activations.h"
+#include "Math.h"
+#include "core/CpuDispatch.h"
+#include "core/Gemm.h"
+#include <gtest/gtest.h>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using namespace Ritsu;
+
+static const CpuTier tiers[] = {CpuTier::Generic, CpuTier::SSE42, CpuTier::AVX2, CpuTier::AVX512, CpuTier::NEON};
+
+TEST(CpuDispatch, TierName) {
+	for (const CpuTier tier : tiers) {
+		ASSERT_EQ(CpuDispatch::parseTier(CpuDispatch::getTierName(tier)), tier);
+	}
+	ASSERT_THROW(CpuDispatch::parseTier("mmx"), InvalidArgumentException);
+}
+
+TEST(CpuDispatch, SetTier) {
+	ASSERT_TRUE(CpuDispatch::isSupported(CpuTier::Generic));
+	ASSERT_TRUE(CpuDispatch::isSupported(CpuDispatch::getDetectedTier()));
+
+	for (const CpuTier tier : tiers) {
+		if (CpuDispatch::isSupported(tier)) {
+			ASSERT_NO_THROW(CpuDispatch::setTier(tier));
+			ASSERT_EQ(CpuDispatch::getTier(), tier);
+		} else {
+			ASSERT_THROW(CpuDispatch::setTier(tier), NotSupportedException);
+		}
+	}
+
+	CpuDispatch::resetTier();
+	ASSERT_EQ(CpuDispatch::getTier(), CpuDispatch::getDetectedTier());
+}
+
+TEST(CpuDispatch, TiersMatchGeneric) {
+	const size_t nrElements = 10007;
+	std::vector<float> values(nrElements);
+	for (size_t i = 0; i < nrElements; i++) {
+		values[i] = static_cast<float>(static_cast<int>(i * 7919 % 2003) - 1001) / 97.0f;
+	}
+
+	const size_t M = 37, N = 45, K = 300;
+	std::vector<float> A(M * K), B(K * N);
+	for (size_t i = 0; i < A.size(); i++) {
+		A[i] = values[i % nrElements];
+	}
+	for (size_t i = 0; i < B.size(); i++) {
+		B[i] = values[(i * 3) % nrElements];
+	}
+
+	struct Result {
+		float sum;
+		float dot;
+		std::vector<float> relu;
+		std::vector<float> sigmoid;
+		std::vector<float> product;
+	};
+
+	const auto compute = [&]() {
+		Result result;
+		result.sum = Math::sum<float>(values.data(), nrElements);
+		result.dot = Math::dot<float>(values.data(), values.data(), nrElements);
+
+		result.relu = values;
+		Ritsu::relu<float>(result.relu.data(), nrElements);
+		result.sigmoid = values;
+		Ritsu::computeSigmoid<float>(result.sigmoid.data(), nrElements);
+
+		result.product.resize(M * N);
+		Gemm::gemm<float>(M, N, K, 1.0f, A.data(), K, 1, B.data(), N, 1, 0.0f, result.product.data(), N, 1);
+		return result;
+	};
+
+	CpuDispatch::setTier(CpuTier::Generic);
+	const Result expected = compute();
+
+	for (const CpuTier tier : tiers) {
+		if (!CpuDispatch::isSupported(tier)) {
+			continue;
+		}
+		CpuDispatch::setTier(tier);
+		const Result result = compute();
+
+		/*	The order of the additions does not depend on the tier.	*/
+		EXPECT_EQ(result.sum, expected.sum) << CpuDispatch::getTierName(tier);
+		EXPECT_NEAR(result.dot, expected.dot, 1e-5f * expected.dot) << CpuDispatch::getTierName(tier);
+		for (size_t i = 0; i < nrElements; i++) {
+			ASSERT_EQ(result.relu[i], expected.relu[i]) << CpuDispatch::getTierName(tier);
+			ASSERT_NEAR(result.sigmoid[i], expected.sigmoid[i], 1e-6f) << CpuDispatch::getTierName(tier);
+		}
+		/*	Fused multiply-add rounds differently.	*/
+		for (size_t i = 0; i < M * N; i++) {
+			ASSERT_NEAR(result.product[i], expected.product[i], 1e-3f) << CpuDispatch::getTierName(tier);
+		}
+	}
+
+	CpuDispatch::resetTier();
+}
+
+TEST(CpuDispatch, GemmPackedMatchUnpacked) {
+	/*	K spans more than one slice of the packed product.	*/
+	const size_t M = 37, N = 45, K = 300;
+	std::vector<float> A(M * K), B(K * N);
+	for (size_t i = 0; i < A.size(); i++) {
+		A[i] = static_cast<float>(static_cast<int>(i * 7919 % 2003) - 1001) / 97.0f;
+	}
+	for (size_t i = 0; i < B.size(); i++) {
+		B[i] = static_cast<float>(static_cast<int>(i * 104729 % 1009) - 504) / 53.0f;
+	}
+
+	GemmPackedB<float> packedB;
+	for (const CpuTier tier : tiers) {
+		if (!CpuDispatch::isSupported(tier)) {
+			continue;
+		}
+		CpuDispatch::setTier(tier);
+
+		std::vector<float> expected(M * N), result(M * N), row(N);
+		Gemm::gemm<float>(M, N, K, 1.0f, A.data(), K, 1, B.data(), N, 1, 0.0f, expected.data(), N, 1);
+
+		/*	Packed for the previous tier, which may have other panels.	*/
+		if (packedB.source != nullptr) {
+			Gemm::gemm<float>(M, 1.0f, A.data(), K, 1, packedB, 0.0f, result.data(), N, 1);
+			for (size_t i = 0; i < M * N; i++) {
+				ASSERT_NEAR(result[i], expected[i], 1e-3f) << CpuDispatch::getTierName(tier);
+			}
+		}
+
+		Gemm::pack<float>(K, N, B.data(), N, 1, packedB);
+		ASSERT_TRUE(Gemm::isPacked(packedB, K, N, B.data(), N, 1));
+		ASSERT_FALSE(Gemm::isPacked(packedB, K, N, A.data(), N, 1));
+
+		/*	The same panels as packed by the product itself.	*/
+		Gemm::gemm<float>(M, 1.0f, A.data(), K, 1, packedB, 0.0f, result.data(), N, 1);
+		for (size_t i = 0; i < M * N; i++) {
+			ASSERT_EQ(result[i], expected[i]) << CpuDispatch::getTierName(tier);
+		}
+
+		/*	A single row is a matrix vector product of the source.	*/
+		Gemm::gemm<float>(1, 1.0f, A.data(), K, 1, packedB, 0.0f, row.data(), N, 1);
+		for (size_t j = 0; j < N; j++) {
+			ASSERT_NEAR(row[j], expected[j], 1e-3f) << CpuDispatch::getTierName(tier);
+		}
+	}
+
+	packedB.clear();
+	ASSERT_FALSE(Gemm::isPacked(packedB, K, N, B.data(), N, 1));
+
+	CpuDispatch::resetTier();
+}
+
+static std::vector<std::pair<ExecutionPath, size_t>> reportedPaths;
+static void recordPath(const ExecutionPath path, const size_t nrElements) { reportedPaths.emplace_back(path, nrElements); }
+
+TEST(CpuDispatch, ExecutionPath) {
+	ASSERT_STREQ(CpuDispatch::getPathName(ExecutionPath::Serial), "serial");
+	ASSERT_STREQ(CpuDispatch::getPathName(ExecutionPath::Simd), "simd");
+	ASSERT_STREQ(CpuDispatch::getPathName(ExecutionPath::Threaded), "threaded");
+
+	const size_t threshold = 4 * CpuDispatch::BlockSize;
+	CpuDispatch::setParallelThreshold(threshold);
+	ASSERT_EQ(CpuDispatch::getParallelThreshold(), threshold);
+
+	const ExecutionPath expectedThreaded =
+		CpuDispatch::getNrThreads() > 1 ? ExecutionPath::Threaded : ExecutionPath::Simd;
+
+	std::vector<float> values(threshold, 1.0f);
+	reportedPaths.clear();
+	CpuDispatch::setProfilerHook(recordPath);
+
+	for (const size_t nrElements : {static_cast<size_t>(10), threshold - 1, threshold}) {
+		CpuDispatch::parallelFor(nrElements, [&](const size_t begin, const size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				values[i] *= 2.0f;
+			}
+		});
+	}
+	CpuDispatch::setProfilerHook(nullptr);
+	CpuDispatch::parallelFor(10, [](const size_t, const size_t) {});
+
+	ASSERT_EQ(reportedPaths.size(), 3u);
+	EXPECT_EQ(reportedPaths[0], std::make_pair(ExecutionPath::Serial, static_cast<size_t>(10)));
+	EXPECT_EQ(reportedPaths[1], std::make_pair(ExecutionPath::Simd, threshold - 1));
+	EXPECT_EQ(reportedPaths[2], std::make_pair(expectedThreaded, threshold));
+	EXPECT_EQ(values[0], 8.0f);
+	EXPECT_EQ(values[threshold - 1], 2.0f);
+
+	/*	Nested in an OpenMP parallel region, the calling thread runs the whole range.	*/
+#ifdef _OPENMP
+	if (CpuDispatch::getThreadPool() == nullptr) {
+#pragma omp parallel num_threads(2)
+		{
+#pragma omp master
+			EXPECT_EQ(CpuDispatch::getPath(threshold), ExecutionPath::Simd);
+		}
+	}
+#endif
+
+	CpuDispatch::resetParallelThreshold();
+	ASSERT_GT(CpuDispatch::getParallelThreshold(), CpuDispatch::BlockSize);
+}
+
+TEST(CpuDispatch, PathsMatch) {
+	const size_t nrElements = 100003;
+	std::vector<float> values(nrElements);
+	for (size_t i = 0; i < nrElements; i++) {
+		values[i] = static_cast<float>(static_cast<int>(i * 7919 % 2003) - 1001) / 97.0f;
+	}
+
+	/*	All threaded, and all on the calling thread.	*/
+	CpuDispatch::setParallelThreshold(1);
+	const float threadedSum = Math::sum<float>(values.data(), nrElements);
+	std::vector<float> threadedRelu = values;
+	Ritsu::relu<float>(threadedRelu.data(), nrElements);
+
+	CpuDispatch::setParallelThreshold(std::numeric_limits<size_t>::max());
+	const float simdSum = Math::sum<float>(values.data(), nrElements);
+	std::vector<float> simdRelu = values;
+	Ritsu::relu<float>(simdRelu.data(), nrElements);
+
+	CpuDispatch::resetParallelThreshold();
+
+	EXPECT_EQ(threadedSum, simdSum);
+	EXPECT_EQ(threadedRelu, simdRelu);
+}
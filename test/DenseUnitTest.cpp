@@ -85,6 +85,187 @@ TEST_P(DenseComputeTest, ResultShape) {
 	ASSERT_EQ(result0.getShape(), expected);
 }
 
+TEST_P(DenseComputeTest, BatchMatchSample) {
+
+	auto [xUnit, denseUnit, expected] = GetParam();
+	const uint32_t batchSize = 7;
+
+	Input input({xUnit});
+	Dense dense(denseUnit, true, RandomUniformInitializer<float>(-1.0, 1.0), RandomUniformInitializer<float>(-1.0, 1.0));
+
+	Layer<float> &output = dense(input); /*	Build the weight.	*/
+	output.build(dense.getInputs()[0]->getShape());
+
+	Tensor<float> batch({batchSize, xUnit});
+	RandomUniformInitializer<float>(-1.0, 1.0).set(batch);
+
+	Tensor<float> batchResult;
+	dense.callBatch(batch, batchResult, false);
+	ASSERT_EQ(batchResult.getShape(), Ritsu::Shape<uint32_t>({batchSize, denseUnit}));
+
+	for (uint32_t b = 0; b < batchSize; b++) {
+		Tensor<float> sample = batch.getSubset({{b}});
+		sample.reduce();
+
+		const Tensor<float> sampleResult = dense.call(static_cast<const Tensor<float> &>(sample), false);
+		for (uint32_t i = 0; i < denseUnit; i++) {
+			ASSERT_NEAR(batchResult.getValue<float>(b * denseUnit + i), sampleResult.getValue<float>(i), 1e-4f);
+		}
+	}
+}
+
+TEST_P(DenseComputeTest, FusedMatchActivation) {
+
+	auto [xUnit, denseUnit, expected] = GetParam();
+
+	Input input({xUnit});
+	Dense dense(denseUnit, true, RandomUniformInitializer<float>(-1.0, 1.0), RandomUniformInitializer<float>(-1.0, 1.0));
+
+	Layer<float> &output = dense(input); /*	Build the weight.	*/
+	output.build(dense.getInputs()[0]->getShape());
+
+	Relu relu;
+	Sigmoid sigmoid;
+	Tanh tanh;
+	Swish swish(1.5f);
+
+	/*	Single sample is a matrix vector product, the batch the packed product.	*/
+	for (const uint32_t batchSize : {1u, 7u}) {
+		Tensor<float> batch({batchSize, xUnit});
+		RandomUniformInitializer<float>(-1.0, 1.0).set(batch);
+
+		for (Activation *activation : std::initializer_list<Activation *>{&relu, &sigmoid, &tanh, &swish}) {
+			(*activation)(dense);
+
+			Tensor<float> denseResult;
+			Tensor<float> expectedResult;
+			dense.callBatch(batch, denseResult, false);
+			activation->callBatch(denseResult, expectedResult, false);
+
+			Tensor<float> fusedResult;
+			dense.callBatchFused(batch, fusedResult, activation->getFusedFunction(),
+								 activation->getFusedParameter());
+			ASSERT_EQ(fusedResult.getShape(), expectedResult.getShape());
+
+			for (uint32_t i = 0; i < fusedResult.getNrElements(); i++) {
+				ASSERT_NEAR(fusedResult.getValue<float>(i), expectedResult.getValue<float>(i), 1e-5f)
+					<< activation->getName() << " " << batchSize;
+			}
+		}
+	}
+}
+
+TEST_P(DenseComputeTest, PackedWeightFollowUpdate) {
+
+	auto [xUnit, denseUnit, expected] = GetParam();
+	const uint32_t batchSize = 7;
+
+	Input input({xUnit});
+	Dense dense(denseUnit, true, RandomUniformInitializer<float>(-1.0, 1.0), RandomUniformInitializer<float>(-1.0, 1.0));
+
+	Layer<float> &output = dense(input); /*	Build the weight.	*/
+	output.build(dense.getInputs()[0]->getShape());
+
+	const std::vector<Tensor<float> *> variables = dense.getTrainableWeights().value();
+	Tensor<float> &weight = *variables[0];
+	const Tensor<float> &bias = *variables[1];
+
+	Tensor<float> batch({batchSize, xUnit});
+	RandomUniformInitializer<float>(-1.0, 1.0).set(batch);
+
+	Tensor<float> result;
+	dense.callBatch(batch, result, false);
+
+	/*	Modified in place, as by the optimizer.	*/
+	weight *= 2.0f;
+	dense.weights_updated();
+
+	Tensor<float> updatedResult;
+	dense.callBatch(batch, updatedResult, false);
+
+	for (uint32_t b = 0; b < batchSize; b++) {
+		for (uint32_t i = 0; i < denseUnit; i++) {
+			const float biasValue = bias.getValue<float>(i);
+			const float expectedValue = 2.0f * (result.getValue<float>(b * denseUnit + i) - biasValue) + biasValue;
+			ASSERT_NEAR(updatedResult.getValue<float>(b * denseUnit + i), expectedValue, 1e-3f);
+		}
+	}
+}
+
+TEST_P(DenseComputeTest, DerivativeMatchTranspose) {
+
+	auto [xUnit, denseUnit, expected] = GetParam();
+
+	Input input({xUnit});
+	Dense dense(denseUnit, true, RandomUniformInitializer<float>(-1.0, 1.0));
+
+	Layer<float> &output = dense(input); /*	Build the weight.	*/
+	output.build(dense.getInputs()[0]->getShape());
+
+	const Tensor<float> weight = *dense.getTrainableWeights().value()[0];
+
+	for (const uint32_t batchSize : {1u, 7u}) {
+		Tensor<float> value({denseUnit, batchSize});
+		RandomUniformInitializer<float>(-1.0, 1.0).set(value);
+
+		const Tensor<float> expectedResult = weight.transpose().dot(value);
+		const Tensor<float> result = dense.compute_derivative(static_cast<const Tensor<float> &>(value));
+		ASSERT_EQ(result.getShape(), expectedResult.getShape());
+
+		/*	In place, the product is computed before the output is replaced.	*/
+		Tensor<float> inplace = value;
+		static_cast<const Dense &>(dense).compute_derivative(inplace);
+		ASSERT_EQ(inplace.getShape(), expectedResult.getShape());
+
+		for (uint32_t i = 0; i < expectedResult.getNrElements(); i++) {
+			ASSERT_NEAR(result.getValue<float>(i), expectedResult.getValue<float>(i), 1e-4f) << batchSize;
+			ASSERT_NEAR(inplace.getValue<float>(i), expectedResult.getValue<float>(i), 1e-4f) << batchSize;
+		}
+	}
+}
+
+TEST_P(DenseComputeTest, AccumulateGradientsMatchComputeGradient) {
+
+	auto [xUnit, denseUnit, expected] = GetParam();
+	const uint32_t batchSize = 7;
+	const float scale = 1.0f / batchSize;
+
+	Input input({xUnit});
+	Dense dense(denseUnit, true, RandomUniformInitializer<float>(-1.0, 1.0));
+
+	Layer<float> &output = dense(input); /*	Build the weight.	*/
+	output.build(dense.getInputs()[0]->getShape());
+
+	Tensor<float> deriv_z({denseUnit, batchSize});
+	Tensor<float> Q({xUnit, batchSize});
+	RandomUniformInitializer<float>(-1.0, 1.0).set(deriv_z);
+	RandomUniformInitializer<float>(-1.0, 1.0).set(Q);
+
+	std::vector<Tensor<float> *> gradients = dense.accumulate_gradients(deriv_z, Q, scale, false).value();
+	ASSERT_EQ(gradients.size(), 2u);
+
+	for (uint32_t i_var = 0; i_var < gradients.size(); i_var++) {
+		Tensor<float> expectedGradient = dense.compute_gradient(i_var, deriv_z, Q);
+		expectedGradient *= scale;
+
+		ASSERT_EQ(gradients[i_var]->getNrElements(), expectedGradient.getNrElements());
+		for (uint32_t i = 0; i < expectedGradient.getNrElements(); i++) {
+			ASSERT_NEAR(gradients[i_var]->getValue<float>(i), expectedGradient.getValue<float>(i), 1e-5f) << i_var;
+		}
+	}
+
+	/*	Two more batches added onto the same buffers.	*/
+	const std::vector<Tensor<float>> first = {*gradients[0], *gradients[1]};
+	dense.accumulate_gradients(deriv_z, Q, scale, true);
+	gradients = dense.accumulate_gradients(deriv_z, Q, scale, true).value();
+
+	for (uint32_t i_var = 0; i_var < gradients.size(); i_var++) {
+		for (uint32_t i = 0; i < first[i_var].getNrElements(); i++) {
+			ASSERT_NEAR(gradients[i_var]->getValue<float>(i), 3.0f * first[i_var].getValue<float>(i), 1e-4f) << i_var;
+		}
+	}
+}
+
 INSTANTIATE_TEST_SUITE_P(Dense, DenseComputeTest,
 						 ::testing::Values(std::make_tuple(16, 32, Ritsu::Shape<uint32_t>({32, 1})),
 										   std::make_tuple(32, 32, Ritsu::Shape<uint32_t>({32, 1})),
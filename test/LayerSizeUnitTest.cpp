@@ -46,6 +46,25 @@ TEST_P(LayerUniformShapeSizeTest, ReluLayerShapeSize) {
 	ASSERT_EQ(relu.getShape(), expected);
 }
 
+TEST_P(LayerUniformShapeSizeTest, ReluLayerBatchShapeSize) {
+	auto [expected] = GetParam();
+
+	Ritsu::Input input(expected);
+	Ritsu::Relu relu;
+	relu(input);
+	relu.build(input.getShape());
+
+	const uint32_t batchSize = 4;
+	Tensor<float> batch(relu.getBatchShape(batchSize));
+	batch.assignInitValue(-1.0f);
+
+	Tensor<float> output;
+	relu.callBatch(batch, output, false);
+
+	ASSERT_EQ(output.getShape(), relu.getBatchShape(batchSize));
+	ASSERT_EQ(output, Tensor<float>::zero(output.getShape()));
+}
+
 TEST_P(LayerUniformShapeSizeTest, LeakyReluLayerShapeSize) {
 	auto [expected] = GetParam();
 
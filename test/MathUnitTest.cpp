@@ -181,4 +181,90 @@ INSTANTIATE_TEST_SUITE_P(Math, StandardDeviationTest,
 										   std::make_tuple(std::vector<float>({-10, 20, -15, 20, 2, -100}),
 														   44.678481f)));
 
+class MeanVarianceTest : public ::testing::TestWithParam<std::tuple<std::vector<float>, float, float>> {};
+
+TEST_P(MeanVarianceTest, Values) {
+	auto [x, expectedMean, expectedVariance] = GetParam();
+
+	float mean, variance;
+	Math::meanVariance<float>(x, mean, variance);
+
+	EXPECT_FLOAT_EQ(mean, expectedMean);
+	EXPECT_FLOAT_EQ(variance, expectedVariance);
+}
+INSTANTIATE_TEST_SUITE_P(Math, MeanVarianceTest,
+						 ::testing::Values(std::make_tuple(std::vector<float>({1, 2, 3, 4, 5, 5, 5}), 3.5714285f,
+														   2.6190476f),
+										   std::make_tuple(std::vector<float>({-10, 20, -15, 20, 2, -100}), -13.833333f,
+														   1996.1667f)));
+
+TEST(Math, MeanVarianceLargeOffset) {
+	/*	Many blocks of values with a mean far from zero, where the sum of squares loses all precision.	*/
+	std::vector<float> values(1000003);
+	for (size_t i = 0; i < values.size(); i++) {
+		values[i] = 10000.0f + static_cast<float>(static_cast<int>(i % 7) - 3) * 0.01f;
+	}
+
+	double expectedMean = 0;
+	for (const float value : values) {
+		expectedMean += value;
+	}
+	expectedMean /= static_cast<double>(values.size());
+	double expectedVariance = 0;
+	for (const float value : values) {
+		expectedVariance += (value - expectedMean) * (value - expectedMean);
+	}
+	expectedVariance /= static_cast<double>(values.size() - 1);
+
+	float mean, variance;
+	Math::meanVariance<float>(values, mean, variance);
+
+	EXPECT_NEAR(mean, expectedMean, 1e-6 * expectedMean);
+	EXPECT_NEAR(variance, expectedVariance, 1e-3 * expectedVariance);
+}
+
+TEST(Math, ReductionIndependentOfThreads) {
+	std::vector<float> values(3 * 100003);
+	for (size_t i = 0; i < values.size(); i++) {
+		values[i] = static_cast<float>(static_cast<int>(i * 7919 % 2003) - 1001) / 97.0f;
+	}
+
+	struct Result {
+		float sum, dot, mean, variance;
+	};
+	const auto compute = [&]() {
+		Result result;
+		result.sum = Math::sum<float>(values);
+		result.dot = Math::dot<float>(values.data(), values.data(), values.size());
+		Math::meanVariance<float>(values, result.mean, result.variance);
+		return result;
+	};
+
+#ifdef _OPENMP
+	const int nrThreads = omp_get_max_threads();
+	omp_set_num_threads(1);
+#endif
+	const Result expected = compute();
+
+#ifdef _OPENMP
+	for (const int threads : {2, 3, 4, 7}) {
+		omp_set_num_threads(threads);
+		const Result result = compute();
+
+		/*	Bitwise equal, the blocks and the order they are combined in do not depend on the threads.	*/
+		EXPECT_EQ(result.sum, expected.sum) << threads;
+		EXPECT_EQ(result.dot, expected.dot) << threads;
+		EXPECT_EQ(result.mean, expected.mean) << threads;
+		EXPECT_EQ(result.variance, expected.variance) << threads;
+	}
+	omp_set_num_threads(nrThreads);
+#endif
+
+	double sum = 0;
+	for (const float value : values) {
+		sum += value;
+	}
+	EXPECT_NEAR(expected.sum, sum, 1e-2);
+}
+
 // covariance
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "core/MemoryPlanner.h"
+#include <gtest/gtest.h>
+
+using namespace Ritsu;
+
+TEST(MemoryPlanner, DisjointLifetimeShareMemory) {
+	MemoryPlanner planner(64);
+
+	const size_t a = planner.addBuffer(1024, 0, 1);
+	const size_t b = planner.addBuffer(1024, 1, 2);
+	const size_t c = planner.addBuffer(1024, 2, 3);
+
+	ASSERT_EQ(planner.plan(), 2048);
+	EXPECT_EQ(planner.getTotalSize(), 3072);
+
+	/*	a and c are never alive at the same time.	*/
+	EXPECT_EQ(planner.getOffset(a), planner.getOffset(c));
+	EXPECT_NE(planner.getOffset(a), planner.getOffset(b));
+}
+
+TEST(MemoryPlanner, OverlappingLifetimeDoNotOverlapMemory) {
+	MemoryPlanner planner(64);
+
+	const size_t sizes[] = {100, 4000, 64, 777, 2048};
+	for (size_t i = 0; i < 5; i++) {
+		planner.addBuffer(sizes[i], 0, 4);
+	}
+	const size_t arenaSize = planner.plan();
+
+	for (size_t i = 0; i < 5; i++) {
+		EXPECT_EQ(planner.getOffset(i) % 64, 0);
+		EXPECT_LE(planner.getOffset(i) + planner.getSize(i), arenaSize);
+		for (size_t j = i + 1; j < 5; j++) {
+			const bool disjoint = planner.getOffset(i) + planner.getSize(i) <= planner.getOffset(j) ||
+								  planner.getOffset(j) + planner.getSize(j) <= planner.getOffset(i);
+			EXPECT_TRUE(disjoint);
+		}
+	}
+}
+
+TEST(MemoryPlanner, ExtendLifetime) {
+	MemoryPlanner planner(64);
+
+	const size_t a = planner.addBuffer(512, 0, 1);
+	planner.extend(a, 3);
+	const size_t b = planner.addBuffer(512, 2, 3);
+
+	planner.plan();
+	EXPECT_NE(planner.getOffset(a), planner.getOffset(b));
+}
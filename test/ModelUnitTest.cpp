@@ -3,6 +3,7 @@
 #include "core/Shape.h"
 #include <Ritsu.h>
 #include <gtest/gtest.h>
+#include <cmath>
 #include <tuple>
 
 using namespace Ritsu;
@@ -122,3 +123,268 @@ TEST(ModelTest, DenseAddition) {
 	// EXPECT_NEAR((*result)["loss"].getValue((*result)["loss"].getNrElements() - 1), 0, 0.2);
 	// EXPECT_NEAR((*result)["accuracy"].getValue((*result)["accuracy"].getNrElements() - 1), 1, 0.01);
 }
+
+TEST(ModelTest, PlannedForwardAllocationFree) {
+
+	Input input({16}, "input");
+	Dense dense0(32);
+	Relu relu;
+	Dense outputDense(4);
+
+	RandomUniformInitializer<float> random(-1, 1, 10052);
+	const Tensor<float> batch = random(Shape<unsigned int>({8, 16}));
+
+	Layer<float> &output = outputDense(relu(dense0(input)));
+	Model<float> forwardModel = Model<float>({&input}, {&output});
+
+	ASSERT_NO_THROW(forwardModel.plan(8));
+	const Tensor<float> expected = forwardModel.predictOnBatch(batch);
+
+	/*	Steady state, all the activation buffers are already allocated.	*/
+	TensorAllocationCounter::reset();
+	const Tensor<float> &result = forwardModel.predictOnBatch(batch);
+	EXPECT_EQ(TensorAllocationCounter::getCount(), 0);
+
+	ASSERT_EQ(result.getShape(), Shape<unsigned int>({8, 4}));
+	for (unsigned int i = 0; i < result.getNrElements(); i++) {
+		EXPECT_FLOAT_EQ(result.getValue(i), expected.getValue(i));
+	}
+}
+
+TEST(ModelTest, PlannedInferenceReuseMemory) {
+
+	Input input({64}, "input");
+	Dense dense0(256);
+	Relu relu0;
+	Dense dense1(256);
+	Relu relu1;
+	Dense outputDense(10);
+
+	RandomUniformInitializer<float> random(-1, 1, 10052);
+	const Tensor<float> batch = random(Shape<unsigned int>({16, 64}));
+
+	Layer<float> &output = outputDense(relu1(dense1(relu0(dense0(input)))));
+	Model<float> forwardModel = Model<float>({&input}, {&output});
+	forwardModel.setLayerFusion(false);
+
+	/*	Inference only keeps the current input and output alive, relu runs in-place.	*/
+	const size_t inference = forwardModel.peakActivationBytes(16, false);
+	const size_t training = forwardModel.peakActivationBytes(16, true);
+	EXPECT_LT(inference, training);
+	EXPECT_LE(inference, 2 * 16 * 256 * sizeof(float));
+	EXPECT_GE(training, 16 * (64 + 4 * 256 + 10) * sizeof(float));
+
+	ASSERT_NO_THROW(forwardModel.plan(16, true));
+	const Tensor<float> expected = forwardModel.predictOnBatch(batch);
+
+	ASSERT_NO_THROW(forwardModel.plan(16, false));
+	const Tensor<float> &result = forwardModel.predictOnBatch(batch);
+
+	ASSERT_EQ(result.getShape(), expected.getShape());
+	for (unsigned int i = 0; i < result.getNrElements(); i++) {
+		EXPECT_FLOAT_EQ(result.getValue(i), expected.getValue(i));
+	}
+}
+
+TEST(ModelTest, FitMomentumStateOutlivesBatch) {
+
+	Input input({4}, "input");
+	Dense dense0(8);
+	Dense outputDense(1);
+
+	RandomUniformInitializer<float> random(-1, 1, 10052);
+	const Tensor<float> dataX = random(Shape<unsigned int>({64, 4}));
+	Tensor<float> dataY({64, 1});
+	for (unsigned int i = 0; i < 64; i++) {
+		dataY.getValue(i) = dataX.getValue({i, 0}) - dataX.getValue({i, 2});
+	}
+
+	Layer<float> &output = outputDense(dense0(input));
+	SGD<float> optimizer(0.001f, 0.9f);
+
+	Model<float> forwardModel = Model<float>({&input}, {&output});
+	MeanSquareError mse_loss = MeanSquareError();
+	forwardModel.compile(&optimizer, mse_loss);
+
+	ASSERT_NO_THROW(forwardModel.fit(2, dataX, dataY, 8, 0, false, false));
+
+	/*	Optimizer state and weights must not refer to released batch memory.	*/
+	const std::vector<Tensor<float> *> variables = dense0.getTrainableWeights().value();
+	for (Tensor<float> *variable : variables) {
+		for (unsigned int i = 0; i < variable->getNrElements(); i++) {
+			ASSERT_TRUE(std::isfinite(variable->getValue(i)));
+		}
+	}
+	const Tensor<float> &result = forwardModel.predictOnBatch(dataX.getSubset({{0, 7}}));
+	for (unsigned int i = 0; i < result.getNrElements(); i++) {
+		ASSERT_TRUE(std::isfinite(result.getValue(i)));
+	}
+}
+
+TEST(ModelTest, LayerFusionInference) {
+
+	Input input({64}, "input");
+	Dense dense0(32);
+	Regularization regularization;
+	Relu relu;
+	Dense dense1(32);
+	Tanh tanh;
+	Dense dense2(16);
+	Swish swish(1.5f);
+	Dense outputDense(10);
+	Sigmoid sigmoid;
+
+	RandomUniformInitializer<float> random(-1, 1, 10052);
+	const Tensor<float> batch = random(Shape<unsigned int>({16, 64}));
+
+	Layer<float> &output =
+		sigmoid(outputDense(swish(dense2(tanh(dense1(relu(regularization(dense0(input)))))))));
+	Model<float> forwardModel = Model<float>({&input}, {&output});
+	ASSERT_TRUE(forwardModel.isLayerFusionEnabled());
+
+	const Tensor<float> fused = forwardModel.predictOnBatch(batch);
+
+	forwardModel.setLayerFusion(false);
+	const Tensor<float> &unfused = forwardModel.predictOnBatch(batch);
+
+	ASSERT_EQ(fused.getShape(), unfused.getShape());
+	for (unsigned int i = 0; i < fused.getNrElements(); i++) {
+		EXPECT_NEAR(fused.getValue(i), unfused.getValue(i), 1e-5f);
+	}
+
+	/*	Training only keeps the output of each fused chain, not the output of the dense layer.	*/
+	const size_t unfusedTraining = forwardModel.peakActivationBytes(16, true);
+	forwardModel.setLayerFusion(true);
+	EXPECT_LT(forwardModel.peakActivationBytes(16, true), unfusedTraining);
+}
+
+/*	Train the same initial weights with and without fusion, the weights must end up the same.	*/
+static void expectFusedTrainingMatch(Activation &activation) {
+
+	Input input({4}, "input");
+	Dense dense0(8, true, RandomUniformInitializer<float>(-1, 1, 42));
+	Dense outputDense(1, true, RandomUniformInitializer<float>(-1, 1, 43));
+
+	RandomUniformInitializer<float> random(-1, 1, 10052);
+	const Tensor<float> dataX = random(Shape<unsigned int>({32, 4}));
+	Tensor<float> dataY({32, 1});
+	for (unsigned int i = 0; i < 32; i++) {
+		dataY.getValue(i) = 0.5f + 0.25f * dataX.getValue({i, 1});
+	}
+
+	Layer<float> &output = activation(outputDense(dense0(input)));
+	SGD<float> optimizer(0.05f, 0.0f);
+
+	Model<float> forwardModel = Model<float>({&input}, {&output});
+	MeanSquareError mse_loss = MeanSquareError();
+	forwardModel.compile(&optimizer, mse_loss);
+
+	std::vector<Tensor<float> *> variables = dense0.getTrainableWeights().value();
+	const std::vector<Tensor<float> *> outputVariables = outputDense.getTrainableWeights().value();
+	variables.insert(variables.end(), outputVariables.begin(), outputVariables.end());
+
+	const auto copyVariables = [&]() {
+		std::vector<Tensor<float>> copies;
+		for (const Tensor<float> *variable : variables) {
+			copies.emplace_back(variable->getShape());
+			copies.back().assign(*variable);
+		}
+		return copies;
+	};
+	const std::vector<Tensor<float>> initial = copyVariables();
+
+	ASSERT_NO_THROW(forwardModel.fit(2, dataX, dataY, 1, 0, false, false));
+	const std::vector<Tensor<float>> fused = copyVariables();
+
+	for (size_t i = 0; i < variables.size(); i++) {
+		variables[i]->assign(initial[i]);
+	}
+	forwardModel.setLayerFusion(false);
+	ASSERT_NO_THROW(forwardModel.fit(2, dataX, dataY, 1, 0, false, false));
+
+	for (size_t i = 0; i < variables.size(); i++) {
+		for (unsigned int j = 0; j < variables[i]->getNrElements(); j++) {
+			ASSERT_NEAR(variables[i]->getValue(j), fused[i].getValue(j), 1e-4f) << activation.getName();
+		}
+	}
+}
+
+TEST(ModelTest, LayerFusionTraining) {
+	Relu relu;
+	Sigmoid sigmoid;
+	Tanh tanh;
+
+	expectFusedTrainingMatch(relu);
+	expectFusedTrainingMatch(sigmoid);
+	expectFusedTrainingMatch(tanh);
+}
+
+TEST(ModelTest, FitGradientAccumulation) {
+
+	Input input({4}, "input");
+	Dense dense0(8, true, RandomUniformInitializer<float>(-1, 1, 42));
+	Dense outputDense(1, true, RandomUniformInitializer<float>(-1, 1, 43));
+
+	RandomUniformInitializer<float> random(-1, 1, 10052);
+	const Tensor<float> dataX = random(Shape<unsigned int>({4, 4}));
+	const Tensor<float> dataY = random(Shape<unsigned int>({4, 1}));
+
+	Layer<float> &output = outputDense(dense0(input));
+	SGD<float> optimizer(0.05f, 0.0f);
+
+	Model<float> forwardModel = Model<float>({&input}, {&output});
+	MeanSquareError mse_loss = MeanSquareError();
+	forwardModel.compile(&optimizer, mse_loss);
+
+	std::vector<Tensor<float> *> variables = dense0.getTrainableWeights().value();
+	const std::vector<Tensor<float> *> outputVariables = outputDense.getTrainableWeights().value();
+	variables.insert(variables.end(), outputVariables.begin(), outputVariables.end());
+
+	const auto copyVariables = [&]() {
+		std::vector<Tensor<float>> copies;
+		for (const Tensor<float> *variable : variables) {
+			copies.emplace_back(variable->getShape());
+			copies.back().assign(*variable);
+		}
+		return copies;
+	};
+	const std::vector<Tensor<float>> initial = copyVariables();
+
+	/*	Without momentum, the steps of each sample at a quarter of the learning rate, all from the initial weights,
+	 *	add up to the single step of the four accumulated samples.	*/
+	std::vector<Tensor<float>> expected = copyVariables();
+	optimizer.setLearningRate(0.05f / 4);
+	for (unsigned int sample = 0; sample < 4; sample++) {
+		Tensor<float> sampleX({1, 4});
+		Tensor<float> sampleY({1, 1});
+		for (unsigned int j = 0; j < 4; j++) {
+			sampleX.getValue(j) = dataX.getValue(sample * 4 + j);
+		}
+		sampleY.getValue(0) = dataY.getValue(sample);
+
+		for (size_t i = 0; i < variables.size(); i++) {
+			variables[i]->assign(initial[i]);
+		}
+		ASSERT_NO_THROW(forwardModel.fit(1, sampleX, sampleY, 1, 0, false, false));
+
+		for (size_t i = 0; i < variables.size(); i++) {
+			for (unsigned int j = 0; j < variables[i]->getNrElements(); j++) {
+				expected[i].getValue(j) += variables[i]->getValue(j) - initial[i].getValue(j);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < variables.size(); i++) {
+		variables[i]->assign(initial[i]);
+	}
+	optimizer.setLearningRate(0.05f);
+	ASSERT_NO_THROW(forwardModel.fit(1, dataX, dataY, 1, 0, false, false, {}, 4));
+
+	for (size_t i = 0; i < variables.size(); i++) {
+		for (unsigned int j = 0; j < variables[i]->getNrElements(); j++) {
+			ASSERT_NEAR(variables[i]->getValue(j), expected[i].getValue(j), 1e-5f);
+		}
+	}
+
+	EXPECT_THROW(forwardModel.fit(1, dataX, dataY, 1, 0, false, false, {}, 0), InvalidArgumentException);
+}
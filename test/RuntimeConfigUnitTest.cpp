@@ -0,0 +1,113 @@
+#include "Math.h"
+#include "core/CpuDispatch.h"
+#include "core/Initializers.h"
+#include "core/RuntimeConfig.h"
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <vector>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+using namespace Ritsu;
+
+TEST(RuntimeConfig, PolicyName) {
+	for (const NumaPolicy policy : {NumaPolicy::Default, NumaPolicy::Local, NumaPolicy::Interleave}) {
+		ASSERT_EQ(RuntimeConfig::parseNumaPolicy(RuntimeConfig::getNumaPolicyName(policy)), policy);
+	}
+	ASSERT_THROW(RuntimeConfig::parseNumaPolicy("membind"), InvalidArgumentException);
+}
+
+TEST(RuntimeConfig, FromEnvironment) {
+	setenv("RITSU_NUM_THREADS", "3", 1);
+	setenv("RITSU_PIN_THREADS", "1", 1);
+	setenv("RITSU_NUMA_WEIGHTS", "interleave", 1);
+	setenv("RITSU_NUMA_SCRATCH", "unknown", 1);
+
+	const RuntimeConfig config = RuntimeConfig::fromEnvironment();
+	EXPECT_EQ(config.nrThreads, 3u);
+	EXPECT_TRUE(config.pinThreads);
+	EXPECT_EQ(config.weightPolicy, NumaPolicy::Interleave);
+	EXPECT_EQ(config.scratchPolicy, NumaPolicy::Default);
+
+	unsetenv("RITSU_NUM_THREADS");
+	unsetenv("RITSU_PIN_THREADS");
+	unsetenv("RITSU_NUMA_WEIGHTS");
+	unsetenv("RITSU_NUMA_SCRATCH");
+
+	const RuntimeConfig defaults = RuntimeConfig::fromEnvironment();
+	EXPECT_EQ(defaults.nrThreads, 0u);
+	EXPECT_FALSE(defaults.pinThreads);
+	EXPECT_EQ(defaults.weightPolicy, NumaPolicy::Default);
+}
+
+TEST(RuntimeConfig, Apply) {
+	const RuntimeConfig previous = RuntimeConfig::getCurrent();
+	ASSERT_FALSE(RuntimeConfig::getAvailableCpus().empty());
+	ASSERT_GE(RuntimeConfig::getNrNumaNodes(), 1u);
+
+	RuntimeConfig config;
+	config.nrThreads = 2;
+	config.pinThreads = true;
+	config.weightPolicy = NumaPolicy::Interleave;
+	config.scratchPolicy = NumaPolicy::Local;
+	RuntimeConfig::apply(config);
+
+	EXPECT_EQ(CpuDispatch::getNrThreads(), 2u);
+	EXPECT_EQ(RuntimeConfig::getWeightPolicy(), NumaPolicy::Interleave);
+	EXPECT_EQ(RuntimeConfig::getScratchPolicy(), NumaPolicy::Local);
+	EXPECT_EQ(RuntimeConfig::getCurrent().nrThreads, 2u);
+
+#if defined(__linux__)
+	/*	The calling thread is pinned to the first available processor.	*/
+	cpu_set_t set;
+	ASSERT_EQ(sched_getaffinity(0, sizeof(set), &set), 0);
+	EXPECT_EQ(CPU_COUNT(&set), 1);
+	EXPECT_TRUE(CPU_ISSET(RuntimeConfig::getAvailableCpus()[0], &set));
+#endif
+
+	/*	Kernels and initializers give the same result with the weights interleaved.	*/
+	Tensor<float> weights(Shape<unsigned int>({512, 1024}));
+	RandomUniformInitializer<float>(-1.0f, 1.0f, 42)(weights);
+	Tensor<float> expected(Shape<unsigned int>({512, 1024}));
+	RandomUniformInitializer<float>(-1.0f, 1.0f, 42)(expected);
+	EXPECT_EQ(Math::sum<float>(weights.getRawData<float>(), weights.getNrElements()),
+			  Math::sum<float>(expected.getRawData<float>(), expected.getNrElements()));
+
+	RuntimeConfig::apply(previous);
+	EXPECT_EQ(RuntimeConfig::getWeightPolicy(), previous.weightPolicy);
+
+#if defined(__linux__)
+	ASSERT_EQ(sched_getaffinity(0, sizeof(set), &set), 0);
+	EXPECT_EQ(static_cast<size_t>(CPU_COUNT(&set)), RuntimeConfig::getAvailableCpus().size());
+#endif
+}
+
+TEST(RuntimeConfig, BindMemory) {
+	const size_t size = 4 * RuntimeConfig::MinBindSize;
+	std::vector<float> small(16);
+	std::vector<unsigned char> memory(size);
+
+	EXPECT_FALSE(RuntimeConfig::bindMemory(small.data(), small.size() * sizeof(float), NumaPolicy::Interleave));
+	EXPECT_FALSE(RuntimeConfig::bindMemory(memory.data(), size, NumaPolicy::Default));
+#if defined(__linux__)
+	/*	Not every kernel supports NUMA policies, the content must survive either way.	*/
+	for (size_t i = 0; i < size; i++) {
+		memory[i] = static_cast<unsigned char>(i);
+	}
+	RuntimeConfig::bindMemory(memory.data(), size, NumaPolicy::Interleave);
+	RuntimeConfig::bindMemory(memory.data(), size, NumaPolicy::Local);
+	for (size_t i = 0; i < size; i++) {
+		ASSERT_EQ(memory[i], static_cast<unsigned char>(i));
+	}
+#endif
+}
+
+TEST(RuntimeConfig, ZeroInitializerFirstTouch) {
+	Tensor<float> tensor(Shape<unsigned int>({300000}));
+	tensor.assignInitValue(5.0f);
+	ZeroInitializer<float>()(tensor);
+	for (size_t i = 0; i < tensor.getNrElements(); i++) {
+		ASSERT_EQ(tensor.getValue(i), 0.0f);
+	}
+}
@@ -354,4 +354,13 @@ REGISTER_TYPED_TEST_SUITE_P(ShapeType, DefaultConstructor, DimIndexOrder, SetGet
 							SubShape, Reduce, ComputeIndex, Append, Erase, Insert, Equality, MemoryIndexOrder);
 
 using ShapePrimitiveDataTypes = ::testing::Types<int16_t, uint16_t, int32_t, uint32_t, size_t, ssize_t>;
-INSTANTIATE_TYPED_TEST_SUITE_P(Shape, ShapeType, ShapePrimitiveDataTypes);
\ No newline at end of file
+INSTANTIATE_TYPED_TEST_SUITE_P(Shape, ShapeType, ShapePrimitiveDataTypes);
+#ifndef RITSU_32BIT_INDEX
+TEST(Shape, NrElementsBeyond32Bit) {
+	const Shape<uint32_t> shape({65540, 65536});
+
+	ASSERT_EQ(shape.getNrElements(), static_cast<SizeType>(65540) * 65536);
+	ASSERT_EQ(Shape<uint32_t>::computeIndex({65539, 65535}, shape), shape.getNrElements() - 1);
+	ASSERT_EQ(Shape<uint32_t>::computeIndex({0, 65535}, shape), static_cast<SizeType>(65535) * 65540);
+}
+#endif
@@ -0,0 +1,147 @@
+#include <Ritsu.h>
+#include <TensorPool.h>
+#include <cstdint>
+#include <gtest/gtest.h>
+
+using namespace Ritsu;
+
+class TensorPoolSizeClassTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(TensorPoolSizeClassTest, Values) {
+	const size_t size = GetParam();
+
+	const size_t sizeClass = TensorPool::getSizeClass(size);
+	const size_t classSize = TensorPool::getClassSize(sizeClass);
+
+	ASSERT_LT(sizeClass, TensorPool::NrSizeClasses);
+	EXPECT_GE(classSize, size);
+	EXPECT_EQ(classSize % TensorPool::BlockAlignment, 0);
+	/*	At most 25% larger, beyond the smallest classes.	*/
+	if (size > 256) {
+		EXPECT_LE(classSize, size + size / 4);
+	}
+	/*	Smallest class holding the size.	*/
+	if (sizeClass > 0) {
+		EXPECT_LT(TensorPool::getClassSize(sizeClass - 1), size);
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(TensorPool, TensorPoolSizeClassTest,
+						 ::testing::Values(1, 64, 65, 256, 257, 320, 321, 512, 513, 4000, 4096, 1000000,
+										   TensorPool::MaxBlockSize));
+
+TEST(TensorPool, RecycleBlock) {
+	TensorPool pool;
+
+	void *first = pool.allocate(1000, 32);
+	ASSERT_NE(first, nullptr);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(first) % TensorPool::BlockAlignment, 0);
+	pool.deallocate(first, 1000, 32);
+
+	/*	Same size class, served from the free list.	*/
+	void *second = pool.allocate(1020, 32);
+	EXPECT_EQ(first, second);
+
+	const MemoryAllocatorStatistics statistics = pool.getStatistics();
+	EXPECT_EQ(statistics.hits, 1);
+	EXPECT_EQ(statistics.misses, 1);
+	EXPECT_EQ(statistics.bytesInUse, TensorPool::getClassSize(TensorPool::getSizeClass(1000)));
+
+	pool.deallocate(second, 1020, 32);
+	EXPECT_EQ(pool.getStatistics().bytesInUse, 0);
+	EXPECT_GT(pool.getStatistics().bytesCached, 0);
+
+	pool.trim();
+	EXPECT_EQ(pool.getStatistics().bytesCached, 0);
+}
+
+TEST(TensorPool, LargeAllocationBypassPool) {
+	TensorPool pool(TensorPool::MaxBlockSize, MemoryAllocator::HugePageSize);
+
+	const size_t size = TensorPool::MaxBlockSize + 1;
+	void *memory = pool.allocate(size, 32);
+	ASSERT_NE(memory, nullptr);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(memory) % MemoryAllocator::HugePageSize, 0);
+	pool.deallocate(memory, size, 32);
+
+	const MemoryAllocatorStatistics statistics = pool.getStatistics();
+	EXPECT_EQ(statistics.hits, 0);
+	EXPECT_EQ(statistics.bytesCached, 0);
+	EXPECT_EQ(statistics.bytesInUse, 0);
+}
+
+TEST(TensorPool, TensorAllocateThroughDefault) {
+	TensorPool pool;
+	MemoryAllocator::setDefault(&pool);
+
+	{
+		Tensor<float> tensor({51});
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(tensor.getRawData()) % Tensor<float>::alignmentByte, 0);
+		EXPECT_GT(pool.getStatistics().bytesInUse, 0);
+
+		/*	Growing within the size class keeps the memory and its content.	*/
+		tensor.getValue(0) = 5.0f;
+		const float *data = tensor.getRawData();
+		tensor.concatenate(1.0f);
+		EXPECT_EQ(tensor.getRawData(), data);
+		EXPECT_FLOAT_EQ(tensor.getValue(0), 5.0f);
+	}
+	MemoryAllocator::setDefault(nullptr);
+
+	EXPECT_EQ(pool.getStatistics().bytesInUse, 0);
+	EXPECT_EQ(pool.getStatistics().misses, 1);
+	pool.trim();
+}
+
+TEST(ScopedArena, ReuseMemoryBetweenScopes) {
+	ArenaAllocator arena(4096);
+
+	Tensor<float> initA({256});
+	Tensor<float> initB({256});
+	const Tensor<float> &tensorA = initA.assignInitValue(1);
+	const Tensor<float> &tensorB = initB.assignInitValue(2);
+
+	const float *first = nullptr;
+	for (size_t i = 0; i < 4; i++) {
+		ScopedArena scope(arena);
+
+		const Tensor<float> result = tensorA - tensorB;
+		Tensor<float> second = result * tensorB;
+		EXPECT_FLOAT_EQ(second.getValue(0), -2.0f);
+
+		/*	Same memory every pass, once the arena has grown.	*/
+		if (i == 1) {
+			first = result.getRawData();
+		} else if (i > 1) {
+			EXPECT_EQ(result.getRawData(), first);
+		}
+		if (i == 0) {
+			arena.resetStatistics();
+		}
+	}
+
+	EXPECT_EQ(arena.getStatistics().misses, 0);
+	EXPECT_GT(arena.getStatistics().hits, 0);
+}
+
+TEST(ScopedArena, MoveIntoPersistentCopy) {
+	Tensor<float> persistent({128});
+	Tensor<float> init({128});
+	const Tensor<float> &tensorA = init.assignInitValue(3);
+
+	const float *data = persistent.getRawData();
+	{
+		ScopedArena scope;
+		persistent = tensorA * tensorA;
+
+		/*	Allocations of the scope do not outlive it.	*/
+		ScopedAllocator outside(nullptr);
+		Tensor<float> kept = tensorA * tensorA;
+		persistent += kept;
+	}
+
+	EXPECT_EQ(persistent.getRawData(), data);
+	for (unsigned int i = 0; i < persistent.getNrElements(); i++) {
+		EXPECT_FLOAT_EQ(persistent.getValue(i), 18.0f);
+	}
+}
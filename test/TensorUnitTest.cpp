@@ -1,7 +1,12 @@
 #include "RitsuDef.h"
 #include <Tensor.h>
+#include <array>
 #include <cstdint>
 #include <gtest/gtest.h>
+#include <limits>
+#if defined(__unix__)
+#include <sys/mman.h>
+#endif
 
 using namespace Ritsu;
 
@@ -250,6 +255,86 @@ TYPED_TEST_P(TensorTest, MatrixMultiplication) {
 		ASSERT_EQ(result0.getShape(), Shape<uint32_t>({6, 6}));
 		ASSERT_EQ(result0.getShape(), result1.getShape());
 	}
+
+	/*	Compare against a reference product, with sizes that are not a multiple of the blocking.	*/
+	const std::vector<std::array<uint32_t, 3>> sizes = {{67, 45, 131}, {5, 300, 270}, {130, 1, 300}, {1, 97, 33}};
+	for (const std::array<uint32_t, 3> &size : sizes) {
+		const uint32_t M = size[0];
+		const uint32_t N = size[1];
+		const uint32_t K = size[2];
+
+		Tensor<TypeParam> tensorA(Shape<uint32_t>({M, K}));
+		Tensor<TypeParam> tensorB(Shape<uint32_t>({K, N}));
+		for (uint32_t i = 0; i < tensorA.getNrElements(); i++) {
+			tensorA.template getValue<TypeParam>(i) = static_cast<TypeParam>(i % 7);
+		}
+		for (uint32_t i = 0; i < tensorB.getNrElements(); i++) {
+			tensorB.template getValue<TypeParam>(i) = static_cast<TypeParam>(i % 5);
+		}
+
+		const Tensor<TypeParam> result = Tensor<TypeParam>::matrixMultiply(tensorA, tensorB);
+		ASSERT_EQ(result.getShape(), Shape<uint32_t>({M, N}));
+
+		for (uint32_t i = 0; i < M; i++) {
+			for (uint32_t j = 0; j < N; j++) {
+				TypeParam expected = 0;
+				for (uint32_t k = 0; k < K; k++) {
+					expected += tensorA.template getValue<TypeParam>(k * M + i) *
+								tensorB.template getValue<TypeParam>(j * K + k);
+				}
+				ASSERT_EQ(result.template getValue<TypeParam>(i * N + j), expected);
+			}
+		}
+	}
+}
+
+TYPED_TEST_P(TensorTest, BatchMatrixMultiplication) {
+
+	const uint32_t batch = 5;
+	const uint32_t M = 19;
+	const uint32_t N = 23;
+	const uint32_t K = 37;
+
+	Tensor<TypeParam> tensorA(Shape<uint32_t>({batch, M, K}));
+	Tensor<TypeParam> tensorB(Shape<uint32_t>({batch, K, N}));
+	for (uint32_t i = 0; i < tensorA.getNrElements(); i++) {
+		tensorA.template getValue<TypeParam>(i) = static_cast<TypeParam>(i % 7);
+	}
+	for (uint32_t i = 0; i < tensorB.getNrElements(); i++) {
+		tensorB.template getValue<TypeParam>(i) = static_cast<TypeParam>(i % 5);
+	}
+
+	/*	[B, M, K] x [K, N], weight broadcast over the batch.	*/
+	{
+		const Tensor<TypeParam> weight = tensorB.getSubset({{0}}).reduce();
+		const Tensor<TypeParam> result = Tensor<TypeParam>::matrixMultiply(tensorA, weight);
+		ASSERT_EQ(result.getShape(), Shape<uint32_t>({batch, M, N}));
+
+		for (uint32_t b = 0; b < batch; b++) {
+			const Tensor<TypeParam> sliceA = tensorA.getSubset({{b}}).reduce();
+			const Tensor<TypeParam> expected = Tensor<TypeParam>::matrixMultiply(sliceA, weight);
+			ASSERT_EQ(result.getSubset({{b}}).reduce(), expected);
+		}
+	}
+
+	/*	[B, M, K] x [B, K, N]	*/
+	{
+		const Tensor<TypeParam> result = Tensor<TypeParam>::matrixMultiply(tensorA, tensorB);
+		ASSERT_EQ(result.getShape(), Shape<uint32_t>({batch, M, N}));
+
+		for (uint32_t b = 0; b < batch; b++) {
+			const Tensor<TypeParam> sliceA = tensorA.getSubset({{b}}).reduce();
+			const Tensor<TypeParam> sliceB = tensorB.getSubset({{b}}).reduce();
+			const Tensor<TypeParam> expected = Tensor<TypeParam>::matrixMultiply(sliceA, sliceB);
+			ASSERT_EQ(result.getSubset({{b}}).reduce(), expected);
+		}
+	}
+
+	/*	Mismatching batch dimensions.	*/
+	{
+		const Tensor<TypeParam> tensorC(Shape<uint32_t>({batch + 1, K, N}));
+		ASSERT_THROW(Tensor<TypeParam>::matrixMultiply(tensorA, tensorC), RuntimeException);
+	}
 }
 
 TYPED_TEST_P(TensorTest, ElementCount) {
@@ -359,6 +444,26 @@ TYPED_TEST_P(TensorTest, Mean) {
 		const Tensor<TypeParam> result = Tensor<TypeParam>::mean(tensor, 0);
 		ASSERT_EQ(result.getShape(), Shape<typename Tensor<TypeParam>::IndexType>({1, 28, 28, 1}));
 	}
+
+	/*	Inner and last axis.	*/
+	{
+		Tensor<TypeParam> tensor({6, 4, 3}, sizeof(TypeParam));
+		for (unsigned int i = 0; i < tensor.getNrElements(); i++) {
+			tensor.getValue(i) = static_cast<TypeParam>(i / 12);
+		}
+
+		const Tensor<TypeParam> inner = Tensor<TypeParam>::mean(tensor, 1);
+		ASSERT_EQ(inner.getShape(), Shape<typename Tensor<TypeParam>::IndexType>({6, 1, 3}));
+		for (unsigned int i = 0; i < inner.getNrElements(); i++) {
+			ASSERT_EQ(inner.getValue(i), static_cast<TypeParam>(i / 3));
+		}
+
+		const Tensor<TypeParam> last = Tensor<TypeParam>::mean(tensor, -1);
+		ASSERT_EQ(last.getShape(), Shape<typename Tensor<TypeParam>::IndexType>({6, 4, 1}));
+		for (unsigned int i = 0; i < last.getNrElements(); i++) {
+			ASSERT_EQ(last.getValue(i), static_cast<TypeParam>(i / 4));
+		}
+	}
 }
 
 TYPED_TEST_P(TensorTest, Sum) {
@@ -413,6 +518,34 @@ TYPED_TEST_P(TensorTest, Sum) {
 			ASSERT_EQ(result.getValue(i), static_cast<TypeParam>(16));
 		}
 	}
+
+	/*	Inner and last axis.	*/
+	{
+		Tensor<TypeParam> tensor({4, 3, 5}, sizeof(TypeParam));
+		tensor.assignInitValue(1);
+
+		const Tensor<TypeParam> inner = Tensor<TypeParam>::sum(tensor, 1);
+		ASSERT_EQ(inner.getShape(), Shape<typename Tensor<TypeParam>::IndexType>({4, 1, 5}));
+		for (unsigned int i = 0; i < inner.getNrElements(); i++) {
+			ASSERT_EQ(inner.getValue(i), static_cast<TypeParam>(3));
+		}
+
+		const Tensor<TypeParam> last = Tensor<TypeParam>::sum(tensor, -1);
+		ASSERT_EQ(last.getShape(), Shape<typename Tensor<TypeParam>::IndexType>({4, 3, 1}));
+		for (unsigned int i = 0; i < last.getNrElements(); i++) {
+			ASSERT_EQ(last.getValue(i), static_cast<TypeParam>(5));
+		}
+	}
+
+	/*	All elements of a single axis.	*/
+	{
+		Tensor<TypeParam> tensor({20}, sizeof(TypeParam));
+		tensor.assignInitValue(2);
+
+		const Tensor<TypeParam> result = Tensor<TypeParam>::sum(tensor, 0);
+		ASSERT_EQ(result.getShape(), Shape<typename Tensor<TypeParam>::IndexType>({1}));
+		ASSERT_EQ(result.getValue(0), static_cast<TypeParam>(40));
+	}
 }
 
 TYPED_TEST_P(TensorTest, Flatten) {
@@ -636,6 +769,121 @@ TYPED_TEST_P(TensorTest, AXPY) {
 	}
 }
 
+TYPED_TEST_P(TensorTest, LazyExpression) {
+
+	Tensor<TypeParam> tensorA(Shape<uint32_t>({12, 12, 1}));
+	Tensor<TypeParam> tensorB(Shape<uint32_t>({12, 12, 1}));
+
+	tensorA.assignInitValue(static_cast<TypeParam>(2));
+	tensorB.assignInitValue(static_cast<TypeParam>(1));
+
+	/*	Constructed from the expression.	*/
+	const Tensor<TypeParam> axpy = lazy(tensorA) * static_cast<TypeParam>(3) + tensorB;
+	ASSERT_EQ(axpy.getShape(), tensorA.getShape());
+
+	Tensor<TypeParam> result(Shape<uint32_t>({12, 12, 1}));
+	result = static_cast<TypeParam>(10) - lazy(tensorA) * lazy(tensorB);
+
+	Tensor<TypeParam> root(Shape<uint32_t>({12, 12, 1}));
+	root = (lazy(tensorA) * lazy(tensorA)).sqrt();
+
+	for (unsigned int i = 0; i < tensorA.getNrElements(); i++) {
+		ASSERT_EQ(axpy.getValue(i), static_cast<TypeParam>(7));
+		ASSERT_EQ(result.getValue(i), static_cast<TypeParam>(8));
+		ASSERT_EQ(root.getValue(i), static_cast<TypeParam>(2));
+		/*	Operands are left untouched.	*/
+		ASSERT_EQ(tensorA.getValue(i), static_cast<TypeParam>(2));
+	}
+
+	/*	Compound assignment.	*/
+	result += lazy(tensorB) * static_cast<TypeParam>(2);
+	ASSERT_EQ(result.getValue(0), static_cast<TypeParam>(10));
+}
+
+TYPED_TEST_P(TensorTest, LazyExpressionNoTemporary) {
+
+	Tensor<TypeParam> tensorA(Shape<uint32_t>({64, 64}));
+	Tensor<TypeParam> tensorB(Shape<uint32_t>({64, 64}));
+	Tensor<TypeParam> result(Shape<uint32_t>({64, 64}));
+
+	tensorA.assignInitValue(static_cast<TypeParam>(1));
+	tensorB.assignInitValue(static_cast<TypeParam>(2));
+
+	TensorAllocationCounter::reset();
+	result = (lazy(tensorA) * static_cast<TypeParam>(4) + tensorB) / (lazy(tensorB) + static_cast<TypeParam>(1));
+	result -= lazy(tensorA);
+
+	/*	Fused and evaluated into the existing buffer.	*/
+	EXPECT_EQ(TensorAllocationCounter::getCount(), 0);
+	EXPECT_EQ(result.getValue(0), static_cast<TypeParam>(1));
+}
+
+TYPED_TEST_P(TensorTest, Broadcast) {
+
+	Tensor<TypeParam> matrixValues(Shape<uint32_t>({4, 3}));
+	for (unsigned int i = 0; i < matrixValues.getNrElements(); i++) {
+		matrixValues.getValue(i) = static_cast<TypeParam>(i);
+	}
+	Tensor<TypeParam> columnValues(Shape<uint32_t>({4, 1}));
+	for (unsigned int i = 0; i < 4; i++) {
+		columnValues.getValue(i) = static_cast<TypeParam>(10 * i);
+	}
+
+	/*	Const operands, such that the operators do not compute in-place.	*/
+	const Tensor<TypeParam> &matrix = matrixValues;
+	const Tensor<TypeParam> &column = columnValues;
+	const Tensor<TypeParam> row = Tensor<TypeParam>::fromArray({1, 2, 3});
+	const Tensor<TypeParam> scalar = Tensor<TypeParam>::fromArray({2});
+
+	/*	Row, repeated for each of the 4 rows.	*/
+	Tensor<TypeParam> rowResult = matrix;
+	rowResult += row;
+	/*	Column, repeated for each of the 3 columns.	*/
+	const Tensor<TypeParam> columnResult = matrix - (-column);
+	/*	Scalar.	*/
+	const Tensor<TypeParam> scalarResult = matrix * scalar;
+
+	ASSERT_EQ(columnResult.getShape(), matrix.getShape());
+	for (unsigned int r = 0; r < 4; r++) {
+		for (unsigned int c = 0; c < 3; c++) {
+			const unsigned int i = r * 3 + c;
+			ASSERT_EQ(rowResult.getValue(i), static_cast<TypeParam>(i + c + 1));
+			ASSERT_EQ(columnResult.getValue(i), static_cast<TypeParam>(i + 10 * r));
+			ASSERT_EQ(scalarResult.getValue(i), static_cast<TypeParam>(i * 2));
+		}
+	}
+
+	/*	Both operands broadcast, [4, 1] x [3] => [4, 3].	*/
+	const Tensor<TypeParam> outer = column * row;
+	ASSERT_EQ(outer.getShape(), Shape<unsigned int>({4, 3}));
+	ASSERT_EQ(outer.getValue(3 * 3 + 2), static_cast<TypeParam>(90));
+
+	/*	The result of an in-place operation can not grow.	*/
+	Tensor<TypeParam> small = row;
+	ASSERT_THROW(small += matrix, InvalidArgumentException);
+	ASSERT_THROW(matrix * Tensor<TypeParam>(Shape<uint32_t>({2})), InvalidArgumentException);
+}
+
+TYPED_TEST_P(TensorTest, BroadcastComparison) {
+
+	Tensor<TypeParam> matrix(Shape<uint32_t>({2, 3}));
+	for (unsigned int i = 0; i < matrix.getNrElements(); i++) {
+		matrix.getValue(i) = static_cast<TypeParam>(i % 3);
+	}
+	const Tensor<TypeParam> row = Tensor<TypeParam>::fromArray({1, 1, 1});
+
+	const Tensor<TypeParam> equal = Tensor<TypeParam>::equal(matrix, row);
+	const Tensor<TypeParam> greater = Tensor<TypeParam>::greater(matrix, row);
+	const Tensor<TypeParam> less = Tensor<TypeParam>::less(matrix, row);
+
+	ASSERT_EQ(equal.getShape(), matrix.getShape());
+	for (unsigned int i = 0; i < matrix.getNrElements(); i++) {
+		ASSERT_EQ(equal.getValue(i), static_cast<TypeParam>(i % 3 == 1));
+		ASSERT_EQ(greater.getValue(i), static_cast<TypeParam>(i % 3 > 1));
+		ASSERT_EQ(less.getValue(i), static_cast<TypeParam>(i % 3 < 1));
+	}
+}
+
 TYPED_TEST_P(TensorTest, MemoryValidation) {
 
 	/*	*/
@@ -656,7 +904,133 @@ TYPED_TEST_P(TensorTest, MemoryValidation) {
 REGISTER_TYPED_TEST_SUITE_P(TensorTest, DefaultConstructor, DefaultType, PrintNoThrow, AssignMove, DataSize, Addition,
 							Subtract, MultiplyFactor, ElementCount, FromArray, SetGetValues, Max, Min, Log10, Mean, Sum,
 							Flatten, Transpose, InnerProduct, Append, Reduce, Reshape, Cast, SubSet,
-							MatrixMultiplication, Equal, NotEqual, Greater, Less, OneShot, AXPY, MemoryValidation);
+							MatrixMultiplication, BatchMatrixMultiplication, Equal, NotEqual, Greater, Less, OneShot, AXPY, LazyExpression,
+							LazyExpressionNoTemporary, Broadcast, BroadcastComparison, MemoryValidation);
 
 using TensorPrimitiveDataTypes = ::testing::Types<int16_t, uint16_t, int32_t, uint32_t, ssize_t, size_t, float, double>;
-INSTANTIATE_TYPED_TEST_SUITE_P(Tensor, TensorTest, TensorPrimitiveDataTypes);
\ No newline at end of file
+INSTANTIATE_TYPED_TEST_SUITE_P(Tensor, TensorTest, TensorPrimitiveDataTypes);
+TEST(TensorSharedBuffer, CopyOnWrite) {
+	Tensor<float> tensorA(Shape<unsigned int>({64}));
+	tensorA.assignInitValue(1.0f);
+	const float *data = static_cast<const Tensor<float> &>(tensorA).getRawData();
+
+	/*	Copy shares the memory.	*/
+	TensorAllocationCounter::reset();
+	Tensor<float> tensorB = tensorA;
+	std::vector<Tensor<float>> history(4, tensorA);
+	EXPECT_EQ(TensorAllocationCounter::getCount(), 0);
+	EXPECT_EQ(static_cast<const Tensor<float> &>(tensorB).getRawData(), data);
+
+	/*	The first write copies.	*/
+	tensorB.getValue(0) = 5.0f;
+	EXPECT_EQ(TensorAllocationCounter::getCount(), 1);
+	EXPECT_NE(static_cast<const Tensor<float> &>(tensorB).getRawData(), data);
+	EXPECT_FLOAT_EQ(tensorA.getValue(0), 1.0f);
+	EXPECT_FLOAT_EQ(tensorB.getValue(0), 5.0f);
+	EXPECT_FLOAT_EQ(history[3].getValue(0), 1.0f);
+}
+
+TEST(TensorSharedBuffer, ParallelWriteCopyOnce) {
+	Tensor<float> tensorA(Shape<unsigned int>({4096}));
+	tensorA.assignInitValue(1.0f);
+	Tensor<float> tensorB = tensorA;
+
+	TensorAllocationCounter::reset();
+#pragma omp parallel for
+	for (unsigned int i = 0; i < tensorB.getNrElements(); i++) {
+		tensorB.getValue(i) = static_cast<float>(i);
+	}
+
+	EXPECT_EQ(TensorAllocationCounter::getCount(), 1);
+	for (unsigned int i = 0; i < tensorA.getNrElements(); i++) {
+		ASSERT_FLOAT_EQ(tensorA.getValue(i), 1.0f);
+		ASSERT_FLOAT_EQ(tensorB.getValue(i), static_cast<float>(i));
+	}
+}
+
+TEST(TensorSharedBuffer, SubsetOutlivesParent) {
+	Tensor<float> subset;
+	{
+		Tensor<float> parent(Shape<unsigned int>({8, 4}));
+		for (unsigned int i = 0; i < parent.getNrElements(); i++) {
+			parent.getValue(i) = static_cast<float>(i);
+		}
+		subset = parent.getSubset({{2, 4}});
+
+		/*	A subset writes through to its parent, copies of the parent are thus not shared.	*/
+		const Tensor<float> copy = parent;
+		EXPECT_NE(copy.getRawData(), static_cast<const Tensor<float> &>(parent).getRawData());
+		subset.getValue(0) = -1.0f;
+		EXPECT_FLOAT_EQ(parent.getValue(8), -1.0f);
+		EXPECT_FLOAT_EQ(copy.getValue(8), 8.0f);
+	}
+
+	/*	Rows 2 to 4, inclusive.	*/
+	ASSERT_EQ(subset.getNrElements(), 12);
+	EXPECT_FLOAT_EQ(subset.getValue(0), -1.0f);
+	EXPECT_FLOAT_EQ(subset.getValue(11), 19.0f);
+}
+
+TEST(TensorSpan, ReadWrite) {
+	Tensor<float> tensor(Shape<unsigned int>({16, 16}));
+	const TensorSpan<float, 32> data = tensor.alignedSpan();
+
+	ASSERT_EQ(data.size(), tensor.getNrElements());
+	ASSERT_TRUE((TensorSpan<float, 32>::isAligned(data.data())));
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = static_cast<float>(i);
+	}
+	ASSERT_FLOAT_EQ(tensor.getValue(17), 17.0f);
+
+	/*	A read-only span does not detach shared memory.	*/
+	const Tensor<float> copy = tensor;
+	const TensorSpan<const float> view = copy.span();
+	ASSERT_EQ(view.data(), static_cast<const Tensor<float> &>(tensor).getRawData());
+
+	const TensorSpan<const float> row = view.subspan(16, 16);
+	float sum = 0;
+	for (const float value : row) {
+		sum += value;
+	}
+	ASSERT_FLOAT_EQ(sum, 16.0f * 16.0f + 120.0f);
+}
+
+#if !defined(RITSU_32BIT_INDEX) && defined(__unix__)
+TEST(TensorLargeIndex, BeyondUInt32Elements) {
+	/*	4 GiB of int8 data, backed by lazily committed memory, only the touched pages are resident.	*/
+	const std::vector<unsigned int> dims = {65540, 65536};
+	const size_t nrElements = static_cast<size_t>(dims[0]) * dims[1];
+
+	void *memory = mmap(nullptr, nrElements, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (memory == MAP_FAILED) {
+		GTEST_SKIP() << "Unable to reserve " << nrElements << " bytes of address space.";
+	}
+	uint8_t *base = static_cast<uint8_t *>(memory);
+
+	{
+		Tensor<int8_t> tensor(base, nrElements, dims);
+		ASSERT_GT(tensor.getNrElements(), std::numeric_limits<uint32_t>::max());
+		ASSERT_EQ(tensor.getNrElements(), nrElements);
+		ASSERT_EQ(tensor.getDatSize(), nrElements);
+
+		/*	Last element, by flat index and by multi index.	*/
+		tensor.getValue(nrElements - 1) = 7;
+		ASSERT_EQ(base[nrElements - 1], 7);
+		ASSERT_EQ(tensor.getValue({65539, 65535}), 7);
+
+		/*	Rows past the first 2^32 elements.	*/
+		const size_t rowOffset = static_cast<size_t>(65538) * dims[1];
+		Tensor<int8_t> rows = tensor.getSubset({{65538, 65539}});
+		ASSERT_EQ(rows.getNrElements(), static_cast<size_t>(2) * dims[1]);
+		ASSERT_EQ(static_cast<const Tensor<int8_t> &>(rows).getRawData(), reinterpret_cast<int8_t *>(&base[rowOffset]));
+
+		rows.getValue(0) = 3;
+		ASSERT_EQ(base[rowOffset], 3);
+
+		const Tensor<int8_t> range = tensor.getSubset(rowOffset, rowOffset + dims[1], Shape<unsigned int>({dims[1]}));
+		ASSERT_EQ(range.getValue(0), 3);
+	}
+
+	munmap(memory, nrElements);
+}
+#endif
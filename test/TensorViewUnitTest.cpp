@@ -0,0 +1,112 @@
+#include "RitsuDef.h"
+#include <Tensor.h>
+#include <TensorView.h>
+#include <gtest/gtest.h>
+
+using namespace Ritsu;
+
+static Tensor<float> createSequence(const Shape<unsigned int> &shape) {
+	Tensor<float> tensor(shape);
+	for (unsigned int i = 0; i < tensor.getNrElements(); i++) {
+		tensor.getValue(i) = static_cast<float>(i);
+	}
+	return tensor;
+}
+
+TEST(TensorView, TransposeZeroCopy) {
+	const Tensor<float> tensor = createSequence(Shape<unsigned int>({2, 3}));
+	const TensorView<float> view(tensor);
+	const TensorView<float> transposed = view.transpose();
+
+	ASSERT_TRUE(view.isContiguous());
+	ASSERT_FALSE(transposed.isContiguous());
+	ASSERT_EQ(transposed.getShape(), Shape<unsigned int>({3, 2}));
+	ASSERT_EQ(transposed.getRawData(), tensor.getRawData());
+
+	const Tensor<float> dense = transposed.contiguous();
+	for (unsigned int r = 0; r < 2; r++) {
+		for (unsigned int c = 0; c < 3; c++) {
+			ASSERT_FLOAT_EQ(transposed.getValue({c, r}), tensor.getValue(r * 3 + c));
+			ASSERT_FLOAT_EQ(dense.getValue(c * 2 + r), tensor.getValue(r * 3 + c));
+		}
+	}
+}
+
+TEST(TensorView, SliceAnyAxis) {
+	const Tensor<float> tensor = createSequence(Shape<unsigned int>({4, 6}));
+	const TensorView<float> view(tensor);
+
+	/*	Columns [2, 5) of every row.	*/
+	const TensorView<float> columns = view.slice(1, 2, 5);
+	ASSERT_EQ(columns.getShape(), Shape<unsigned int>({4, 3}));
+	ASSERT_FALSE(columns.isContiguous());
+
+	/*	Every second row.	*/
+	const TensorView<float> rows = view.slice(0, 0, 4, 2);
+	ASSERT_EQ(rows.getShape(), Shape<unsigned int>({2, 6}));
+
+	const Tensor<float> dense = columns.contiguous();
+	for (unsigned int r = 0; r < 4; r++) {
+		for (unsigned int c = 0; c < 3; c++) {
+			ASSERT_FLOAT_EQ(dense.getValue(r * 3 + c), static_cast<float>(r * 6 + c + 2));
+		}
+	}
+	ASSERT_FLOAT_EQ(rows.getValue({1, 3}), static_cast<float>(2 * 6 + 3));
+
+	ASSERT_THROW(view.slice(1, 4, 7), InvalidArgumentException);
+	ASSERT_THROW(view.slice(2, 0, 1), InvalidArgumentException);
+}
+
+TEST(TensorView, Permute) {
+	const Tensor<float> tensor = createSequence(Shape<unsigned int>({2, 3, 4}));
+	const TensorView<float> permuted = TensorView<float>(tensor).permute({2, 0, 1});
+
+	ASSERT_EQ(permuted.getShape(), Shape<unsigned int>({4, 2, 3}));
+	ASSERT_FLOAT_EQ(permuted.getValue({3, 1, 2}), tensor.getValue(1 * 12 + 2 * 4 + 3));
+	ASSERT_THROW(TensorView<float>(tensor).permute({0, 0, 1}), InvalidArgumentException);
+}
+
+TEST(TensorView, Reshape) {
+	const Tensor<float> tensor = createSequence(Shape<unsigned int>({4, 6}));
+	const TensorView<float> view(tensor);
+
+	const TensorView<float> reshaped = view.reshape(Shape<unsigned int>({3, 8}));
+	ASSERT_EQ(reshaped.getRawData(), tensor.getRawData());
+	ASSERT_FLOAT_EQ(reshaped.getValue({2, 1}), 17.0f);
+	ASSERT_EQ(view.flatten().getShape(), Shape<unsigned int>({24}));
+
+	ASSERT_THROW(view.transpose().reshape(Shape<unsigned int>({24})), RuntimeException);
+	ASSERT_NO_THROW(view.transpose().contiguous().reshape(Shape<unsigned int>({24})));
+}
+
+TEST(TensorView, TensorReshapeView) {
+	const Tensor<float> tensor = createSequence(Shape<unsigned int>({4, 6}));
+
+	const Tensor<float> reshaped = tensor.reshape(Shape<unsigned int>({6, 4}));
+	const Tensor<float> flat = tensor.flatten();
+
+	ASSERT_EQ(reshaped.getRawData(), tensor.getRawData());
+	ASSERT_EQ(flat.getRawData(), tensor.getRawData());
+	ASSERT_EQ(flat.getShape(), Shape<unsigned int>({24}));
+	ASSERT_EQ(tensor.getShape(), Shape<unsigned int>({4, 6}));
+}
+
+TEST(TensorView, MatrixMultiplyStrided) {
+	const Tensor<float> tensorA = createSequence(Shape<unsigned int>({4, 3}));
+	const Tensor<float> tensorB = createSequence(Shape<unsigned int>({4, 5}));
+
+	/*	A^T * B, without transposing A in memory.	*/
+	const Tensor<float> result =
+		TensorView<float>::matrixMultiply(TensorView<float>(tensorA).transpose(), TensorView<float>(tensorB));
+
+	ASSERT_EQ(result.getShape(), Shape<unsigned int>({3, 5}));
+	for (unsigned int i = 0; i < 3; i++) {
+		for (unsigned int j = 0; j < 5; j++) {
+			float expected = 0;
+			for (unsigned int k = 0; k < 4; k++) {
+				expected += tensorA.getValue(k * 3 + i) * tensorB.getValue(k * 5 + j);
+			}
+			ASSERT_FLOAT_EQ(result.getValue(i * 5 + j), expected);
+		}
+	}
+}
@@ -0,0 +1,154 @@
+#include "Math.h"
+#include "core/CpuDispatch.h"
+#include "core/Gemm.h"
+#include "core/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace Ritsu;
+
+class ThreadPoolTest : public ::testing::TestWithParam<unsigned int> {};
+
+TEST_P(ThreadPoolTest, ParallelForCoversRange) {
+	ThreadPool pool(GetParam());
+	ASSERT_EQ(pool.getNrThreads(), std::max(GetParam(), 1u));
+
+	for (const size_t nrElements : {0, 1, 7, 1000, 100003}) {
+		for (const size_t grain : {1, 3, 64, 100000}) {
+			std::vector<std::atomic<int>> visits(nrElements);
+			pool.parallelFor(nrElements, grain, [&](const size_t begin, const size_t end) {
+				/*	Without workers the whole range is a single call.	*/
+				EXPECT_TRUE(end - begin <= grain || pool.getNrThreads() == 1);
+				for (size_t i = begin; i < end; i++) {
+					visits[i].fetch_add(1);
+				}
+			});
+			for (size_t i = 0; i < nrElements; i++) {
+				ASSERT_EQ(visits[i].load(), 1) << nrElements << " " << grain << " " << i;
+			}
+		}
+	}
+}
+
+TEST_P(ThreadPoolTest, ParallelReduceIndependentOfThreads) {
+	const size_t nrElements = 1000003;
+	std::vector<float> values(nrElements);
+	for (size_t i = 0; i < nrElements; i++) {
+		values[i] = static_cast<float>((i * 2654435761u) % 1000) * 0.001f + 100.0f;
+	}
+	const auto sum = [&](const size_t begin, const size_t end) { return Math::sumRange<float>(values.data(), begin, end); };
+	const auto add = [](const float a, const float b) { return a + b; };
+
+	ThreadPool serial(1);
+	ThreadPool pool(GetParam());
+	EXPECT_EQ(pool.parallelReduce<float>(nrElements, 4096, sum, add),
+			  serial.parallelReduce<float>(nrElements, 4096, sum, add));
+}
+
+TEST_P(ThreadPoolTest, NestedTaskGroups) {
+	ThreadPool pool(GetParam());
+	std::atomic<int> count{0};
+
+	TaskGroup outer(pool);
+	for (int i = 0; i < 8; i++) {
+		outer.run([&]() {
+			/*	A parallel loop inside a task waits on its own group.	*/
+			pool.parallelFor(64, 1, [&](const size_t begin, const size_t end) {
+				count.fetch_add(static_cast<int>(end - begin));
+			});
+		});
+	}
+	outer.wait();
+
+	EXPECT_EQ(count.load(), 8 * 64);
+}
+
+TEST_P(ThreadPoolTest, TaskGroupException) {
+	ThreadPool pool(GetParam());
+	std::atomic<int> count{0};
+
+	TaskGroup group(pool);
+	for (int i = 0; i < 16; i++) {
+		group.run([&, i]() {
+			count.fetch_add(1);
+			if (i == 5) {
+				throw std::runtime_error("task failed");
+			}
+		});
+	}
+	EXPECT_THROW(group.wait(), std::runtime_error);
+	EXPECT_EQ(count.load(), 16);
+
+	/*	The exception is only rethrown once.	*/
+	group.run([&]() { count.fetch_add(1); });
+	EXPECT_NO_THROW(group.wait());
+	EXPECT_EQ(count.load(), 17);
+}
+
+INSTANTIATE_TEST_SUITE_P(ThreadPool, ThreadPoolTest, ::testing::Values(0u, 1u, 2u, 3u, 8u));
+
+TEST(ThreadPool, Submit) {
+	ThreadPool pool(4);
+	std::atomic<int> count{0};
+	for (int i = 0; i < 100; i++) {
+		pool.submit([&]() { count.fetch_add(1); });
+	}
+	while (pool.runPendingTask()) {
+	}
+	while (count.load() != 100) {
+		std::this_thread::yield();
+	}
+	EXPECT_FALSE(ThreadPool::isWorkerThread());
+}
+
+TEST(ThreadPool, CpuDispatchSharedPool) {
+	const size_t nrElements = 100003;
+	std::vector<float> values(nrElements);
+	for (size_t i = 0; i < nrElements; i++) {
+		values[i] = static_cast<float>(static_cast<int>(i * 7919 % 2003) - 1001) / 97.0f;
+	}
+
+	CpuDispatch::setParallelThreshold(std::numeric_limits<size_t>::max());
+	const float expectedSum = Math::sum<float>(values.data(), nrElements);
+
+	/*	Product large enough to be split over the threads.	*/
+	const size_t M = 96, N = 80, K = 70;
+	std::vector<float> A(M * K), B(K * N), expectedC(M * N), C(M * N);
+	for (size_t i = 0; i < A.size(); i++) {
+		A[i] = static_cast<float>(i % 13) - 6.0f;
+	}
+	for (size_t i = 0; i < B.size(); i++) {
+		B[i] = static_cast<float>(i % 7) - 3.0f;
+	}
+	Gemm::gemm<float>(M, N, K, 1.0f, A.data(), K, 1, B.data(), N, 1, 0.0f, expectedC.data(), N, 1);
+
+	/*	The application shares its pool with the kernels.	*/
+	const std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(4);
+	CpuDispatch::setThreadPool(pool);
+	ASSERT_EQ(CpuDispatch::getThreadPool(), pool.get());
+	ASSERT_EQ(CpuDispatch::getNrThreads(), 4u);
+
+	CpuDispatch::setParallelThreshold(1);
+	EXPECT_EQ(CpuDispatch::getPath(nrElements), ExecutionPath::Threaded);
+	EXPECT_EQ(Math::sum<float>(values.data(), nrElements), expectedSum);
+
+	Gemm::gemm<float>(M, N, K, 1.0f, A.data(), K, 1, B.data(), N, 1, 0.0f, C.data(), N, 1);
+	EXPECT_EQ(C, expectedC);
+
+	/*	Kernels called from a task of the pool run nested on the same pool.	*/
+	float nestedSum = 0;
+	TaskGroup group(*pool);
+	group.run([&]() { nestedSum = Math::sum<float>(values.data(), nrElements); });
+	group.wait();
+	EXPECT_EQ(nestedSum, expectedSum);
+
+	CpuDispatch::setThreadPool(nullptr);
+	CpuDispatch::resetParallelThreshold();
+	EXPECT_NE(CpuDispatch::getThreadPool(), pool.get());
+}
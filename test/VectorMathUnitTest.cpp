@@ -0,0 +1,161 @@
+#include "Activations.h"
+#include "core/CpuDispatch.h"
+#include "core/VectorMath.h"
+#include <cmath>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <limits>
+#include <vector>
+
+using namespace Ritsu;
+
+/*	Error of a single precision result in units in the last place of the correctly rounded reference.	*/
+static double ulpError(const float result, const double reference) {
+	const float rounded = static_cast<float>(reference);
+	if (std::isnan(reference) || std::isinf(rounded)) {
+		return (std::isnan(reference) && std::isnan(result)) || result == rounded ? 0 : std::numeric_limits<double>::infinity();
+	}
+	const float magnitude = std::fabs(rounded);
+	const double ulp = static_cast<double>(std::nextafter(magnitude, std::numeric_limits<float>::infinity())) - magnitude;
+	return std::fabs(static_cast<double>(result) - reference) / ulp;
+}
+
+enum class Function { Exp, Log, Log10, Tanh, Sigmoid };
+
+class VectorMathTest : public ::testing::TestWithParam<std::tuple<Function, double, double>> {};
+
+TEST_P(VectorMathTest, MaxULP) {
+	auto [function, fastMaxULP, maxULP] = GetParam();
+#ifdef RITSU_FAST_MATH
+	maxULP = fastMaxULP;
+#endif
+
+	/*	Every 4099th bit pattern, all exponents with a spread of mantissas.	*/
+	std::vector<float> values;
+	for (uint64_t bits = 0; bits < (1ull << 32); bits += 4099) {
+		const uint32_t pattern = static_cast<uint32_t>(bits);
+		float value;
+		std::memcpy(&value, &pattern, sizeof(value));
+#ifdef RITSU_FAST_MATH
+		/*	The fast version only covers positive normal numbers and arguments that do not over or underflow.	*/
+		const bool isLog = function == Function::Log || function == Function::Log10;
+		if (isLog ? !(value >= std::numeric_limits<float>::min() && value <= std::numeric_limits<float>::max())
+				  : !(value >= -87.0f && value <= 87.0f)) {
+			continue;
+		}
+#endif
+		values.push_back(value);
+	}
+
+	std::vector<float> result(values.size());
+	const size_t nrElements = values.size();
+	CpuDispatch::invoke([&]() {
+#pragma omp simd
+		for (size_t i = 0; i < nrElements; i++) {
+			switch (function) {
+			case Function::Exp:
+				result[i] = VectorMath::exp<float>(values[i]);
+				break;
+			case Function::Log:
+				result[i] = VectorMath::log<float>(values[i]);
+				break;
+			case Function::Log10:
+				result[i] = VectorMath::log10<float>(values[i]);
+				break;
+			case Function::Tanh:
+				result[i] = VectorMath::tanh<float>(values[i]);
+				break;
+			case Function::Sigmoid:
+				result[i] = VectorMath::sigmoid<float>(values[i]);
+				break;
+			}
+		}
+	});
+
+	for (size_t i = 0; i < nrElements; i++) {
+		const double x = values[i];
+		double reference = 0;
+		switch (function) {
+		case Function::Exp:
+			reference = std::exp(x);
+			break;
+		case Function::Log:
+			reference = std::log(x);
+			break;
+		case Function::Log10:
+			reference = std::log10(x);
+			break;
+		case Function::Tanh:
+			reference = std::tanh(x);
+			break;
+		case Function::Sigmoid:
+			reference = 1.0 / (1.0 + std::exp(-x));
+			break;
+		}
+#ifdef RITSU_FAST_MATH
+		if (std::fabs(reference) < std::numeric_limits<float>::min()) {
+			continue;
+		}
+#endif
+		ASSERT_LE(ulpError(result[i], reference), maxULP) << "x = " << values[i] << ", result = " << result[i];
+	}
+}
+
+INSTANTIATE_TEST_SUITE_P(VectorMath, VectorMathTest,
+						 ::testing::Values(std::make_tuple(Function::Exp, 6.5, 1.5),
+										   std::make_tuple(Function::Log, 100.0, 1.0),
+										   std::make_tuple(Function::Log10, 100.0, 2.5),
+										   std::make_tuple(Function::Tanh, 3.0, 1.5),
+										   std::make_tuple(Function::Sigmoid, 7.5, 2.5)));
+
+#ifndef RITSU_FAST_MATH
+TEST(VectorMath, SpecialValues) {
+	const float infinity = std::numeric_limits<float>::infinity();
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	const float denormal = std::numeric_limits<float>::denorm_min();
+
+	EXPECT_EQ(VectorMath::exp<float>(0.0f), 1.0f);
+	EXPECT_EQ(VectorMath::exp<float>(infinity), infinity);
+	EXPECT_EQ(VectorMath::exp<float>(-infinity), 0.0f);
+	EXPECT_EQ(VectorMath::exp<float>(89.0f), infinity);
+	EXPECT_EQ(VectorMath::exp<float>(-104.0f), 0.0f);
+	EXPECT_GT(VectorMath::exp<float>(-100.0f), 0.0f);
+	EXPECT_TRUE(std::isnan(VectorMath::exp<float>(nan)));
+
+	EXPECT_EQ(VectorMath::log<float>(1.0f), 0.0f);
+	EXPECT_EQ(VectorMath::log<float>(0.0f), -infinity);
+	EXPECT_EQ(VectorMath::log<float>(-0.0f), -infinity);
+	EXPECT_EQ(VectorMath::log<float>(infinity), infinity);
+	EXPECT_TRUE(std::isnan(VectorMath::log<float>(-1.0f)));
+	EXPECT_TRUE(std::isnan(VectorMath::log<float>(-infinity)));
+	EXPECT_TRUE(std::isnan(VectorMath::log<float>(nan)));
+	EXPECT_FLOAT_EQ(VectorMath::log<float>(denormal), std::log(denormal));
+	EXPECT_EQ(VectorMath::log10<float>(0.0f), -infinity);
+
+	EXPECT_EQ(VectorMath::tanh<float>(0.0f), 0.0f);
+	EXPECT_EQ(VectorMath::tanh<float>(infinity), 1.0f);
+	EXPECT_EQ(VectorMath::tanh<float>(-infinity), -1.0f);
+	EXPECT_TRUE(std::isnan(VectorMath::tanh<float>(nan)));
+
+	EXPECT_EQ(VectorMath::sigmoid<float>(0.0f), 0.5f);
+	EXPECT_EQ(VectorMath::sigmoid<float>(infinity), 1.0f);
+	EXPECT_EQ(VectorMath::sigmoid<float>(-infinity), 0.0f);
+	EXPECT_GT(VectorMath::sigmoid<float>(-100.0f), 0.0f);
+	EXPECT_TRUE(std::isnan(VectorMath::sigmoid<float>(nan)));
+}
+#endif
+
+TEST(VectorMath, Double) {
+	for (double x = -20.0; x <= 20.0; x += 0.37) {
+		EXPECT_DOUBLE_EQ(VectorMath::exp<double>(x), std::exp(x));
+		EXPECT_DOUBLE_EQ(VectorMath::tanh<double>(x), std::tanh(x));
+		EXPECT_DOUBLE_EQ(VectorMath::sigmoid<double>(x), 1.0 / (1.0 + std::exp(-x)));
+	}
+}
+
+TEST(VectorMath, TanhDerivative) {
+	for (float x = -10.0f; x <= 10.0f; x += 0.1f) {
+		const float tanh = VectorMath::tanh<float>(x);
+		EXPECT_FLOAT_EQ(computeTanhDerivative<float>(x), 1.0f - tanh * tanh);
+	}
+}